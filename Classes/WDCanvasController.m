@@ -482,6 +482,10 @@
                                   action:@selector(deleteAnchors:) target:self];
         [menus addObject:item];
         
+        item = [WDMenuItem itemWithTitle:NSLocalizedString(@"Reduce Anchor Points", @"Reduce Anchor Points")
+                                  action:@selector(reduceNodes:) target:self];
+        [menus addObject:item];
+        
         item = [WDMenuItem itemWithTitle:NSLocalizedString(@"Join Paths", @"Join Paths")
                                   action:@selector(joinPaths:) target:self];
         [menus addObject:item];
@@ -686,6 +690,8 @@
         item.enabled = [dc canReleaseCompoundPath];
     } else if (item.action == @selector(reversePathDirection:)) {
         item.enabled = [dc canReversePathDirection];
+    } else if (item.action == @selector(reduceNodes:)) {
+        item.enabled = [dc canReduceNodes];
     } else if (item.action == @selector(outlineStroke:)) {
         item.enabled = [dc canOutlineStroke];
     } else if (item.action == @selector(makeMask:)) {
@@ -83,6 +83,8 @@
 - (void) addAnchors:(id)sender;
 - (void) deleteAnchors:(id)sender;
 - (void) reversePathDirection:(id)sender;
+- (void) reduceNodes:(id)sender;
+- (void) reduceNodesWithTolerance:(float)tolerance; // in document points
 - (void) outlineStroke:(id)sender;
 - (void) joinPaths:(id)sender;
 - (void) setActivePath:(WDPath *)path;
@@ -169,6 +171,7 @@
 - (BOOL) canAddAnchors;
 - (BOOL) canDeleteAnchors;
 - (BOOL) canReversePathDirection;
+- (BOOL) canReduceNodes;
 - (BOOL) canOutlineStroke;
 - (BOOL) canCreateTextOutlines;
 - (BOOL) canPlaceTextOnPath;
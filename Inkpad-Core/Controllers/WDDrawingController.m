@@ -20,6 +20,7 @@
 #import "WDBezierNode.h"
 #import "WDColor.h"
 #import "WDCompoundPath.h"
+#import "WDCurveFit.h"
 #import "WDDrawing.h"
 #import "WDDrawingController.h"
 #import "WDFontManager.h"
@@ -35,6 +36,7 @@
 #import "WDUtilities.h"
 
 const float kDuplicateOffset = 20.0f;
+const float kReduceNodesTolerance = 0.5f;
 
 NSString *WDPasteboardDataType = @"WDPasteboardDataType";
 NSString *WDSelectionChangedNotification = @"WDSelectionChangedNotification";
@@ -799,6 +801,30 @@ NSString *WDSelectionChangedNotification = @"WDSelectionChangedNotification";
     [self.selectedPaths makeObjectsPerformSelector:@selector(reversePathDirection)];
 }
 
+- (void) reduceNodes:(id)sender
+{
+    [self reduceNodesWithTolerance:kReduceNodesTolerance];
+}
+
+- (void) reduceNodesWithTolerance:(float)tolerance
+{
+    NSMutableArray *paths = [NSMutableArray array];
+    
+    // be sure to end any active path editing
+    self.activePath = nil;
+    
+    // gather the subpaths too, so that all the paths are reduced concurrently
+    for (WDElement *element in self.selectedObjects) {
+        if ([element isKindOfClass:[WDPath class]]) {
+            [paths addObject:element];
+        } else if ([element isKindOfClass:[WDCompoundPath class]]) {
+            [paths addObjectsFromArray:((WDCompoundPath *) element).subpaths];
+        }
+    }
+    
+    [WDCurveFit reduceNodesOfPaths:paths tolerance:tolerance];
+}
+
 - (void) outlineStroke:(id)sender
 {
     NSMutableArray *newSelection = [NSMutableArray array];
@@ -1119,8 +1145,27 @@ NSString *WDSelectionChangedNotification = @"WDSelectionChangedNotification";
         }
     }
     
+    // the paths erased by subtraction go through WDPathfinder in one batch, sharing the converted eraser
+    NSMutableArray *subtracted = [NSMutableArray array];
+    
+    for (WDAbstractPath *ap in objectsToErase) {
+        if ([ap erasesWithPathfinder]) {
+            [subtracted addObject:ap];
+        }
+    }
+    
+    NSArray     *differences = [WDPathfinder erasePaths:subtracted withPath:erasePath];
+    NSUInteger  differenceIx = 0;
+    
     for (WDAbstractPath *ap in objectsToErase) {
-        NSArray *result = [ap erase:erasePath];
+        NSArray *result;
+        
+        if ([ap erasesWithPathfinder]) {
+            id difference = differences[differenceIx++];
+            result = [ap eraseResult:(difference == [NSNull null]) ? nil : difference];
+        } else {
+            result = [ap erase:erasePath];
+        }
         
         // if there's anything left, add it to the layer
         if (result) {
@@ -2046,6 +2091,17 @@ NSString *WDSelectionChangedNotification = @"WDSelectionChangedNotification";
     return NO;
 }
 
+- (BOOL) canReduceNodes
+{
+    for (WDElement *element in selectedObjects_) {
+        if ([element isKindOfClass:[WDPath class]] || [element isKindOfClass:[WDCompoundPath class]]) {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
 - (BOOL) canOutlineStroke
 {
     for (WDElement *element in [self orderedSelectedObjects]) {
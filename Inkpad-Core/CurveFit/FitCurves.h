@@ -12,3 +12,34 @@
 #import "WDBezierSegment.h"
 
 int FitCurve(WDBezierSegment *segments, CGPoint *digitizedPts, int nPts, double error);
+// splits the points at the corners sharper than cornerAngle (in radians, M_PI for none) and fits the spans
+// between them concurrently, with the one-sided tangents at the corners; segments needs room for nPts - 1
+int FitCurveAtCorners(WDBezierSegment *segments, CGPoint *digitizedPts, int nPts, double error, double cornerAngle);
+
+// replaces the count segments of a path (a closed one ends where it starts) by as few as it takes to stay
+// within tolerance of it (Hausdorff distance), refitting the runs between the corners; returns the new
+// count, with the segments in *reduced for the caller to free (a closed path may start at another node)
+int ReduceSegments(const WDBezierSegment *segments, int count, BOOL closed, double tolerance, WDBezierSegment **reduced);
+
+// incremental fit of points that arrive one at a time: the points after the last frozen segment (the
+// tail) are fitted with one segment, extended to each new point; when a point can't be taken, the fit
+// up to the previous point is frozen and a new tail starts there, so each point costs a fit of the tail;
+// a tail that grows to 256 points is split and its first part frozen, which bounds that cost
+typedef struct {
+    double          error;
+    CGPoint         *pts;
+    int             nPts, maxPts;
+    WDBezierSegment *segments;  // the frozen segments, followed by the fit of the tail
+    int             *ends;      // index in pts of the last point of each segment
+    int             nFrozen, nSegments, maxSegments;
+    CGPoint         tailTangent; // unit tangent at the start of the tail, once a segment is frozen
+    double          *scratch;   // parameters of the points being fitted
+    int             maxScratch;
+} FitCurveStream;
+
+void FitCurveStreamInit(FitCurveStream *stream, double error);
+void FitCurveStreamFree(FitCurveStream *stream);
+// returns the number of segments frozen by this point
+int FitCurveStreamAddPoint(FitCurveStream *stream, CGPoint pt);
+// fits the tail again (with as many segments as it takes), after a change to its points
+void FitCurveStreamRefit(FitCurveStream *stream);
@@ -25,92 +25,692 @@ typedef struct {
 } BezierCurve;
 
 // forward declarations
-static int          FitCubic();
-static double *     Reparameterize();
-static double       NewtonRaphsonRootFind();
-static CGPoint      BezierII();
-static double       B0(), B1(), B2(), B3();
-static CGPoint      ComputeLeftTangent(), ComputeRightTangent(), ComputeCenterTangent();
-static double       ComputeMaxError();
-static double *     ChordLengthParameterize();
-static BezierCurve  GenerateBezier();
-static  double      V2SquaredLength(), V2Dot();
-static  void        AddBezierSegment();
+static int          FitCubic(WDBezierSegment *segments, int *ends, CGPoint *d, int first, int last, CGPoint tHat1, CGPoint tHat2,
+                             double error, int segCount, double *scratch);
+static BOOL         FitSingleCubic(CGPoint *d, int first, int last, CGPoint tHat1, CGPoint tHat2, double error,
+                                   BezierCurve *bezCurve, int *splitPoint, double *scratch);
+static void         Reparameterize(CGPoint *d, int first, int last, double *u, BezierCurve bezCurve, double *uPrime);
+static double       NewtonRaphsonRootFind(BezierCurve Q, CGPoint P, double u);
+static CGPoint      BezierII(int degree, CGPoint *V, double t);
+static double       B0(double u), B1(double u), B2(double u), B3(double u);
+static CGPoint      ComputeLeftTangent(CGPoint *d, int end), ComputeRightTangent(CGPoint *d, int end), ComputeCenterTangent(CGPoint *d, int center);
+static double       ComputeMaxError(CGPoint *d, int first, int last, BezierCurve bezCurve, double *u, int *splitPoint);
+static void         ChordLengthParameterize(CGPoint *d, int first, int last, double *u);
+static BezierCurve  GenerateBezier(CGPoint *d, int first, int last, double *uPrime, CGPoint tHat1, CGPoint tHat2);
+static  double      V2SquaredLength(CGPoint a), V2Dot(CGPoint a, CGPoint b);
+static  void        AddBezierSegment(WDBezierSegment *segments, int *ends, BezierCurve curve, int last, int ix);
 
 //  FitCurve : Fit a Bezier curve to a set of digitized points
 //
 int FitCurve(WDBezierSegment *segments, CGPoint *d, int nPts, double error)
 {
     CGPoint tHat1, tHat2; // Unit tangent vectors at endpoints
+    double  *scratch = malloc(2 * nPts * sizeof(double));
+    int     segCount;
     
     tHat1 = ComputeLeftTangent(d, 0);
     tHat2 = ComputeRightTangent(d, nPts - 1);
-    return FitCubic(segments, d, 0, nPts - 1, tHat1, tHat2, error, 0);
+    segCount = FitCubic(segments, NULL, d, 0, nPts - 1, tHat1, tHat2, error, 0, scratch);
+    
+    free(scratch);
+    return segCount;
+}
+
+//  FindCorners : Find the points where the digitized curve turns by more than cornerAngle, measured
+//  between the directions to the points about reach away on either side; returns the number of corners
+//
+static int FindCorners(CGPoint *d, int nPts, double reach, double cornerAngle, int *corners)
+{
+    double  cosCorner = cos(cornerAngle);
+    double  sharpest = 0;
+    int     nCorners = 0, candidate = -1, a = 0, b = 0;
+    
+    for (int i = 1; i < nPts - 1; i++) {
+        // a and b only move forward, so the whole pass is linear
+        while (a + 1 < i && WDDistance(d[a + 1], d[i]) >= reach) {
+            a++;
+        }
+        if (b <= i) {
+            b = i + 1;
+        }
+        while (b < nPts - 1 && WDDistance(d[b], d[i]) < reach) {
+            b++;
+        }
+        
+        BOOL    isCandidate = NO;
+        double  sharpness = 0;
+        
+        if (WDDistance(d[a], d[i]) >= reach && WDDistance(d[b], d[i]) >= reach) {
+            double cosTurn = V2Dot(WDNormalizePoint(WDSubtractPoints(d[i], d[a])), WDNormalizePoint(WDSubtractPoints(d[b], d[i])));
+            
+            isCandidate = (cosTurn < cosCorner);
+            sharpness = -cosTurn;
+        }
+        
+        // a run of candidates makes one corner, at its sharpest point
+        if (isCandidate && (candidate < 0 || sharpness > sharpest)) {
+            candidate = i;
+            sharpest = sharpness;
+        } else if (!isCandidate && candidate >= 0) {
+            corners[nCorners++] = candidate;
+            candidate = -1;
+        }
+    }
+    
+    if (candidate >= 0) {
+        corners[nCorners++] = candidate;
+    }
+    
+    return nCorners;
+}
+
+//  FitCurveAtCorners : Fit the spans between corners independently, and concurrently
+//
+int FitCurveAtCorners(WDBezierSegment *segments, CGPoint *d, int nPts, double error, double cornerAngle)
+{
+    if (nPts < 2) {
+        return 0;
+    }
+    
+    // the spans are delimited by the ends and the corners
+    int     *bounds = malloc((nPts + 1) * sizeof(int));
+    int     nSpans = 0;
+    
+    bounds[0] = 0;
+    if (cornerAngle < M_PI) {
+        nSpans = FindCorners(d, nPts, 2 * sqrt(error), cornerAngle, bounds + 1);
+    }
+    bounds[++nSpans] = nPts - 1;
+    
+    // a span fits into at most one segment per point interval, so each one writes its segments from
+    // the index of its first point; each one also gets its own part of the scratch
+    int     *counts = malloc(nSpans * sizeof(int));
+    double  *scratch = malloc(2 * (nPts + nSpans) * sizeof(double));
+    
+    dispatch_apply(nSpans, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t s) {
+        int first = bounds[s], last = bounds[s + 1];
+        
+        counts[s] = FitCubic(segments + first, NULL, d, first, last, ComputeLeftTangent(d, first), ComputeRightTangent(d, last),
+                             error, 0, scratch + 2 * (first + s));
+    });
+    
+    // gather the segments of the spans, in order
+    int segCount = 0;
+    for (int s = 0; s < nSpans; s++) {
+        memmove(segments + segCount, segments + bounds[s], counts[s] * sizeof(WDBezierSegment));
+        segCount += counts[s];
+    }
+    
+    free(scratch);
+    free(counts);
+    free(bounds);
+    
+    return segCount;
+}
+
+//  FitGreedy : Fit Bezier curves to digitized points, each one as long as it can be within error
+//
+//  Where FitCubic splits at the point of max error, this grows each curve from the end of the last
+//  one, doubling its span until a fit fails and then bisecting between the spans that fit and fail;
+//  it takes fewer segments on long runs, for about log(nPts) fits per segment
+//
+static int FitGreedy(WDBezierSegment *segments, int *ends, CGPoint *d, int nPts, CGPoint tHat1, CGPoint tHat2,
+                     double error, double *scratch)
+{
+    BezierCurve bezCurve, fitted;
+    int         splitPoint, segCount = 0, first = 0;
+    
+    while (first < nPts - 1) {
+        int good = first + 1, bad = nPts, last = first + 1, step = 1;
+        
+        // two points always fit
+        FitSingleCubic(d, first, good, tHat1, (good == nPts - 1) ? tHat2 : ComputeCenterTangent(d, good),
+                       error, &fitted, &splitPoint, scratch);
+        
+        while (bad - good > 1) {
+            last = (bad == nPts && good + step < nPts) ? good + step : (good + bad) / 2;
+            step *= 2;
+            
+            CGPoint tHatEnd = (last == nPts - 1) ? tHat2 : ComputeCenterTangent(d, last);
+            if (FitSingleCubic(d, first, last, tHat1, tHatEnd, error, &bezCurve, &splitPoint, scratch)) {
+                good = last;
+                fitted = bezCurve;
+            } else {
+                bad = last;
+            }
+        }
+        
+        AddBezierSegment(segments, ends, fitted, good, segCount++);
+        tHat1 = (good == nPts - 1) ? tHat2 : WDMultiplyPointScalar(ComputeCenterTangent(d, good), -1);
+        first = good;
+    }
+    
+    return segCount;
+}
+
+//  ReduceSegments : Replace the segments of a path by as few as it takes to stay within tolerance of it
+//
+#define kReduceCornerAngle      (M_PI / 6)  // nodes that turn more than this are kept
+#define kReduceAttempts         3           // fits tried per run, halving the error each time
+#define kReduceCheckDepth       12          // halvings of an edge before the tolerance check gives up on it
+
+//  StartTangent, EndTangent : Unit tangents at the ends of seg, pointing into it (zero if it's a point)
+//
+static CGPoint StartTangent(WDBezierSegment seg)
+{
+    CGPoint tHat = WDSubtractPoints(seg.out_, seg.a_);
+    
+    if (V2SquaredLength(tHat) == 0.0) {
+        tHat = WDSubtractPoints(seg.in_, seg.a_);
+    }
+    if (V2SquaredLength(tHat) == 0.0) {
+        tHat = WDSubtractPoints(seg.b_, seg.a_);
+    }
+    
+    return WDNormalizePoint(tHat);
+}
+
+static CGPoint EndTangent(WDBezierSegment seg)
+{
+    CGPoint tHat = WDSubtractPoints(seg.in_, seg.b_);
+    
+    if (V2SquaredLength(tHat) == 0.0) {
+        tHat = WDSubtractPoints(seg.out_, seg.b_);
+    }
+    if (V2SquaredLength(tHat) == 0.0) {
+        tHat = WDSubtractPoints(seg.a_, seg.b_);
+    }
+    
+    return WDNormalizePoint(tHat);
+}
+
+//  IsCorner : Whether the node between segments p and q turns by more than kReduceCornerAngle
+//
+static BOOL IsCorner(WDBezierSegment p, WDBezierSegment q)
+{
+    // the tangents point away from the node, so a smooth node has them opposite
+    return (-V2Dot(EndTangent(p), StartTangent(q)) < cos(kReduceCornerAngle));
+}
+
+//  SquaredDistanceToLine : Squared distance from p to the line segment ab
+//
+static double SquaredDistanceToLine(CGPoint p, CGPoint a, CGPoint b)
+{
+    CGPoint ab = WDSubtractPoints(b, a);
+    double  length = V2SquaredLength(ab);
+    double  t = (length > 0.0) ? V2Dot(WDSubtractPoints(p, a), ab) / length : 0.0;
+    
+    t = MIN(MAX(t, 0.0), 1.0);
+    return V2SquaredLength(WDSubtractPoints(p, WDAddPoints(a, WDMultiplyPointScalar(ab, t))));
+}
+
+//  DouglasPeucker : Mark in keep the points of d[first..last] that a Douglas-Peucker pass keeps for
+//  the given tolerance, ends included; stack needs room for 2 * (last - first + 1) indices
+//
+static void DouglasPeucker(CGPoint *d, int first, int last, double tolerance, BOOL *keep, int *stack)
+{
+    double  sqTolerance = tolerance * tolerance;
+    int     top = 0;
+    
+    keep[first] = keep[last] = YES;
+    stack[top++] = first;
+    stack[top++] = last;
+    
+    while (top > 0) {
+        int     b = stack[--top], a = stack[--top];
+        int     farthest = -1;
+        double  maxDist = sqTolerance;
+        
+        for (int i = a + 1; i < b; i++) {
+            double dist = SquaredDistanceToLine(d[i], d[a], d[b]);
+            if (dist > maxDist) {
+                maxDist = dist;
+                farthest = i;
+            }
+        }
+        
+        if (farthest >= 0) {
+            keep[farthest] = YES;
+            stack[top++] = a;
+            stack[top++] = farthest;
+            stack[top++] = farthest;
+            stack[top++] = b;
+        }
+    }
+}
+
+//  DistanceToPolyline : The distance from p to the polyline through pts
+//
+static double DistanceToPolyline(CGPoint p, CGPoint *pts, int nPts)
+{
+    double dist = V2SquaredLength(WDSubtractPoints(p, pts[0]));
+    
+    for (int j = 1; j < nPts; j++) {
+        dist = MIN(dist, SquaredDistanceToLine(p, pts[j - 1], pts[j]));
+    }
+    
+    return sqrt(dist);
+}
+
+//  EdgeWithin : Whether every point of the edge ab, whose ends are da and db away from the polyline other,
+//  is within limit of it. The distance to other changes by no more than the distance moved along the edge,
+//  so no point of it is further than (da + db + |ab|) / 2; edges that bound doesn't clear are halved, and
+//  an edge still unresolved after depth halvings counts as outside
+//
+static BOOL EdgeWithin(CGPoint a, double da, CGPoint b, double db, CGPoint *other, int nOther, double limit, int depth)
+{
+    if (MAX(da, db) > limit) {
+        return NO;
+    }
+    if ((da + db + WDDistance(a, b)) / 2 <= limit) {
+        return YES;
+    }
+    if (depth == 0) {
+        return NO;
+    }
+    
+    CGPoint mid = WDAveragePoints(a, b);
+    double  dMid = DistanceToPolyline(mid, other, nOther);
+    
+    return (EdgeWithin(a, da, mid, dMid, other, nOther, limit, depth - 1) &&
+            EdgeWithin(mid, dMid, b, db, other, nOther, limit, depth - 1));
+}
+
+//  PolylineWithin : Whether every point of the polyline through pts is within limit of the polyline through other
+//
+static BOOL PolylineWithin(CGPoint *pts, int nPts, CGPoint *other, int nOther, double limit)
+{
+    double prev = DistanceToPolyline(pts[0], other, nOther);
+    
+    if (prev > limit) {
+        return NO;
+    }
+    
+    for (int i = 1; i < nPts; i++) {
+        double dist = DistanceToPolyline(pts[i], other, nOther);
+        
+        if (!EdgeWithin(pts[i - 1], prev, pts[i], dist, other, nOther, limit, kReduceCheckDepth)) {
+            return NO;
+        }
+        prev = dist;
+    }
+    
+    return YES;
+}
+
+//  WithinTolerance : Whether each segment of fit and the samples it replaces (samples[bounds[k]..bounds[k+1]]
+//  for segment k) are within limit of each other, in both directions, so the Hausdorff distance between the
+//  flattened fit and the samples is at most limit
+//
+static BOOL WithinTolerance(WDBezierSegment *fit, int nFit, int *bounds, CGPoint *samples, double flatness, double limit)
+{
+    WDPointBuffer   flat = {NULL, 0, 0};
+    BOOL            within = YES;
+    
+    for (int k = 0; k < nFit && within; k++) {
+        CGPoint *span = samples + bounds[k];
+        int     nSpan = bounds[k + 1] - bounds[k] + 1;
+        
+        flat.count = 0;
+        WDBezierSegmentFlattenWithTolerance(fit[k], flatness, &flat);
+        
+        within = (PolylineWithin(flat.points, (int) flat.count, span, nSpan, limit) &&
+                  PolylineWithin(span, nSpan, flat.points, (int) flat.count, limit));
+    }
+    
+    WDPointBufferFree(&flat);
+    return within;
+}
+
+//  ReduceRun : Refit the run of segments between two corners, and append the result to out
+//
+//  The run is flattened into samples, and Douglas-Peucker picks the samples the fit needs: the
+//  other ones lie within the flatness of the lines between them. The fit takes half the tolerance,
+//  and is accepted if it's within tolerance of the samples, less the flatness of the samples and of
+//  the check; otherwise it's tried again with a smaller error, and the run is kept as it is if that
+//  doesn't work either. A run of straight segments is also tried as lines through the samples.
+//
+static void ReduceRun(const WDBezierSegment *run, int nRun, double tolerance, WDBezierSegment *out, int *nOut)
+{
+    double          flatness = tolerance / 8;
+    WDPointBuffer   samples = {NULL, 0, 0};
+    BOOL            allStraight = YES;
+    
+    for (int i = 0; i < nRun; i++) {
+        WDBezierSegmentFlattenWithTolerance(run[i], flatness, &samples);
+        allStraight = allStraight && WDBezierSegmentIsStraight(run[i]);
+    }
+    
+    int             nPts = (int) samples.count;
+    CGPoint         *d = samples.points;
+    BOOL            *keep = calloc(nPts, sizeof(BOOL));
+    int             *stack = malloc(2 * nPts * sizeof(int));
+    int             *index = malloc(nPts * sizeof(int));    // sample index of each candidate
+    int             *bounds = malloc(nPts * sizeof(int));
+    int             *ends = malloc(nPts * sizeof(int));
+    CGPoint         *candidates = malloc(nPts * sizeof(CGPoint));
+    double          *scratch = malloc(2 * nPts * sizeof(double));
+    WDBezierSegment *fit = malloc(nPts * sizeof(WDBezierSegment));
+    WDBezierSegment *best = NULL;
+    int             nBest = nRun;   // a result has to beat the run itself
+    
+    if (allStraight) {
+        // the samples of a straight segment are exact, so the lines can take the whole tolerance
+        DouglasPeucker(d, 0, nPts - 1, tolerance, keep, stack);
+        
+        int nLines = 0;
+        for (int i = 0; i < nPts; i++) {
+            if (keep[i]) {
+                bounds[nLines++] = i;
+            }
+        }
+        nLines--;
+        
+        for (int k = 0; k < nLines; k++) {
+            CGPoint a = d[bounds[k]], b = d[bounds[k + 1]];
+            fit[k] = (WDBezierSegment) {a, a, b, b};
+        }
+        
+        if (nLines < nBest && WithinTolerance(fit, nLines, bounds, d, flatness, tolerance)) {
+            best = malloc(nLines * sizeof(WDBezierSegment));
+            memcpy(best, fit, nLines * sizeof(WDBezierSegment));
+            nBest = nLines;
+        }
+        memset(keep, 0, nPts * sizeof(BOOL));
+    }
+    
+    int nCandidates = 0;
+    DouglasPeucker(d, 0, nPts - 1, flatness, keep, stack);
+    for (int i = 0; i < nPts; i++) {
+        if (keep[i]) {
+            index[nCandidates] = i;
+            candidates[nCandidates++] = d[i];
+        }
+    }
+    
+    double error = tolerance / 2;
+    for (int attempt = 0; attempt < kReduceAttempts; attempt++, error /= 2) {
+        int nFit = FitGreedy(fit, ends, candidates, nCandidates, StartTangent(run[0]), EndTangent(run[nRun - 1]),
+                             error * error, scratch);
+        
+        if (nFit >= nBest) {
+            // a smaller error only takes more segments
+            break;
+        }
+        
+        bounds[0] = 0;
+        for (int k = 0; k < nFit; k++) {
+            bounds[k + 1] = index[ends[k]];
+        }
+        
+        if (WithinTolerance(fit, nFit, bounds, d, flatness, tolerance - 2 * flatness)) {
+            free(best);
+            best = malloc(nFit * sizeof(WDBezierSegment));
+            memcpy(best, fit, nFit * sizeof(WDBezierSegment));
+            nBest = nFit;
+            break;
+        }
+    }
+    
+    memcpy(out + *nOut, best ?: run, nBest * sizeof(WDBezierSegment));
+    *nOut += nBest;
+    
+    free(best);
+    free(fit);
+    free(scratch);
+    free(candidates);
+    free(ends);
+    free(bounds);
+    free(index);
+    free(stack);
+    free(keep);
+    WDPointBufferFree(&samples);
+}
+
+int ReduceSegments(const WDBezierSegment *segments, int count, BOOL closed, double tolerance, WDBezierSegment **reduced)
+{
+    WDBezierSegment *out = malloc(MAX(count, 1) * sizeof(WDBezierSegment));
+    WDBezierSegment *run = malloc(MAX(count, 1) * sizeof(WDBezierSegment));
+    int             nOut = 0, start = 0;
+    
+    if (closed) {
+        // start at a corner, so that the first run doesn't wrap around; without any, the start node
+        // is smooth and the run makes a full turn
+        for (int i = 0; i < count; i++) {
+            if (IsCorner(segments[(i + count - 1) % count], segments[i])) {
+                start = i;
+                break;
+            }
+        }
+    }
+    
+    int nRun = 0;
+    for (int i = 0; i < count; i++) {
+        run[nRun++] = segments[(start + i) % count];
+        
+        BOOL endOfRun = (i == count - 1) || IsCorner(segments[(start + i) % count], segments[(start + i + 1) % count]);
+        if (endOfRun) {
+            if (nRun == 1) {
+                out[nOut++] = run[0];
+            } else {
+                ReduceRun(run, nRun, tolerance, out, &nOut);
+            }
+            nRun = 0;
+        }
+    }
+    
+    free(run);
+    *reduced = out;
+    return nOut;
+}
+
+#define kFitStreamMaxTail       256         // points in the tail before it's frozen even though it still fits
+
+void FitCurveStreamInit(FitCurveStream *stream, double error)
+{
+    memset(stream, 0, sizeof(FitCurveStream));
+    stream->error = error;
+}
+
+void FitCurveStreamFree(FitCurveStream *stream)
+{
+    free(stream->pts);
+    free(stream->segments);
+    free(stream->ends);
+    free(stream->scratch);
+    memset(stream, 0, sizeof(FitCurveStream));
+}
+
+static void FitCurveStreamReserve(FitCurveStream *stream, int nSegments, int nTailPts)
+{
+    if (nSegments > stream->maxSegments) {
+        stream->maxSegments = nSegments * 2;
+        stream->segments = realloc(stream->segments, stream->maxSegments * sizeof(WDBezierSegment));
+        stream->ends = realloc(stream->ends, stream->maxSegments * sizeof(int));
+    }
+    
+    if (2 * nTailPts > stream->maxScratch) {
+        stream->maxScratch = 4 * nTailPts;
+        stream->scratch = realloc(stream->scratch, stream->maxScratch * sizeof(double));
+    }
+}
+
+// index of the first point of the tail, and the unit tangent the tail starts with
+static int FitCurveStreamTail(FitCurveStream *stream, CGPoint *tHat1)
+{
+    if (stream->nFrozen == 0) {
+        *tHat1 = (stream->nPts > 1) ? ComputeLeftTangent(stream->pts, 0) : CGPointZero;
+        return 0;
+    }
+    
+    *tHat1 = stream->tailTangent;
+    return stream->ends[stream->nFrozen - 1];
+}
+
+//  FitCurveStreamAddPoint : Append a point, and extend the fit of the tail to it
+//
+int FitCurveStreamAddPoint(FitCurveStream *stream, CGPoint pt)
+{
+    BezierCurve     bezCurve;
+    CGPoint         tHat1, tHatCenter;
+    int             splitPoint;
+    
+    if (stream->nPts == stream->maxPts) {
+        stream->maxPts = stream->maxPts * 2 + 64;
+        stream->pts = realloc(stream->pts, stream->maxPts * sizeof(CGPoint));
+    }
+    stream->pts[stream->nPts++] = pt;
+    
+    CGPoint *d = stream->pts;
+    int     first = FitCurveStreamTail(stream, &tHat1);
+    int     last = stream->nPts - 1;
+    
+    if (last == first) {
+        stream->nSegments = stream->nFrozen;
+        return 0;
+    }
+    
+    FitCurveStreamReserve(stream, stream->nFrozen + 2, last - first + 1);
+    
+    if (FitSingleCubic(d, first, last, tHat1, ComputeRightTangent(d, last), stream->error, &bezCurve, &splitPoint, stream->scratch)) {
+        AddBezierSegment(stream->segments, stream->ends, bezCurve, last, stream->nFrozen);
+        stream->nSegments = stream->nFrozen + 1;
+        
+        if (last - first < kFitStreamMaxTail) {
+            return 0;
+        }
+        
+        // a long smooth stroke would stay in one tail, and cost a fit of all its points per point: the tail
+        // is frozen at its point of max error (kept in its middle half, so that neither part is short),
+        // where both parts get the tangent of both its sides
+        int quarter = (last - first) / 4;
+        int joint = MIN(MAX(splitPoint, first + quarter), last - quarter);
+        int nFrozen = stream->nFrozen;
+        
+        FitCurveStreamReserve(stream, stream->nFrozen + (last - first), last - first + 1);
+        tHatCenter = ComputeCenterTangent(d, joint);
+        stream->nFrozen = FitCubic(stream->segments, stream->ends, d, first, joint, tHat1, tHatCenter,
+                                   stream->error, stream->nFrozen, stream->scratch);
+        stream->tailTangent = WDMultiplyPointScalar(tHatCenter, -1);
+        
+        stream->nSegments = FitCubic(stream->segments, stream->ends, d, joint, last, stream->tailTangent, ComputeRightTangent(d, last),
+                                     stream->error, stream->nFrozen, stream->scratch);
+        return stream->nFrozen - nFrozen;
+    }
+    
+    // the tail can't take the new point (so it had more than 2 points, which always fit): its fit up to
+    // the previous point is final, and a new tail starts there; the joint gets the tangent of both its
+    // sides if the final segment can take it, and keeps the one it was fitted with otherwise
+    int joint = last - 1;
+    
+    tHatCenter = ComputeCenterTangent(d, joint);
+    if (FitSingleCubic(d, first, joint, tHat1, tHatCenter, stream->error, &bezCurve, &splitPoint, stream->scratch)) {
+        AddBezierSegment(stream->segments, stream->ends, bezCurve, joint, stream->nFrozen);
+        stream->tailTangent = WDMultiplyPointScalar(tHatCenter, -1);
+    } else {
+        stream->tailTangent = WDMultiplyPointScalar(ComputeRightTangent(d, joint), -1);
+    }
+    stream->nFrozen++;
+    
+    stream->nSegments = FitCubic(stream->segments, stream->ends, d, joint, last, stream->tailTangent, ComputeRightTangent(d, last),
+                                 stream->error, stream->nFrozen, stream->scratch);
+    return 1;
+}
+
+//  FitCurveStreamRefit : Fit the tail again, after a change to its points
+//
+void FitCurveStreamRefit(FitCurveStream *stream)
+{
+    CGPoint tHat1;
+    int     first = FitCurveStreamTail(stream, &tHat1);
+    int     last = stream->nPts - 1;
+    
+    if (last <= first) {
+        stream->nSegments = stream->nFrozen;
+        return;
+    }
+    
+    // the tail can't be split into more segments than it has point intervals
+    FitCurveStreamReserve(stream, stream->nFrozen + (last - first), last - first + 1);
+    stream->nSegments = FitCubic(stream->segments, stream->ends, stream->pts, first, last, tHat1, ComputeRightTangent(stream->pts, last),
+                                 stream->error, stream->nFrozen, stream->scratch);
 }
 
 //  FitCubic : Fit a Bezier curve to a (sub)set of digitized points
+//  scratch holds 2 parameters per point, and is reused by the recursive calls
 //
-static int FitCubic(WDBezierSegment *segments, CGPoint *d, int first, int last, CGPoint tHat1, CGPoint tHat2, double error, int segCount)
+static int FitCubic(WDBezierSegment *segments, int *ends, CGPoint *d, int first, int last, CGPoint tHat1, CGPoint tHat2,
+                    double error, int segCount, double *scratch)
 {
     BezierCurve     bezCurve;
-    double          *u, *uPrime;
+    int             splitPoint;
+    CGPoint         tHatCenter;
+    
+    if (FitSingleCubic(d, first, last, tHat1, tHat2, error, &bezCurve, &splitPoint, scratch)) {
+        AddBezierSegment(segments, ends, bezCurve, last, segCount++);
+        return segCount;
+    }
+    
+    // Fitting failed -- split at max error point and fit recursively
+    tHatCenter = ComputeCenterTangent(d, splitPoint);
+    segCount = FitCubic(segments, ends, d, first, splitPoint, tHat1, tHatCenter, error, segCount, scratch);
+    tHatCenter = WDMultiplyPointScalar(tHatCenter, -1); // negate
+    segCount = FitCubic(segments, ends, d, splitPoint, last, tHatCenter, tHat2, error, segCount, scratch);
+    
+    return segCount;
+}
+
+//  FitSingleCubic : Fit one Bezier curve to a (sub)set of digitized points, returns NO (with the point
+//  of max error in splitPoint) if it can't be fitted within error
+//
+static BOOL FitSingleCubic(CGPoint *d, int first, int last, CGPoint tHat1, CGPoint tHat2, double error,
+                           BezierCurve *bezCurve, int *splitPoint, double *scratch)
+{
+    double          *u = scratch, *uPrime = scratch + (last - first + 1), *swap;
     double          maxError;
-    int             i, splitPoint;
+    int             i;
     int             nPts = last - first + 1;
     double          iterationError = error * error;
     int             maxIterations = 5;
-    CGPoint         tHatCenter;
     
     //  Use heuristic if region only has two points in it
     if (nPts == 2) {
         double dist = WDDistance(d[last], d[first]) / 3.0;
         
-        bezCurve.pts[0] = d[first];
-        bezCurve.pts[3] = d[last];
-        bezCurve.pts[1] = WDAddPoints(bezCurve.pts[0], WDScaleVector(tHat1, dist));
-        bezCurve.pts[2] = WDAddPoints(bezCurve.pts[3], WDScaleVector(tHat2, dist));
+        bezCurve->pts[0] = d[first];
+        bezCurve->pts[3] = d[last];
+        bezCurve->pts[1] = WDAddPoints(bezCurve->pts[0], WDScaleVector(tHat1, dist));
+        bezCurve->pts[2] = WDAddPoints(bezCurve->pts[3], WDScaleVector(tHat2, dist));
         
-        AddBezierSegment(segments, bezCurve, segCount++);
-        return segCount;
+        return YES;
     }
     
     //  Parameterize points, and attempt to fit curve
-    u = ChordLengthParameterize(d, first, last);
-    bezCurve = GenerateBezier(d, first, last, u, tHat1, tHat2);
+    ChordLengthParameterize(d, first, last, u);
+    *bezCurve = GenerateBezier(d, first, last, u, tHat1, tHat2);
     
     //  Find max deviation of points to fitted curve
-    maxError = ComputeMaxError(d, first, last, bezCurve, u, &splitPoint);
+    maxError = ComputeMaxError(d, first, last, *bezCurve, u, splitPoint);
     if (maxError < error) {
-        AddBezierSegment(segments, bezCurve, segCount++);
-        free(u);
-        return segCount;
+        return YES;
     }
     
     //  If error not too large, try some reparameterization and iteration
     if (maxError < iterationError) {
         for (i = 0; i < maxIterations; i++) {
-            uPrime = Reparameterize(d, first, last, u, bezCurve);
-            bezCurve = GenerateBezier(d, first, last, uPrime, tHat1, tHat2);
-            maxError = ComputeMaxError(d, first, last, bezCurve, uPrime, &splitPoint);
+            Reparameterize(d, first, last, u, *bezCurve, uPrime);
+            *bezCurve = GenerateBezier(d, first, last, uPrime, tHat1, tHat2);
+            maxError = ComputeMaxError(d, first, last, *bezCurve, uPrime, splitPoint);
             if (maxError < error) {
-                AddBezierSegment(segments, bezCurve, segCount++);
-                free(u);
-                free(uPrime);
-                return segCount;
+                return YES;
             }
-            free(u);
+            swap = u;
             u = uPrime;
+            uPrime = swap;
         }
     }
     
-    // Fitting failed -- split at max error point and fit recursively
-    free(u);
-    tHatCenter = ComputeCenterTangent(d, splitPoint);
-    segCount = FitCubic(segments, d, first, splitPoint, tHat1, tHatCenter, error, segCount);
-    tHatCenter = WDMultiplyPointScalar(tHatCenter, -1); // negate
-    segCount = FitCubic(segments, d, splitPoint, last, tHatCenter, tHat2, error, segCount);
-    
-    return segCount;
+    return NO;
 }
 
 //  GenerateBezier : Use least-squares method to find Bezier control points for region.
@@ -118,7 +718,7 @@ static int FitCubic(WDBezierSegment *segments, CGPoint *d, int first, int last,
 static BezierCurve GenerateBezier(CGPoint *d, int first, int last, double *uPrime, CGPoint tHat1, CGPoint tHat2)
 {
     BezierCurve     bezCurve;
-    CGPoint         A[last-first + 1][2];
+    CGPoint         A0, A1;
     int             i, nPts;
     double          C[2][2] = {0};
     double          X[2] = {0};
@@ -128,17 +728,15 @@ static BezierCurve GenerateBezier(CGPoint *d, int first, int last, double *uPrim
     
     nPts = last - first + 1;
     
-    // Compute the A's
     for (i = 0; i < nPts; i++) {
-        A[i][0] = WDScaleVector(tHat1, B1(uPrime[i]));
-        A[i][1] = WDScaleVector(tHat2, B2(uPrime[i]));
-    }
-    
-    for (i = 0; i < nPts; i++) {
-        C[0][0] += V2Dot(A[i][0], A[i][0]);
-        C[0][1] += V2Dot(A[i][0], A[i][1]);
+        // Compute the A's
+        A0 = WDScaleVector(tHat1, B1(uPrime[i]));
+        A1 = WDScaleVector(tHat2, B2(uPrime[i]));
+        
+        C[0][0] += V2Dot(A0, A0);
+        C[0][1] += V2Dot(A0, A1);
         C[1][0] = C[0][1];
-        C[1][1] += V2Dot(A[i][1], A[i][1]);
+        C[1][1] += V2Dot(A1, A1);
         
         tmp = WDMultiplyPointScalar(d[last], B3(uPrime[i]));
         tmp = WDAddPoints(WDMultiplyPointScalar(d[last], B2(uPrime[i])), tmp);
@@ -146,8 +744,8 @@ static BezierCurve GenerateBezier(CGPoint *d, int first, int last, double *uPrim
         tmp = WDAddPoints(WDMultiplyPointScalar(d[first], B0(uPrime[i])), tmp);
         tmp = WDSubtractPoints(d[first + i], tmp);
         
-        X[0] += V2Dot(A[i][0], tmp);
-        X[1] += V2Dot(A[i][1], tmp);
+        X[0] += V2Dot(A0, tmp);
+        X[1] += V2Dot(A1, tmp);
     }
     
     // Compute the determinants of C and X
@@ -184,16 +782,11 @@ static BezierCurve GenerateBezier(CGPoint *d, int first, int last, double *uPrim
 
 //  Reparameterize: Given set of points and their parameterization, try to find a better parameterization.
 //
-static double * Reparameterize(CGPoint *d, int first, int last, double *u, BezierCurve bezCurve)
+static void Reparameterize(CGPoint *d, int first, int last, double *u, BezierCurve bezCurve, double *uPrime)
 {
-    int  nPts = last-first+1;
-    double *uPrime; // New parameter values
-    
-    uPrime = malloc(nPts * sizeof(double));
     for (int i = first; i <= last; i++) {
         uPrime[i-first] = NewtonRaphsonRootFind(bezCurve, d[i], u[i-first]);
     }
-    return (uPrime);
 }
 
 //  NewtonRaphsonRootFind : Use Newton-Raphson iteration to find better root.
@@ -207,7 +800,7 @@ static double NewtonRaphsonRootFind(BezierCurve Q, CGPoint P, double u)
     int     i;
     
     // Compute Q(u)
-    Q_u = BezierII(3, Q, u);
+    Q_u = BezierII(3, Q.pts, u);
     
     // Generate control vertices for Q'
     for (i = 0; i <= 2; i++) {
@@ -240,13 +833,13 @@ static double NewtonRaphsonRootFind(BezierCurve Q, CGPoint P, double u)
 
 //  Bezier : Evaluate a Bezier curve at a particular parameter value
 //
-static CGPoint BezierII(int degree, BezierCurve V, double t)
+static CGPoint BezierII(int degree, CGPoint *V, double t)
 {
     CGPoint Vtemp[degree+1]; // Local copy of control points
     int     i, j;
     
     for (i = 0; i <= degree; i++) {
-        Vtemp[i] = V.pts[i];
+        Vtemp[i] = V[i];
     }
     
     // Triangle computation
@@ -304,10 +897,9 @@ static CGPoint ComputeCenterTangent(CGPoint *d, int center)
 
 //  ChordLengthParameterize : Assign parameter values to digitized points using relative distances between points.
 //
-static double *ChordLengthParameterize(CGPoint *d, int first, int last)
+static void ChordLengthParameterize(CGPoint *d, int first, int last, double *u)
 {
-    double *u = calloc((last-first+1), sizeof(double)); // init to 0
-    
+    u[0] = 0.0;
     for (int i = first+1; i <= last; i++) {
         u[i-first] = u[i-first-1] + WDDistance(d[i], d[i-1]);
     }
@@ -315,8 +907,6 @@ static double *ChordLengthParameterize(CGPoint *d, int first, int last)
     for (int i = first + 1; i <= last; i++) {
         u[i-first] = u[i-first] / u[last-first];
     }
-    
-    return u;
 }
 
 //  ComputeMaxError : Find the maximum squared distance of digitized points to fitted curve.
@@ -331,7 +921,7 @@ static double ComputeMaxError(CGPoint *d, int first, int last, BezierCurve bezCu
     *splitPoint = (last - first + 1) / 2;
     
     for (int i = first + 1; i < last; i++) {
-        P = BezierII(3, bezCurve, u[i-first]);
+        P = BezierII(3, bezCurve.pts, u[i-first]);
         v = WDSubtractPoints(P, d[i]);
         dist = V2SquaredLength(v);
         if (dist >= maxDist) {
@@ -353,11 +943,15 @@ static double V2Dot(CGPoint a, CGPoint b) {
     return (a.x * b.x) + (a.y * b.y);
 }
 
-// populate the bezier segment at ix
-static void AddBezierSegment(WDBezierSegment *segments, BezierCurve curve, int ix) {
+// populate the bezier segment at ix, and record the index of its last point in ends (if given)
+static void AddBezierSegment(WDBezierSegment *segments, int *ends, BezierCurve curve, int last, int ix) {
     segments[ix].a_ = curve.pts[0];
     segments[ix].out_ = curve.pts[1];
     segments[ix].in_ = curve.pts[2];
     segments[ix].b_ = curve.pts[3];
+    
+    if (ends) {
+        ends[ix] = last;
+    }
 }
 
@@ -44,9 +44,17 @@ typedef enum {
 
 - (NSArray *) erase:(WDAbstractPath *)erasePath;
 
+// paths that are erased by subtracting the eraser, which WDPathfinder can do for many paths at once
+// eraseResult: turns that difference (nil if nothing is left) into what erase: would have returned
+- (BOOL) erasesWithPathfinder;
+- (NSArray *) eraseResult:(WDAbstractPath *)difference;
+
 - (void) simplify;
 - (void) flatten;
 
+// replaces the nodes by as few as it takes to stay within tolerance of the outline
+- (void) reduceNodesWithTolerance:(float)tolerance;
+
 - (WDAbstractPath *) pathByFlatteningPath;
 
 // so subclasses can override
@@ -229,9 +229,7 @@ NSString *WDFillRuleKey = @"WDFillRuleKey";
 
 + (WDAbstractPath *) pathWithCGPathRef:(CGPathRef)pathRef
 {
-    NSMutableArray *subpaths = [NSMutableArray array];
-    
-    CGPathApply(pathRef, (__bridge void *)(subpaths), &WDPathApplyAccumulateElement);
+    NSMutableArray *subpaths = WDSubpathsForPath(pathRef);
     
     if (subpaths.count == 1) {
         // single path
@@ -303,6 +301,11 @@ NSString *WDFillRuleKey = @"WDFillRuleKey";
     // implemented by concrete subclasses
 }
 
+- (void) reduceNodesWithTolerance:(float)tolerance
+{
+    // implemented by concrete subclasses
+}
+
 - (WDAbstractPath *) pathByFlatteningPath
 {
     // implemented by concrete subclasses
@@ -315,6 +318,17 @@ NSString *WDFillRuleKey = @"WDFillRuleKey";
     return nil;
 }
 
+- (BOOL) erasesWithPathfinder
+{
+    return NO;
+}
+
+- (NSArray *) eraseResult:(WDAbstractPath *)difference
+{
+    // implemented by concrete subclasses
+    return nil;
+}
+
 - (BOOL) isErasable
 {
     return YES;
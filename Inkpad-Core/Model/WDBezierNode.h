@@ -10,6 +10,7 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "WDBezierSegment.h"
 #import "WDPickResult.h"
 
 #if !TARGET_OS_IPHONE
@@ -28,6 +29,26 @@ typedef enum {
     kWDBezierNodeRenderSelected
 } WDBezierNodeRenderMode;
 
+// the geometry of a node, packed: paths store their nodes as an array of these, and make node objects
+// from them only when they are asked for
+typedef struct {
+    CGPoint     inPoint, anchorPoint, outPoint;
+} WDBezierNodeData;
+
+NSData *WDBezierNodeDataWithNodes(NSArray *nodes);
+NSMutableArray *WDBezierNodesWithData(NSData *data);
+
+// transformed and reversed may be the same array as nodes
+void WDBezierNodeDataTransform(const WDBezierNodeData *nodes, WDBezierNodeData *transformed, NSUInteger count, CGAffineTransform transform);
+// the nodes backwards, with their handles swapped (see -flippedNode)
+void WDBezierNodeDataReverse(const WDBezierNodeData *nodes, WDBezierNodeData *reversed, NSUInteger count);
+
+static inline WDBezierSegment WDBezierSegmentMakeWithData(WDBezierNodeData a, WDBezierNodeData b)
+{
+    WDBezierSegment segment = { a.anchorPoint, a.outPoint, b.inPoint, b.anchorPoint };
+    return segment;
+}
+
 @interface WDBezierNode : NSObject <NSCoding, NSCopying> {
     CGPoint     inPoint_;
     CGPoint     anchorPoint_;
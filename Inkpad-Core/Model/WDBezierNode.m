@@ -27,6 +27,67 @@
 
 NSString *WDPointArrayKey = @"WDPointArrayKey";
 
+/**************************
+ * WDBezierNodeData
+ *************************/
+
+NSData *WDBezierNodeDataWithNodes(NSArray *nodes)
+{
+    NSMutableData       *data = [NSMutableData dataWithLength:sizeof(WDBezierNodeData) * nodes.count];
+    WDBezierNodeData    *packed = data.mutableBytes;
+    
+    for (WDBezierNode *node in nodes) {
+        [node getInPoint:&packed->inPoint anchorPoint:&packed->anchorPoint outPoint:&packed->outPoint selected:NULL];
+        packed++;
+    }
+    
+    return data;
+}
+
+NSMutableArray *WDBezierNodesWithData(NSData *data)
+{
+    const WDBezierNodeData  *packed = data.bytes;
+    NSUInteger              count = data.length / sizeof(WDBezierNodeData);
+    NSMutableArray          *nodes = [NSMutableArray arrayWithCapacity:count];
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        [nodes addObject:[WDBezierNode bezierNodeWithInPoint:packed[i].inPoint anchorPoint:packed[i].anchorPoint outPoint:packed[i].outPoint]];
+    }
+    
+    return nodes;
+}
+
+void WDBezierNodeDataTransform(const WDBezierNodeData *nodes, WDBezierNodeData *transformed, NSUInteger count, CGAffineTransform transform)
+{
+    // a node is 3 points, so this is one pass over a flat array of points, which the compiler vectorizes
+    const CGFloat   *src = (const CGFloat *) nodes;
+    CGFloat         *dst = (CGFloat *) transformed;
+    CGFloat         a = transform.a, b = transform.b, c = transform.c, d = transform.d;
+    CGFloat         tx = transform.tx, ty = transform.ty;
+    
+    for (NSUInteger i = 0; i < count * 6; i += 2) {
+        CGFloat x = src[i], y = src[i + 1];
+        
+        dst[i] = a * x + c * y + tx;
+        dst[i + 1] = b * x + d * y + ty;
+    }
+}
+
+void WDBezierNodeDataReverse(const WDBezierNodeData *nodes, WDBezierNodeData *reversed, NSUInteger count)
+{
+    for (NSUInteger i = 0, j = count - 1; i < (count + 1) / 2; i++, j--) {
+        WDBezierNodeData first = nodes[i], last = nodes[j];
+        
+        reversed[i].inPoint = last.outPoint;
+        reversed[i].anchorPoint = last.anchorPoint;
+        reversed[i].outPoint = last.inPoint;
+        
+        reversed[j].inPoint = first.outPoint;
+        reversed[j].anchorPoint = first.anchorPoint;
+        reversed[j].outPoint = first.inPoint;
+    }
+}
+
 /**************************
  * WDBezierNode
  *************************/
@@ -11,7 +11,7 @@
 
 #import <Foundation/Foundation.h>
 
-extern const float kDefaultFlatness;
+extern const float kDefaultFlattenTolerance;
 
 @class WDBezierNode;
 
@@ -26,33 +26,103 @@ typedef struct {
     CGPoint a_, out_, in_, b_;
 } WDBezierSegment;
 
+#define kWDArcLengthSamples 32
+
+// a growing array of points, owned by the caller: zero it before the first use, set count to 0 to reuse the
+// storage, and free it with WDPointBufferFree
+typedef struct {
+    CGPoint     *points;
+    NSUInteger  count, capacity;
+} WDPointBuffer;
+
+// a point where two curves meet: segment1 and segment2 index the two arrays of segments, t1 and t2 are the
+// parameters on those segments
+typedef struct {
+    NSUInteger  segment1, segment2;
+    float       t1, t2;
+} WDBezierIntersection;
+
+// a node of a bounding volume hierarchy over an array of segments: the leaves hold one segment each, bounded
+// by its control points, and the tree is stored depth first in an array of 2 * count - 1 nodes
+typedef struct {
+    CGRect      bounds;
+    NSUInteger  first, count;   // the segments under the node
+    NSUInteger  right;          // index of the second child, the first one follows the node
+} WDSegmentTreeNode;
+
+// arc length of a segment sampled at evenly spaced values of t, for point at distance queries
+typedef struct {
+    WDBezierSegment segment;
+    float           length;
+    float           lengths[kWDArcLengthSamples + 1]; // arc length from the start to t = i / kWDArcLengthSamples
+} WDBezierArcLengthTable;
+
 
 WDBezierSegment WDBezierSegmentMake(WDBezierNode *a, WDBezierNode *b);
 BOOL WDBezierSegmentIsDegenerate(WDBezierSegment seg);
 
-BOOL WDBezierSegmentIntersectsRect(WDBezierSegment seg, CGRect rect);
+// whether the polyline of seg for tolerance (see WDBezierSegmentFlatteningSteps) crosses rect
+BOOL WDBezierSegmentIntersectsRect(WDBezierSegment seg, CGRect rect, float tolerance);
 BOOL WDLineInRect(CGPoint a, CGPoint b, CGRect test);
 
 BOOL WDBezierSegmentIsStraight(WDBezierSegment segment);
+// whether the control points of seg are within tolerance of the line through its ends; the tolerance is
+// in the units of seg, so a caller drawing to the screen divides it by the screen scale
 BOOL WDBezierSegmentIsFlat(WDBezierSegment seg, float tolerance);
-void WDBezierSegmentFlatten(WDBezierSegment seg, CGPoint **vertices, NSUInteger *size, NSUInteger *index);
+
+void WDPointBufferAdd(WDPointBuffer *buffer, CGPoint pt);
+void WDPointBufferReserve(WDPointBuffer *buffer, NSUInteger count);
+void WDPointBufferFree(WDPointBuffer *buffer);
+
+// flattening to polylines that stay within tolerance of the curves; these only touch the memory they are
+// given, so they can run on any thread
+NSUInteger WDBezierSegmentFlatteningSteps(WDBezierSegment seg, float tolerance);
+// appends the points of seg after its start (and the start too when the buffer is empty)
+void WDBezierSegmentFlattenWithTolerance(WDBezierSegment seg, float tolerance, WDPointBuffer *buffer);
+// appends the polyline of count consecutive segments
+void WDBezierSegmentsFlatten(const WDBezierSegment *segments, NSUInteger count, float tolerance, WDPointBuffer *buffer);
+
 CGPoint WDBezierSegmentSplit(WDBezierSegment seg, WDBezierSegment *L, WDBezierSegment *R);
 CGPoint WDBezierSegmentSplitAtT(WDBezierSegment seg, WDBezierSegment *L, WDBezierSegment *R, float t);
 CGPoint WDBezierSegmentTangetAtT(WDBezierSegment seg, float t);
 
+// the point of seg closest to test, with its parameter in *t (may be NULL)
+CGPoint WDBezierSegmentNearestPoint(WDBezierSegment seg, CGPoint test, float *t);
+// the same over count segments, skipping the ones whose control points are all maxDistance or more away; returns
+// the index of the closest segment (NSNotFound if none is closer than maxDistance), with its point and parameter
+NSUInteger WDBezierSegmentsNearestPoint(const WDBezierSegment *segments, NSUInteger count, CGPoint test, float maxDistance,
+                                        CGPoint *nearest, float *t);
+// YES if test is closer than tolerance to seg, with the closest point and its parameter (either may be NULL)
 BOOL WDBezierSegmentFindPointOnSegment(WDBezierSegment seg, CGPoint testPoint, float tolerance, CGPoint *nearestPoint, float *split);
 
 CGRect WDBezierSegmentBounds(WDBezierSegment seg);
+void WDBezierSegmentBoundsArray(const WDBezierSegment *segments, CGRect *bounds, NSUInteger count);
 CGRect WDBezierSegmentGetSimpleBounds(WDBezierSegment seg);
 
 float WDBezierSegmentCurvatureAtT(WDBezierSegment seg, float t);
 CGPoint WDBezierSegmentPointAndTangentAtDistance(WDBezierSegment seg, float distance, CGPoint *tangent, float *curvature);
 float WDBezierSegmentLength(WDBezierSegment seg);
 
+void WDBezierArcLengthTableInit(WDBezierArcLengthTable *table, WDBezierSegment seg);
+float WDBezierArcLengthTableTAtDistance(const WDBezierArcLengthTable *table, float distance);
+float WDBezierArcLengthTableDistanceAtT(const WDBezierArcLengthTable *table, float t);
+CGPoint WDBezierArcLengthTablePointAtDistance(const WDBezierArcLengthTable *table, float distance, CGPoint *tangent, float *curvature);
+void WDBezierArcLengthTablePointsAtDistances(const WDBezierArcLengthTable *table, const float *distances, NSUInteger count,
+                                             CGPoint *points, CGPoint *tangents, float *curvatures);
+
 CGPoint WDBezierSegmentGetClosestPoint(WDBezierSegment seg, CGPoint test, float *error, float *distance);
 BOOL WDBezierSegmentsFormCorner(WDBezierSegment a, WDBezierSegment b);
 
 BOOL WDBezierSegmentGetIntersection(WDBezierSegment seg, CGPoint a, CGPoint b, float *tIntersect);
+// all the points where a segment of a meets a segment of b, or comes within tolerance (tangent curves), sorted
+// by segment1 then t1; returns the count, with the intersections in *intersections for the caller to free
+NSUInteger WDBezierSegmentsIntersect(const WDBezierSegment *a, NSUInteger countA, const WDBezierSegment *b, NSUInteger countB,
+                                     float tolerance, WDBezierIntersection **intersections);
+
+// nodes needs room for 2 * count - 1 nodes
+void WDSegmentTreeBuild(const WDBezierSegment *segments, NSUInteger count, WDSegmentTreeNode *nodes);
+// calls block with the index of each segment whose bounds meet rect, in increasing order, until it sets *stop (nodes may be NULL, for no segments)
+void WDSegmentTreeEnumerateSegmentsInRect(const WDSegmentTreeNode *nodes, CGRect rect, void (^block)(NSUInteger segment, BOOL *stop));
 
 float WDBezierSegmentOutAngle(WDBezierSegment seg);
 CGPoint WDBezierSegmentCalculatePointAtT(WDBezierSegment seg, float t);
@@ -13,10 +13,9 @@
 #import "WDBezierNode.h"
 #import "WDUtilities.h"
 
-const float kDefaultFlatness = 6;
+const float kDefaultFlattenTolerance = 0.25f;
 
-static CGPoint      *vertices = NULL;
-static NSUInteger   size = 128;
+#define kWDMaxFlatteningSteps   1024
 
 float firstDerivative(float A, float B, float C, float D, float t);
 float secondDerivative(float A, float B, float C, float D, float t);
@@ -37,8 +36,6 @@ WDBezierSegment WDBezierSegmentMake(WDBezierNode *a, WDBezierNode *b)
 
 inline BOOL WDBezierSegmentIsFlat(WDBezierSegment seg, float tolerance)
 {
-    float scaledTolerance = tolerance / [UIScreen mainScreen].scale;
-    
     if (CGPointEqualToPoint(seg.a_, seg.out_) && CGPointEqualToPoint(seg.in_, seg.b_)) {
         return YES;
     }
@@ -46,14 +43,12 @@ inline BOOL WDBezierSegmentIsFlat(WDBezierSegment seg, float tolerance)
     float dx = seg.b_.x - seg.a_.x;
     float dy = seg.b_.y - seg.a_.y;
     
+    // the distances of the control points from the line ab, times |ab|
     float d2 = fabs((seg.out_.x - seg.b_.x) * dy - (seg.out_.y - seg.b_.y) * dx);
     float d3 = fabs((seg.in_.x - seg.b_.x) * dy - (seg.in_.y - seg.b_.y) * dx);
-
-    if ((d2 + d3) * (d2 + d3) <= scaledTolerance * (dx * dx + dy * dy)) {
-        return YES;
-    }
+    float d = MAX(d2, d3);
     
-    return NO;
+    return (d * d <= tolerance * tolerance * (dx * dx + dy * dy));
 }
 
 BOOL WDBezierSegmentIsDegenerate(WDBezierSegment seg)
@@ -215,21 +210,22 @@ inline float WDBezierSegmentCurvatureAtT(WDBezierSegment seg, float t)
     return -num/denom;
 }
 
-BOOL WDBezierSegmentIntersectsRect(WDBezierSegment seg, CGRect test)
+BOOL WDBezierSegmentIntersectsRect(WDBezierSegment seg, CGRect test, float tolerance)
 {
-    WDBezierSegment L, R;
-    
-    if(WDBezierSegmentIsFlat(seg, kDefaultFlatness)) {
+    if (WDBezierSegmentIsStraight(seg)) {
         return WDLineInRect(seg.a_, seg.b_, test);
-    } else {
-        WDBezierSegmentSplit(seg, &L, &R);
+    }
+    
+    NSUInteger  steps = WDBezierSegmentFlatteningSteps(seg, tolerance);
+    CGPoint     a = seg.a_;
+    
+    for (NSUInteger i = 1; i <= steps; i++) {
+        CGPoint b = (i == steps) ? seg.b_ : WDBezierSegmentCalculatePointAtT(seg, (float) i / steps);
         
-        if(WDBezierSegmentIntersectsRect(L, test)) {
-            return YES;
-        }
-        if(WDBezierSegmentIntersectsRect(R, test)) {
+        if (WDLineInRect(a, b, test)) {
             return YES;
         }
+        a = b;
     }
     
     return NO;
@@ -291,213 +287,547 @@ BOOL WDLineInRect(CGPoint a, CGPoint b, CGRect test)
 }
 
 /*
- * WDBezierSegmentFindPointOnSegment_R()
- *
- * Performs a binary search on the path, subdividing it until a
- * sufficiently small section is found that contains the test point.
+ * Nearest point on a segment: the closest point is at an end, or where (P(t) - test) . P'(t), a polynomial of
+ * degree 5, has a root. Its Bernstein coefficients come straight from the control points, and the roots are
+ * isolated by subdividing until each piece's coefficients change sign at most once (then the piece holds
+ * exactly one root) and refined by Newton's method, kept inside the piece by bisection.
  */
-BOOL WDBezierSegmentFindPointOnSegment_R(WDBezierSegment seg, CGPoint testPoint, float tolerance,
-                                         CGPoint *nearestPoint, float *split, double depth)
+
+#define kWDNearestPointMaxDepth     24
+#define kWDNearestPointMaxRoots     5
+
+// B(i,3) * B(j,2) / B(i+j,5), for the product of the curve and its derivative
+static const double WDNearestPointZ[4][3] = {
+    {1.0, 0.4, 0.1},
+    {0.6, 0.6, 0.3},
+    {0.3, 0.6, 0.6},
+    {0.1, 0.4, 1.0}
+};
+
+static inline double WDBernstein5Evaluate(const double *w, double s, double *derivative)
 {
-    CGRect  bbox = CGRectInset(WDBezierSegmentGetSimpleBounds(seg), -tolerance / 2, -tolerance / 2);
+    double v[6];
     
-    if (!CGRectContainsPoint(bbox, testPoint)) {
-        return NO;
-    } else if (WDBezierSegmentIsStraight(seg)) {
-        CGPoint s = WDSubtractPoints(seg.b_, seg.a_);
-        CGPoint v = WDSubtractPoints(testPoint, seg.a_);
-        float   n = v.x * s.x + v.y * s.y;
-        float   d = s.x * s.x + s.y * s.y;
-        float   t = n/d;
-        BOOL    onSegment = NO;
-        
-        if (0.0f <= t && t <= 1.0f) {
-            CGPoint delta = WDSubtractPoints(seg.b_, seg.a_);
-            CGPoint p = WDAddPoints(seg.a_, WDMultiplyPointScalar(delta, t));
-            
-            if (WDDistance(p, testPoint) < tolerance) {
-                if (nearestPoint) {
-                    *nearestPoint = p;
-                }
-                if (split) {
-                    *split += (t * depth);
-                }
-                onSegment = YES;
-            }
+    memcpy(v, w, sizeof(v));
+    
+    for (int level = 5; level > 1; level--) {
+        for (int i = 0; i < level; i++) {
+            v[i] = v[i] + s * (v[i + 1] - v[i]);
         }
+    }
+    
+    // the last two points give the derivative
+    *derivative = 5 * (v[1] - v[0]);
+    
+    return v[0] + s * (v[1] - v[0]);
+}
+
+static inline void WDBernstein5Halve(const double *w, double *left, double *right)
+{
+    double v[6];
+    
+    memcpy(v, w, sizeof(v));
+    
+    for (int level = 0; level < 6; level++) {
+        left[level] = v[0];
+        right[5 - level] = v[5 - level];
         
-        return onSegment;
-    } else if((CGRectGetWidth(bbox) < tolerance * 1.1) || (CGRectGetHeight(bbox) < tolerance * 1.1)) {
-        // Close enough! This should be more or less a straight line now...
-        CGPoint s = WDSubtractPoints(seg.b_, seg.a_);
-        CGPoint v = WDSubtractPoints(testPoint, seg.a_);
-        float n = v.x * s.x + v.y * s.y;
-        float d = s.x * s.x + s.y * s.y;
-        float t = WDClamp(0.0f, 1.0f, n/d);
+        for (int i = 0; i < 5 - level; i++) {
+            v[i] = (v[i] + v[i + 1]) / 2;
+        }
+    }
+}
 
-        if (nearestPoint) {
-            // make sure the found point is on the path and not just near it
-            *nearestPoint = WDBezierSegmentSplitAtT(seg, NULL, NULL, t);
+static inline int WDBernstein5SignChanges(const double *w)
+{
+    int changes = 0, sign = 0;
+    
+    for (int i = 0; i < 6; i++) {
+        int s = (w[i] > 0) - (w[i] < 0);
+        
+        if (s != 0) {
+            changes += (sign != 0 && s != sign);
+            sign = s;
         }
-        if (split) {
-            *split += (t * depth);
+    }
+    
+    return changes;
+}
+
+// the one root of w in (0, 1), given that its coefficients change sign once: w has the sign of the first
+// nonzero coefficient just after 0, and of the last one just before 1 (an end with a zero coefficient is a
+// root of its own, which the caller has already)
+static double WDBernstein5Root(const double *w)
+{
+    double lo = 0, hi = 1, s = 0.5, derivative;
+    int    last = 5;
+    
+    while (w[last] == 0) {
+        last--;
+    }
+    
+    BOOL   rising = (w[last] > 0);
+    
+    for (int i = 0; i < 32; i++) {
+        double value = WDBernstein5Evaluate(w, s, &derivative);
+        
+        if (value == 0) {
+            return s;
+        } else if ((value > 0) == rising) {
+            hi = s;
+        } else {
+            lo = s;
         }
         
-        return YES;
+        double next = (derivative != 0) ? s - value / derivative : lo;
+        
+        if (next <= lo || next >= hi) {
+            next = (lo + hi) / 2;
+        }
+        
+        if (fabs(next - s) < 1e-9) {
+            return next;
+        }
+        
+        s = next;
     }
     
-    // We know the point is inside our bounding box, but our bounding box is not yet
-    // small enough to consider it a hit. So, subdivide the path and recurse...
+    return s;
+}
+
+static void WDBernstein5Roots_R(const double *w, double t0, double t1, int depth, double *roots, int *count)
+{
+    int changes = WDBernstein5SignChanges(w);
     
-    WDBezierSegment L, R;
-    BOOL            foundLeft = NO, foundRight = NO;
-    CGPoint         nearestLeftPoint, nearestRightPoint;
-    float           leftSplit = 0.0f, rightSplit = 0.0f;
+    if (*count == kWDNearestPointMaxRoots) {
+        return;
+    }
     
-    WDBezierSegmentSplit(seg, &L, &R);
+    if (w[0] == 0 && t0 > 0) {
+        // a root right where the pieces were split
+        roots[(*count)++] = t0;
+    }
     
-    // look both ways before crossing
-    if (WDBezierSegmentFindPointOnSegment_R(L, testPoint, tolerance, &nearestLeftPoint, &leftSplit, depth / 2.0f)) {
-        foundLeft = YES;
+    if (changes == 0 || *count == kWDNearestPointMaxRoots) {
+        return;
     }
-    if (WDBezierSegmentFindPointOnSegment_R(R, testPoint, tolerance, &nearestRightPoint, &rightSplit, depth / 2.0f)) {
-        foundRight = YES;
+    
+    if (changes == 1 || depth == kWDNearestPointMaxDepth) {
+        double s = (changes == 1) ? WDBernstein5Root(w) : 0.5;
+        
+        roots[(*count)++] = t0 + s * (t1 - t0);
+        return;
     }
+    
+    double left[6], right[6], mid = (t0 + t1) / 2;
+    
+    WDBernstein5Halve(w, left, right);
+    WDBernstein5Roots_R(left, t0, mid, depth + 1, roots, count);
+    WDBernstein5Roots_R(right, mid, t1, depth + 1, roots, count);
+}
 
-    if (foundLeft && foundRight) {
-        // since both halves found the point, choose the one that's actually closest
-        float leftDistance = WDDistance(nearestLeftPoint, testPoint);
-        float rightDistance = WDDistance(nearestRightPoint, testPoint);
-        
-        foundLeft = (leftDistance <= rightDistance) ? YES : NO;
-        foundRight = !foundLeft;
+CGPoint WDBezierSegmentNearestPoint(WDBezierSegment seg, CGPoint test, float *t)
+{
+    CGPoint c[4] = { WDSubtractPoints(seg.a_, test), WDSubtractPoints(seg.out_, test),
+                     WDSubtractPoints(seg.in_, test), WDSubtractPoints(seg.b_, test) };
+    CGPoint d[3];
+    double  w[6] = {0, 0, 0, 0, 0, 0};
+    double  candidates[kWDNearestPointMaxRoots + 2] = {0, 1};
+    int     count = 0;
+    
+    for (int j = 0; j < 3; j++) {
+        d[j] = WDMultiplyPointScalar(WDSubtractPoints(c[j + 1], c[j]), 3);
     }
     
-    if (foundLeft) {
-        if (nearestPoint) {
-            *nearestPoint = nearestLeftPoint;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 3; j++) {
+            w[i + j] += (c[i].x * d[j].x + c[i].y * d[j].y) * WDNearestPointZ[i][j];
         }
-        if (split) {
-            *split += leftSplit;
+    }
+    
+    // the ends, and the roots after them
+    WDBernstein5Roots_R(w, 0, 1, 0, candidates + 2, &count);
+    count += 2;
+    
+    double  bestDistance = MAXFLOAT, bestT = 0;
+    CGPoint nearest = seg.a_;
+    
+    for (int i = 0; i < count; i++) {
+        CGPoint p = WDBezierSegmentCalculatePointAtT(seg, candidates[i]);
+        double  dx = p.x - test.x, dy = p.y - test.y;
+        
+        if (dx * dx + dy * dy < bestDistance) {
+            bestDistance = dx * dx + dy * dy;
+            bestT = candidates[i];
+            nearest = p;
         }
-    } else if (foundRight) {
-        if (nearestPoint) {
-            *nearestPoint = nearestRightPoint;
+    }
+    
+    if (t) {
+        *t = bestT;
+    }
+    
+    return nearest;
+}
+
+static inline CGFloat WDDistanceToRect(CGPoint pt, CGRect rect)
+{
+    CGFloat dx = MAX(MAX(rect.origin.x - pt.x, pt.x - (rect.origin.x + rect.size.width)), 0);
+    CGFloat dy = MAX(MAX(rect.origin.y - pt.y, pt.y - (rect.origin.y + rect.size.height)), 0);
+    
+    return sqrt(dx * dx + dy * dy);
+}
+
+NSUInteger WDBezierSegmentsNearestPoint(const WDBezierSegment *segments, NSUInteger count, CGPoint test, float maxDistance,
+                                        CGPoint *nearest, float *t)
+{
+    NSUInteger  closest = NSNotFound;
+    float       bestDistance = maxDistance;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        // the curve lies within the bounds of its control points, so a segment whose bounds are too far can't win
+        if (WDDistanceToRect(test, WDBezierSegmentGetSimpleBounds(segments[i])) >= bestDistance) {
+            continue;
         }
-        if (split) {
-            *split += 0.5 * depth + rightSplit;
+        
+        float   segmentT;
+        CGPoint pt = WDBezierSegmentNearestPoint(segments[i], test, &segmentT);
+        float   distance = WDDistance(pt, test);
+        
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            closest = i;
+            
+            if (nearest) {
+                *nearest = pt;
+            }
+            if (t) {
+                *t = segmentT;
+            }
         }
     }
     
-    return (foundLeft || foundRight);
+    return closest;
 }
 
 BOOL WDBezierSegmentFindPointOnSegment(WDBezierSegment seg, CGPoint testPoint, float tolerance, CGPoint *nearestPoint, float *split)
 {
+    if (WDDistanceToRect(testPoint, WDBezierSegmentGetSimpleBounds(seg)) >= tolerance) {
+        return NO;
+    }
+    
+    float   t;
+    CGPoint nearest = WDBezierSegmentNearestPoint(seg, testPoint, &t);
+    
+    if (WDDistance(nearest, testPoint) >= tolerance) {
+        return NO;
+    }
+    
+    if (nearestPoint) {
+        *nearestPoint = nearest;
+    }
     if (split) {
-        *split = 0.0f;
+        *split = t;
     }
     
-    return WDBezierSegmentFindPointOnSegment_R(seg, testPoint, tolerance, nearestPoint, split, 1.0);
+    return YES;
 }
 
-CGPoint WDBezierSegmentPointAndTangentAtDistance(WDBezierSegment seg, float distance, CGPoint *tangent, float *curvature)
+static inline CGFloat WDBezierSegmentSpeedAtT(WDBezierSegment seg, CGFloat t)
 {
-    if (WDBezierSegmentIsStraight(seg)) {
-        float t = distance / WDDistance(seg.a_, seg.b_);
-        CGPoint point = WDMultiplyPointScalar(WDSubtractPoints(seg.b_, seg.a_), t);
-        point = WDAddPoints(seg.a_, point);
+    CGFloat mt = 1 - t;
+    CGFloat a = mt * mt, b = 2 * mt * t, c = t * t;
+    CGFloat dx = a * (seg.out_.x - seg.a_.x) + b * (seg.in_.x - seg.out_.x) + c * (seg.b_.x - seg.in_.x);
+    CGFloat dy = a * (seg.out_.y - seg.a_.y) + b * (seg.in_.y - seg.out_.y) + c * (seg.b_.y - seg.in_.y);
+    
+    return 3 * sqrt(dx * dx + dy * dy);
+}
+
+/*
+ * Arc length of the segment between t0 and t1, by 5 point Gauss-Legendre quadrature
+ */
+static CGFloat WDBezierSegmentArcLength(WDBezierSegment seg, CGFloat t0, CGFloat t1)
+{
+    static const CGFloat x[] = { 0.0, 0.5384693101056831, 0.9061798459386640 };
+    static const CGFloat w[] = { 0.5688888888888889, 0.4786286704993665, 0.2369268850561891 };
+    
+    CGFloat mid = (t0 + t1) / 2, half = (t1 - t0) / 2;
+    CGFloat sum = w[0] * WDBezierSegmentSpeedAtT(seg, mid);
+    
+    for (int i = 1; i < 3; i++) {
+        sum += w[i] * (WDBezierSegmentSpeedAtT(seg, mid - half * x[i]) + WDBezierSegmentSpeedAtT(seg, mid + half * x[i]));
+    }
+    
+    return sum * half;
+}
+
+void WDBezierArcLengthTableInit(WDBezierArcLengthTable *table, WDBezierSegment seg)
+{
+    CGFloat total = 0;
+    
+    table->segment = seg;
+    table->lengths[0] = 0;
+    
+    for (int i = 0; i < kWDArcLengthSamples; i++) {
+        total += WDBezierSegmentArcLength(seg, (CGFloat) i / kWDArcLengthSamples, (CGFloat) (i + 1) / kWDArcLengthSamples);
+        table->lengths[i + 1] = total;
+    }
+    
+    table->length = total;
+}
+
+/*
+ * Binary search for the samples around the distance, then Newton steps on the exact arc length
+ * from the sample below it.
+ */
+float WDBezierArcLengthTableTAtDistance(const WDBezierArcLengthTable *table, float distance)
+{
+    const float *lengths = table->lengths;
+    
+    if (distance <= 0) {
+        return 0;
+    } else if (distance >= table->length) {
+        return 1;
+    }
+    
+    int lo = 0, hi = kWDArcLengthSamples;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
         
-        if (tangent) {
-            *tangent = WDBezierSegmentTangetAtT(seg, t);
+        if (lengths[mid] <= distance) {
+            lo = mid;
+        } else {
+            hi = mid;
         }
+    }
+    
+    CGFloat t0 = (CGFloat) lo / kWDArcLengthSamples;
+    CGFloat t1 = (CGFloat) (lo + 1) / kWDArcLengthSamples;
+    CGFloat span = lengths[lo + 1] - lengths[lo];
+    CGFloat t = (span > 0) ? t0 + (t1 - t0) * (distance - lengths[lo]) / span : t0;
+    
+    for (int i = 0; i < 2; i++) {
+        CGFloat speed = WDBezierSegmentSpeedAtT(table->segment, t);
         
-        if (curvature) {
-            *curvature = 0.0;
+        if (speed < 1.0e-6) {
+            break;
         }
-        return WDBezierSegmentSplitAtT(seg, NULL, NULL, t);
+        
+        CGFloat error = lengths[lo] + WDBezierSegmentArcLength(table->segment, t0, t) - distance;
+        t = WDClamp(t0, t1, t - error / speed);
     }
     
-    CGPoint     current, last = seg.a_;
-    float       delta = 1.0f / 200.0f;
-    float       step, progress = 0;
+    return t;
+}
+
+/*
+ * The inverse of WDBezierArcLengthTableTAtDistance: the sample below t, plus the rule over the rest of its
+ * interval, so that a curve of any length is measured by the same pieces as the whole table.
+ */
+float WDBezierArcLengthTableDistanceAtT(const WDBezierArcLengthTable *table, float t)
+{
+    if (t <= 0) {
+        return 0;
+    } else if (t >= 1) {
+        return table->length;
+    }
     
-    for (float t = 0; t < (1.0f + delta); t += delta) {
-        current = WDBezierSegmentCalculatePointAtT(seg, t);
-        step = WDDistance(last, current);
+    int     lo = MIN((int) (t * kWDArcLengthSamples), kWDArcLengthSamples - 1);
+    CGFloat t0 = (CGFloat) lo / kWDArcLengthSamples;
+    
+    return table->lengths[lo] + WDBezierSegmentArcLength(table->segment, t0, t);
+}
+
+void WDBezierArcLengthTablePointsAtDistances(const WDBezierArcLengthTable *table, const float *distances, NSUInteger count,
+                                             CGPoint *points, CGPoint *tangents, float *curvatures)
+{
+    WDBezierSegment seg = table->segment;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        float t = WDBezierArcLengthTableTAtDistance(table, distances[i]);
         
-        if (progress + step >= distance) {
-            // it's between the current and last set of points          
-            float factor = (distance - progress) / step;
-            t = (t - delta) + factor * delta;
-            
-            if (tangent) {
-                *tangent = WDBezierSegmentTangetAtT(seg, t);
-            }
+        points[i] = WDBezierSegmentCalculatePointAtT(seg, t);
+        
+        if (tangents) {
+            tangents[i] = WDBezierSegmentTangetAtT(seg, t);
             
-            if (curvature) {
-                *curvature = WDBezierSegmentCurvatureAtT(seg, t);
+            if (tangents[i].x == 0 && tangents[i].y == 0) {
+                // a handle retracted into its anchor leaves no derivative at that end
+                tangents[i] = WDSubtractPoints(seg.b_, seg.a_);
             }
-            
-            return WDBezierSegmentSplitAtT(seg, NULL, NULL, t);
         }
         
-        progress += step;
-        last = current;
+        if (curvatures) {
+            curvatures[i] = WDBezierSegmentCurvatureAtT(seg, t);
+        }
     }
+}
+
+CGPoint WDBezierArcLengthTablePointAtDistance(const WDBezierArcLengthTable *table, float distance, CGPoint *tangent, float *curvature)
+{
+    CGPoint point;
+    
+    WDBezierArcLengthTablePointsAtDistances(table, &distance, 1, &point, tangent, curvature);
     
-    return CGPointZero;
+    return point;
 }
 
-void WDBezierSegmentFlatten(WDBezierSegment seg, CGPoint **vertices, NSUInteger *size, NSUInteger *index)
+CGPoint WDBezierSegmentPointAndTangentAtDistance(WDBezierSegment seg, float distance, CGPoint *tangent, float *curvature)
 {
-    if (*size < *index + 4) {
-        *size *= 2;
-        *vertices = realloc(*vertices, sizeof(CGPoint) * *size);
-    }
+    WDBezierArcLengthTable table;
     
-    if (WDBezierSegmentIsFlat(seg, kDefaultFlatness)) {
-        if (*index == 0) {
-            (*vertices)[*index] = seg.a_;
-            *index += 1;
-        }
-        
-        (*vertices)[*index] = seg.b_;
-        *index += 1;
-    } else {
-        WDBezierSegment L, R;
-        WDBezierSegmentSplit(seg, &L, &R);
-        
-        WDBezierSegmentFlatten(L, vertices, size, index);
-        WDBezierSegmentFlatten(R, vertices, size, index);
+    WDBezierArcLengthTableInit(&table, seg);
+    
+    return WDBezierArcLengthTablePointAtDistance(&table, distance, tangent, curvature);
+}
+
+void WDPointBufferReserve(WDPointBuffer *buffer, NSUInteger count)
+{
+    if (buffer->count + count > buffer->capacity) {
+        buffer->capacity = MAX(buffer->capacity * 2, buffer->count + count + 64);
+        buffer->points = realloc(buffer->points, sizeof(CGPoint) * buffer->capacity);
     }
 }
 
-CGRect WDBezierSegmentBounds(WDBezierSegment seg)
+void WDPointBufferAdd(WDPointBuffer *buffer, CGPoint pt)
+{
+    WDPointBufferReserve(buffer, 1);
+    buffer->points[buffer->count++] = pt;
+}
+
+void WDPointBufferFree(WDPointBuffer *buffer)
+{
+    free(buffer->points);
+    buffer->points = NULL;
+    buffer->count = buffer->capacity = 0;
+}
+
+/*
+ * Steps of t for a polyline within tolerance of the curve. The polyline through n evenly spaced points
+ * strays at most |B''| / 8n^2 from the curve, and |B''| is at most 6 times the largest second difference
+ * of the control points. Unlike WDBezierSegmentIsFlat, this holds for loops and for control points past
+ * the ends.
+ */
+NSUInteger WDBezierSegmentFlatteningSteps(WDBezierSegment seg, float tolerance)
+{
+    CGPoint dd1 = WDAddPoints(WDSubtractPoints(seg.a_, WDMultiplyPointScalar(seg.out_, 2)), seg.in_);
+    CGPoint dd2 = WDAddPoints(WDSubtractPoints(seg.out_, WDMultiplyPointScalar(seg.in_, 2)), seg.b_);
+    CGFloat dd = sqrt(MAX(dd1.x * dd1.x + dd1.y * dd1.y, dd2.x * dd2.x + dd2.y * dd2.y));
+    CGFloat steps = ceil(sqrt(0.75 * dd / MAX(tolerance, 1.0e-4f)));
+    
+    // a huge curve or a tiny tolerance shouldn't take all the memory
+    return (NSUInteger) WDClamp(1, kWDMaxFlatteningSteps, steps);
+}
+
+void WDBezierSegmentFlattenWithTolerance(WDBezierSegment seg, float tolerance, WDPointBuffer *buffer)
 {
-    NSUInteger  index = 0;
+    NSUInteger  steps = WDBezierSegmentFlatteningSteps(seg, tolerance);
     
-    if (!vertices) {
-        vertices = calloc(sizeof(CGPoint), size);
+    WDPointBufferReserve(buffer, steps + 1);
+    
+    if (buffer->count == 0) {
+        buffer->points[buffer->count++] = seg.a_;
     }
     
-    WDBezierSegmentFlatten(seg, &vertices, &size, &index);
+    // power basis, evaluated by Horner's rule: a + t (b + t (c + t d))
+    CGPoint     b = WDMultiplyPointScalar(WDSubtractPoints(seg.out_, seg.a_), 3);
+    CGPoint     c = WDMultiplyPointScalar(WDAddPoints(WDSubtractPoints(seg.a_, WDMultiplyPointScalar(seg.out_, 2)), seg.in_), 3);
+    CGPoint     d = WDSubtractPoints(WDAddPoints(WDMultiplyPointScalar(WDSubtractPoints(seg.out_, seg.in_), 3), seg.b_), seg.a_);
+    CGPoint     *points = buffer->points + buffer->count;
     
-    float   minX, maxX, minY, maxY;
+    for (NSUInteger i = 1; i < steps; i++) {
+        CGFloat t = (CGFloat) i / steps;
+        
+        points->x = seg.a_.x + t * (b.x + t * (c.x + t * d.x));
+        points->y = seg.a_.y + t * (b.y + t * (c.y + t * d.y));
+        points++;
+    }
     
-    minX = maxX = vertices[0].x;
-    minY = maxY = vertices[0].y;
+    // the end exactly, so that consecutive segments meet
+    *points = seg.b_;
+    buffer->count += steps;
+}
+
+void WDBezierSegmentsFlatten(const WDBezierSegment *segments, NSUInteger count, float tolerance, WDPointBuffer *buffer)
+{
+    for (NSUInteger i = 0; i < count; i++) {
+        WDBezierSegmentFlattenWithTolerance(segments[i], tolerance, buffer);
+    }
+}
+
+/*
+ * Grows [*min, *max] to the extrema of one coordinate of the cubic with control values p0..p3.
+ * The extrema inside the segment are at the roots of the derivative, which is the quadratic
+ * a t^2 + b t + c below (divided by 3).
+ */
+static inline void WDBezierAxisExtrema(CGFloat p0, CGFloat p1, CGFloat p2, CGFloat p3, CGFloat *min, CGFloat *max)
+{
+    // the curve stays within the hull of its control values, so there's nothing to solve
+    // when the handles lie between the end values (always the case for straight segments)
+    if (p1 >= *min && p1 <= *max && p2 >= *min && p2 <= *max) {
+        return;
+    }
     
-    for (int i = 1; i < index; i++) {
-        minX = MIN(minX, vertices[i].x);
-        maxX = MAX(maxX, vertices[i].x);
-        minY = MIN(minY, vertices[i].y);
-        maxY = MAX(maxY, vertices[i].y);
+    CGFloat d0 = p1 - p0, d1 = p2 - p1, d2 = p3 - p2;
+    CGFloat a = d0 - 2 * d1 + d2;
+    CGFloat b = 2 * (d1 - d0);
+    CGFloat c = d0;
+    CGFloat roots[2];
+    int     count = 0;
+    
+    if (fabs(a) < 1.0e-12) {
+        if (b != 0) {
+            roots[count++] = -c / b;
+        }
+    } else {
+        CGFloat disc = b * b - 4 * a * c;
+        
+        if (disc >= 0) {
+            // q is computed so that its two terms never cancel out
+            CGFloat q = -0.5 * (b + copysign(sqrt(disc), b));
+            
+            roots[count++] = q / a;
+            if (q != 0) {
+                roots[count++] = c / q;
+            }
+        }
     }
     
+    for (int i = 0; i < count; i++) {
+        CGFloat t = roots[i];
+        
+        if (t > 0 && t < 1) {
+            CGFloat mt = 1 - t;
+            CGFloat v = mt * mt * mt * p0 + 3 * mt * t * (mt * p1 + t * p2) + t * t * t * p3;
+            
+            *min = MIN(*min, v);
+            *max = MAX(*max, v);
+        }
+    }
+}
+
+/*
+ * Exact bounds of the segment: the end points, grown to the extrema of each coordinate.
+ * Uses no shared state, so it can be called from any thread.
+ */
+CGRect WDBezierSegmentBounds(WDBezierSegment seg)
+{
+    CGFloat minX = MIN(seg.a_.x, seg.b_.x), maxX = MAX(seg.a_.x, seg.b_.x);
+    CGFloat minY = MIN(seg.a_.y, seg.b_.y), maxY = MAX(seg.a_.y, seg.b_.y);
+    
+    WDBezierAxisExtrema(seg.a_.x, seg.out_.x, seg.in_.x, seg.b_.x, &minX, &maxX);
+    WDBezierAxisExtrema(seg.a_.y, seg.out_.y, seg.in_.y, seg.b_.y, &minY, &maxY);
+    
     return CGRectMake(minX, minY, maxX - minX, maxY - minY);
 }
 
+void WDBezierSegmentBoundsArray(const WDBezierSegment *segments, CGRect *bounds, NSUInteger count)
+{
+    for (NSUInteger i = 0; i < count; i++) {
+        bounds[i] = WDBezierSegmentBounds(segments[i]);
+    }
+}
+
 float base3(double t, double p1, double p2, double p3, double p4)
 {
     float t1 = -3*p1 + 9*p2 - 9*p3 + 3*p4;
@@ -570,25 +900,14 @@ float WDBezierSegmentLength(WDBezierSegment seg)
 
 CGPoint WDBezierSegmentGetClosestPoint(WDBezierSegment seg, CGPoint test, float *error, float *distance)
 {
-    float       delta = 0.001f;
-    float       sum = 0.0f;
-    float       smallestDistance = MAXFLOAT;
-    CGPoint     closest, current, last = seg.a_;
+    float   t;
+    CGPoint closest = WDBezierSegmentNearestPoint(seg, test, &t);
     
-    for (float t = 0; t < (1.0f + delta); t += delta) {
-        current = WDBezierSegmentCalculatePointAtT(seg, t);
-        sum += WDDistance(last, current);
-        
-        float testDistance = WDDistance(current, test);
-        if (testDistance < smallestDistance) {
-            smallestDistance = testDistance;
-            *error = testDistance;
-            *distance = sum;
-            closest = current;
-        }
-        
-        last = current;
-    }
+    WDBezierArcLengthTable table;
+    WDBezierArcLengthTableInit(&table, seg);
+    
+    *error = WDDistance(closest, test);
+    *distance = WDBezierArcLengthTableDistanceAtT(&table, t);
     
     return closest;
 }
@@ -716,3 +1035,453 @@ BOOL WDBezierSegmentPointDistantFromPoint(WDBezierSegment seg, float distance, C
     
     return NO;
 }
+
+/*
+ * Curve intersections
+ *
+ * A binary tree of bounds over each run of segments (each node covers a range of consecutive segments, which
+ * lie close together on a path) prunes the pairs of segments whose bounds miss. The pairs that remain are
+ * subdivided: a piece of one curve is dropped when the other piece's control points all lie outside its fat
+ * line (the band around its chord that holds its own control points), and the pieces that survive until they
+ * are flat are intersected as lines. Flat pieces that come within tolerance without crossing (tangent curves)
+ * are reported at their closest points. Curves that run along each other meet everywhere, and nothing would
+ * prune their pieces: such a pair is reported by the two ends of the stretch they share instead, and the hits
+ * of any one pair are capped.
+ */
+
+#define kWDIntersectionMaxDepth 48
+#define kWDIntersectionMaxHits  32      // per pair of segments; two cubics cross at most 9 times
+
+typedef struct {
+    WDBezierIntersection    *items;
+    NSUInteger              count, capacity;
+} WDIntersectionList;
+
+static NSUInteger WDSegmentTreeBuild_R(const WDBezierSegment *segments, NSUInteger first, NSUInteger count, WDSegmentTreeNode *nodes, NSUInteger *nodeCount)
+{
+    NSUInteger          index = (*nodeCount)++;
+    WDSegmentTreeNode   *node = &nodes[index];
+    
+    node->first = first;
+    node->count = count;
+    
+    if (count == 1) {
+        node->bounds = WDBezierSegmentGetSimpleBounds(segments[first]);
+    } else {
+        NSUInteger half = count / 2;
+        NSUInteger left = WDSegmentTreeBuild_R(segments, first, half, nodes, nodeCount);
+        NSUInteger right = WDSegmentTreeBuild_R(segments, first + half, count - half, nodes, nodeCount);
+        
+        node->right = right;
+        node->bounds = CGRectUnion(nodes[left].bounds, nodes[right].bounds);
+    }
+    
+    return index;
+}
+
+void WDSegmentTreeBuild(const WDBezierSegment *segments, NSUInteger count, WDSegmentTreeNode *nodes)
+{
+    NSUInteger nodeCount = 0;
+    
+    if (count > 0) {
+        WDSegmentTreeBuild_R(segments, 0, count, nodes, &nodeCount);
+    }
+}
+
+static inline BOOL WDRectsMeet(CGRect a, CGRect b)
+{
+    // unlike CGRectIntersectsRect, this holds for the flat bounds of a straight horizontal or vertical segment
+    return (a.origin.x <= b.origin.x + b.size.width && b.origin.x <= a.origin.x + a.size.width &&
+            a.origin.y <= b.origin.y + b.size.height && b.origin.y <= a.origin.y + a.size.height);
+}
+
+static BOOL WDSegmentTreeEnumerate_R(const WDSegmentTreeNode *nodes, NSUInteger index, CGRect rect,
+                                     void (^block)(NSUInteger segment, BOOL *stop))
+{
+    const WDSegmentTreeNode *node = &nodes[index];
+    BOOL                    stop = NO;
+    
+    if (!WDRectsMeet(node->bounds, rect)) {
+        return NO;
+    }
+    
+    if (node->count == 1) {
+        block(node->first, &stop);
+        return stop;
+    }
+    
+    return (WDSegmentTreeEnumerate_R(nodes, index + 1, rect, block) ||
+            WDSegmentTreeEnumerate_R(nodes, node->right, rect, block));
+}
+
+void WDSegmentTreeEnumerateSegmentsInRect(const WDSegmentTreeNode *nodes, CGRect rect, void (^block)(NSUInteger segment, BOOL *stop))
+{
+    if (nodes) {
+        WDSegmentTreeEnumerate_R(nodes, 0, rect, block);
+    }
+}
+
+static void WDIntersectionListAdd(WDIntersectionList *list, NSUInteger segment1, CGFloat t1, NSUInteger segment2, CGFloat t2)
+{
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity * 2 + 16;
+        list->items = realloc(list->items, list->capacity * sizeof(WDBezierIntersection));
+    }
+    
+    list->items[list->count++] = (WDBezierIntersection) {segment1, segment2, t1, t2};
+}
+
+static inline void WDBezierSegmentHalve(WDBezierSegment seg, WDBezierSegment *L, WDBezierSegment *R)
+{
+    CGPoint ab = WDAveragePoints(seg.a_, seg.out_);
+    CGPoint bc = WDAveragePoints(seg.out_, seg.in_);
+    CGPoint cd = WDAveragePoints(seg.in_, seg.b_);
+    CGPoint abc = WDAveragePoints(ab, bc);
+    CGPoint bcd = WDAveragePoints(bc, cd);
+    CGPoint mid = WDAveragePoints(abc, bcd);
+    
+    *L = (WDBezierSegment) {seg.a_, ab, abc, mid};
+    *R = (WDBezierSegment) {mid, bcd, cd, seg.b_};
+}
+
+// distance from the chord of seg to its farthest control point, and the chord length
+static inline CGFloat WDBezierSegmentChordDeviation(WDBezierSegment seg, CGFloat *chordLength)
+{
+    CGPoint chord = WDSubtractPoints(seg.b_, seg.a_);
+    CGFloat length = sqrt(chord.x * chord.x + chord.y * chord.y);
+    
+    *chordLength = length;
+    if (length == 0) {
+        return MAX(WDDistance(seg.out_, seg.a_), WDDistance(seg.in_, seg.a_));
+    }
+    
+    CGFloat d1 = ((seg.out_.x - seg.a_.x) * chord.y - (seg.out_.y - seg.a_.y) * chord.x) / length;
+    CGFloat d2 = ((seg.in_.x - seg.a_.x) * chord.y - (seg.in_.y - seg.a_.y) * chord.x) / length;
+    
+    return MAX(fabs(d1), fabs(d2));
+}
+
+// YES if all the control points of b lie outside the fat line of a, grown by tolerance
+static BOOL WDFatLineExcludes(WDBezierSegment a, WDBezierSegment b, CGFloat tolerance)
+{
+    CGPoint chord = WDSubtractPoints(a.b_, a.a_);
+    CGFloat length = sqrt(chord.x * chord.x + chord.y * chord.y);
+    
+    if (length == 0) {
+        return NO;
+    }
+    
+    CGPoint normal = CGPointMake(-chord.y / length, chord.x / length);
+    CGFloat d1 = (a.out_.x - a.a_.x) * normal.x + (a.out_.y - a.a_.y) * normal.y;
+    CGFloat d2 = (a.in_.x - a.a_.x) * normal.x + (a.in_.y - a.a_.y) * normal.y;
+    CGFloat dMin = MIN(0, MIN(d1, d2)) - tolerance;
+    CGFloat dMax = MAX(0, MAX(d1, d2)) + tolerance;
+    CGPoint pts[4] = {b.a_, b.out_, b.in_, b.b_};
+    BOOL    below = YES, above = YES;
+    
+    for (int i = 0; i < 4; i++) {
+        CGFloat d = (pts[i].x - a.a_.x) * normal.x + (pts[i].y - a.a_.y) * normal.y;
+        below = below && (d < dMin);
+        above = above && (d > dMax);
+    }
+    
+    return below || above;
+}
+
+// parameter on ab of the point closest to p
+static inline CGFloat WDClosestOnLine(CGPoint p, CGPoint a, CGPoint b)
+{
+    CGPoint ab = WDSubtractPoints(b, a);
+    CGFloat length = ab.x * ab.x + ab.y * ab.y;
+    
+    return (length > 0) ? MIN(MAX(((p.x - a.x) * ab.x + (p.y - a.y) * ab.y) / length, 0), 1) : 0;
+}
+
+// intersects the chords of two flat pieces; r and s are the parameters along them
+static BOOL WDIntersectChords(CGPoint A, CGPoint B, CGPoint C, CGPoint D, CGFloat tolerance, CGFloat *r, CGFloat *s)
+{
+    CGFloat denom = (B.x - A.x) * (D.y - C.y) - (B.y - A.y) * (D.x - C.x);
+    
+    if (denom != 0) {
+        *r = ((A.y - C.y) * (D.x - C.x) - (A.x - C.x) * (D.y - C.y)) / denom;
+        *s = ((A.y - C.y) * (B.x - A.x) - (A.x - C.x) * (B.y - A.y)) / denom;
+        
+        if (*r >= 0 && *r <= 1 && *s >= 0 && *s <= 1) {
+            return YES;
+        }
+    }
+    
+    // no crossing: take the closest pair of points, which is at an end of one of the chords
+    CGFloat rs[4][2], best = MAXFLOAT;
+    
+    rs[0][0] = 0; rs[0][1] = WDClosestOnLine(A, C, D);
+    rs[1][0] = 1; rs[1][1] = WDClosestOnLine(B, C, D);
+    rs[2][1] = 0; rs[2][0] = WDClosestOnLine(C, A, B);
+    rs[3][1] = 1; rs[3][0] = WDClosestOnLine(D, A, B);
+    
+    for (int i = 0; i < 4; i++) {
+        CGPoint p = WDAddPoints(A, WDMultiplyPointScalar(WDSubtractPoints(B, A), rs[i][0]));
+        CGPoint q = WDAddPoints(C, WDMultiplyPointScalar(WDSubtractPoints(D, C), rs[i][1]));
+        CGFloat distance = WDDistance(p, q);
+        
+        if (distance < best) {
+            best = distance;
+            *r = rs[i][0];
+            *s = rs[i][1];
+        }
+    }
+    
+    return (best <= tolerance);
+}
+
+static inline CGPoint WDBezierSegmentPointAndTangentAtT(WDBezierSegment seg, CGFloat t, CGPoint *tangent)
+{
+    CGFloat u = 1 - t;
+    
+    tangent->x = 3 * (u * u * (seg.out_.x - seg.a_.x) + 2 * u * t * (seg.in_.x - seg.out_.x) + t * t * (seg.b_.x - seg.in_.x));
+    tangent->y = 3 * (u * u * (seg.out_.y - seg.a_.y) + 2 * u * t * (seg.in_.y - seg.out_.y) + t * t * (seg.b_.y - seg.in_.y));
+    
+    return CGPointMake(u * u * u * seg.a_.x + 3 * u * u * t * seg.out_.x + 3 * u * t * t * seg.in_.x + t * t * t * seg.b_.x,
+                       u * u * u * seg.a_.y + 3 * u * u * t * seg.out_.y + 3 * u * t * t * seg.in_.y + t * t * t * seg.b_.y);
+}
+
+// the chords only place a crossing within the flatness of the pieces, and their parameters don't follow the
+// curves' ones: a few Newton steps on a(t1) - b(t2) = 0 fix both, as long as they stay near the pieces
+static void WDRefineIntersection(WDBezierSegment a, WDBezierSegment b, CGFloat span, CGFloat *t1, CGFloat *t2)
+{
+    CGFloat s1 = *t1, s2 = *t2;
+    CGPoint da, db;
+    CGPoint delta = WDSubtractPoints(WDBezierSegmentPointAndTangentAtT(b, s2, &db), WDBezierSegmentPointAndTangentAtT(a, s1, &da));
+    CGFloat start = delta.x * delta.x + delta.y * delta.y, error = start;
+    
+    for (int i = 0; i < 4 && error > 0; i++) {
+        CGFloat det = db.x * da.y - da.x * db.y;
+        
+        if (fabs(det) < 1e-12) {
+            // tangent curves: the chords did as well as it gets
+            return;
+        }
+        
+        s1 = MIN(MAX(s1 + (db.x * delta.y - delta.x * db.y) / det, 0), 1);
+        s2 = MIN(MAX(s2 + (da.x * delta.y - da.y * delta.x) / det, 0), 1);
+        delta = WDSubtractPoints(WDBezierSegmentPointAndTangentAtT(b, s2, &db), WDBezierSegmentPointAndTangentAtT(a, s1, &da));
+        error = delta.x * delta.x + delta.y * delta.y;
+    }
+    
+    if (error < start && fabs(s1 - *t1) <= span && fabs(s2 - *t2) <= span) {
+        *t1 = s1;
+        *t2 = s2;
+    }
+}
+
+// the part of seg from t0 to t1, reversed if t1 < t0
+static WDBezierSegment WDBezierSegmentRange(WDBezierSegment seg, CGFloat t0, CGFloat t1)
+{
+    if (t1 < t0) {
+        WDBezierSegment range = WDBezierSegmentRange(seg, t1, t0);
+        return (WDBezierSegment) {range.b_, range.in_, range.out_, range.a_};
+    }
+    
+    WDBezierSegment L, R;
+    
+    if (t1 < 1) {
+        WDBezierSegmentSplitAtT(seg, &seg, NULL, t1);
+        t0 = (t1 > 0) ? t0 / t1 : 0;
+    }
+    if (t0 > 0) {
+        WDBezierSegmentSplitAtT(seg, &L, &R, t0);
+        seg = R;
+    }
+    
+    return seg;
+}
+
+// if a and b share a stretch (within tolerance), reports its two ends and returns YES: the ends of each curve
+// that lie on the other bound the stretch, and the parts of both curves between them must match
+static BOOL WDIntersectOverlap(WDBezierSegment a, WDBezierSegment b, CGFloat tolerance,
+                               NSUInteger segment1, NSUInteger segment2, WDIntersectionList *list)
+{
+    CGFloat ends[4][2];
+    int     count = 0;
+    float   t;
+    
+    for (int i = 0; i < 2; i++) {
+        CGPoint end = i ? a.b_ : a.a_;
+        
+        if (WDDistance(WDBezierSegmentNearestPoint(b, end, &t), end) <= tolerance) {
+            ends[count][0] = i;
+            ends[count++][1] = t;
+        }
+        
+        end = i ? b.b_ : b.a_;
+        if (WDDistance(WDBezierSegmentNearestPoint(a, end, &t), end) <= tolerance) {
+            ends[count][0] = t;
+            ends[count++][1] = i;
+        }
+    }
+    
+    if (count < 2) {
+        return NO;
+    }
+    
+    int first = 0, last = 0;
+    for (int i = 1; i < count; i++) {
+        first = (ends[i][0] < ends[first][0]) ? i : first;
+        last = (ends[i][0] > ends[last][0]) ? i : last;
+    }
+    
+    WDBezierSegment rangeA = WDBezierSegmentRange(a, ends[first][0], ends[last][0]);
+    WDBezierSegment rangeB = WDBezierSegmentRange(b, ends[first][1], ends[last][1]);
+    
+    if (WDDistance(rangeA.a_, rangeA.b_) <= tolerance) {
+        // the ends meet at one spot: a crossing or a touch, not a stretch
+        return NO;
+    }
+    
+    CGFloat length;
+    BOOL    flat = (WDBezierSegmentChordDeviation(rangeA, &length) <= tolerance / 4 &&
+                    WDBezierSegmentChordDeviation(rangeB, &length) <= tolerance / 4);
+    
+    // matching control points keep the curves within tolerance of each other; flat stretches only need
+    // matching ends, since a straight segment's handles can be anywhere along it
+    if (!flat && (WDDistance(rangeA.out_, rangeB.out_) > tolerance || WDDistance(rangeA.in_, rangeB.in_) > tolerance)) {
+        return NO;
+    }
+    
+    WDIntersectionListAdd(list, segment1, ends[first][0], segment2, ends[first][1]);
+    WDIntersectionListAdd(list, segment1, ends[last][0], segment2, ends[last][1]);
+    return YES;
+}
+
+static void WDIntersectPieces(WDBezierSegment a, CGFloat a0, CGFloat a1, WDBezierSegment b, CGFloat b0, CGFloat b1,
+                              WDBezierSegment root1, WDBezierSegment root2, CGFloat tolerance, int depth,
+                              NSUInteger segment1, NSUInteger segment2, NSUInteger maxCount, WDIntersectionList *list)
+{
+    if (list->count >= maxCount) {
+        return;
+    }
+    
+    CGRect aBounds = CGRectInset(WDBezierSegmentGetSimpleBounds(a), -tolerance, -tolerance);
+    
+    if (!CGRectIntersectsRect(aBounds, WDBezierSegmentGetSimpleBounds(b))) {
+        return;
+    }
+    
+    if (WDFatLineExcludes(a, b, tolerance) || WDFatLineExcludes(b, a, tolerance)) {
+        return;
+    }
+    
+    CGFloat aLength, bLength;
+    BOOL    aFlat = WDBezierSegmentChordDeviation(a, &aLength) <= tolerance / 4;
+    BOOL    bFlat = WDBezierSegmentChordDeviation(b, &bLength) <= tolerance / 4;
+    
+    if ((aFlat && bFlat) || depth == kWDIntersectionMaxDepth) {
+        CGFloat r, s;
+        
+        if (WDIntersectChords(a.a_, a.b_, b.a_, b.b_, tolerance, &r, &s)) {
+            CGFloat t1 = a0 + r * (a1 - a0), t2 = b0 + s * (b1 - b0);
+            
+            WDRefineIntersection(root1, root2, MAX(a1 - a0, b1 - b0), &t1, &t2);
+            WDIntersectionListAdd(list, segment1, t1, segment2, t2);
+        }
+        return;
+    }
+    
+    WDBezierSegment L, R;
+    
+    // split the piece that isn't flat yet, or the longer one
+    if (!aFlat && (bFlat || aLength >= bLength)) {
+        CGFloat aMid = (a0 + a1) / 2;
+        
+        WDBezierSegmentHalve(a, &L, &R);
+        WDIntersectPieces(L, a0, aMid, b, b0, b1, root1, root2, tolerance, depth + 1, segment1, segment2, maxCount, list);
+        WDIntersectPieces(R, aMid, a1, b, b0, b1, root1, root2, tolerance, depth + 1, segment1, segment2, maxCount, list);
+    } else {
+        CGFloat bMid = (b0 + b1) / 2;
+        
+        WDBezierSegmentHalve(b, &L, &R);
+        WDIntersectPieces(a, a0, a1, L, b0, bMid, root1, root2, tolerance, depth + 1, segment1, segment2, maxCount, list);
+        WDIntersectPieces(a, a0, a1, R, bMid, b1, root1, root2, tolerance, depth + 1, segment1, segment2, maxCount, list);
+    }
+}
+
+static void WDIntersectTrees(const WDBezierSegment *a, WDSegmentTreeNode *aNodes, NSUInteger aIndex,
+                             const WDBezierSegment *b, WDSegmentTreeNode *bNodes, NSUInteger bIndex,
+                             CGFloat tolerance, WDIntersectionList *list)
+{
+    WDSegmentTreeNode *aNode = &aNodes[aIndex], *bNode = &bNodes[bIndex];
+    
+    if (!CGRectIntersectsRect(CGRectInset(aNode->bounds, -tolerance, -tolerance), bNode->bounds)) {
+        return;
+    }
+    
+    if (aNode->count == 1 && bNode->count == 1) {
+        NSUInteger first = list->count;
+        
+        WDBezierSegment segment1 = a[aNode->first], segment2 = b[bNode->first];
+        
+        if (WDIntersectOverlap(segment1, segment2, tolerance, aNode->first, bNode->first, list)) {
+            return;
+        }
+        
+        WDIntersectPieces(segment1, 0, 1, segment2, 0, 1, segment1, segment2, tolerance, 0, aNode->first, bNode->first,
+                          first + kWDIntersectionMaxHits, list);
+        
+        // neighboring pieces can both report the same hit: keep one per spot
+        for (NSUInteger i = first + 1; i < list->count; i++) {
+            WDBezierIntersection *hit = &list->items[i];
+            CGPoint p = WDBezierSegmentCalculatePointAtT(segment1, hit->t1);
+            
+            for (NSUInteger j = first; j < i; j++) {
+                if (WDDistance(p, WDBezierSegmentCalculatePointAtT(segment1, list->items[j].t1)) <= tolerance) {
+                    list->items[i--] = list->items[--list->count];
+                    break;
+                }
+            }
+        }
+        return;
+    }
+    
+    // descend into the bigger node
+    if (bNode->count == 1 || (aNode->count > 1 && aNode->count >= bNode->count)) {
+        WDIntersectTrees(a, aNodes, aIndex + 1, b, bNodes, bIndex, tolerance, list);
+        WDIntersectTrees(a, aNodes, aNode->right, b, bNodes, bIndex, tolerance, list);
+    } else {
+        WDIntersectTrees(a, aNodes, aIndex, b, bNodes, bIndex + 1, tolerance, list);
+        WDIntersectTrees(a, aNodes, aIndex, b, bNodes, bNode->right, tolerance, list);
+    }
+}
+
+static int WDCompareIntersections(const void *x, const void *y)
+{
+    const WDBezierIntersection *p = x, *q = y;
+    
+    if (p->segment1 != q->segment1) {
+        return (p->segment1 < q->segment1) ? -1 : 1;
+    }
+    
+    return (p->t1 < q->t1) ? -1 : ((p->t1 > q->t1) ? 1 : 0);
+}
+
+NSUInteger WDBezierSegmentsIntersect(const WDBezierSegment *a, NSUInteger countA, const WDBezierSegment *b, NSUInteger countB,
+                                     float tolerance, WDBezierIntersection **intersections)
+{
+    WDIntersectionList list = {NULL, 0, 0};
+    
+    if (countA > 0 && countB > 0) {
+        WDSegmentTreeNode   *aNodes = malloc((2 * countA - 1) * sizeof(WDSegmentTreeNode));
+        WDSegmentTreeNode   *bNodes = malloc((2 * countB - 1) * sizeof(WDSegmentTreeNode));
+        
+        WDSegmentTreeBuild(a, countA, aNodes);
+        WDSegmentTreeBuild(b, countB, bNodes);
+        WDIntersectTrees(a, aNodes, 0, b, bNodes, 0, tolerance, &list);
+        
+        free(aNodes);
+        free(bNodes);
+        
+        qsort(list.items, list.count, sizeof(WDBezierIntersection), WDCompareIntersections);
+    }
+    
+    *intersections = list.items;
+    return list.count;
+}
@@ -11,6 +11,7 @@
 
 #import "WDColor.h"
 #import "WDCompoundPath.h"
+#import "WDCurveFit.h"
 #import "WDFillTransform.h"
 #import "WDLayer.h"
 #import "WDPath.h"
@@ -340,21 +341,46 @@ NSString *WDSubpathsKey = @"WDSubpathsKey";
     }
 }
 
+- (BOOL) erasesWithPathfinder
+{
+    return self.fill ? YES : NO;
+}
+
+- (NSArray *) eraseResult:(WDAbstractPath *)erased
+{
+    if (erased) {
+        [erased takeStylePropertiesFrom:self];
+        return @[erased];
+    }
+    
+    return @[];
+}
+
 - (NSArray *) erase:(WDAbstractPath *)erasePath
 {
     if (self.fill) {
-        WDAbstractPath *erased = [WDPathfinder combinePaths:@[self, erasePath] operation:WDPathFinderSubtract];
-        
-        if (erased) {
-            [erased takeStylePropertiesFrom:self];
-            return @[erased];
-        }
+        return [self eraseResult:[WDPathfinder combinePaths:@[self, erasePath] operation:WDPathFinderSubtract]];
     } else {
         NSMutableArray *result = [NSMutableArray array];
+        NSMutableArray *closedPaths = [NSMutableArray array];
+        
+        // erase each subpath individually, the closed ones in one batch
+        for (WDPath *path in subpaths_) {
+            if ([path erasesWithPathfinder]) {
+                [closedPaths addObject:path];
+            }
+        }
+        
+        NSArray     *differences = [WDPathfinder erasePaths:closedPaths withPath:erasePath];
+        NSUInteger  differenceIx = 0;
         
-        // erase each subpath individually
         for (WDPath *path in subpaths_) {
-            [result addObjectsFromArray:[path erase:erasePath]];
+            if ([path erasesWithPathfinder]) {
+                id difference = differences[differenceIx++];
+                [result addObjectsFromArray:[path eraseResult:(difference == [NSNull null]) ? nil : difference]];
+            } else {
+                [result addObjectsFromArray:[path erase:erasePath]];
+            }
         }
         
         if (result.count > 1) {
@@ -384,6 +410,11 @@ NSString *WDSubpathsKey = @"WDSubpathsKey";
     [subpaths_ makeObjectsPerformSelector:@selector(flatten)];
 }
 
+- (void) reduceNodesWithTolerance:(float)tolerance
+{
+    [WDCurveFit reduceNodesOfPaths:subpaths_ tolerance:tolerance];
+}
+
 - (WDAbstractPath *) pathByFlatteningPath
 {
     WDCompoundPath *cp = [[WDCompoundPath alloc] init];
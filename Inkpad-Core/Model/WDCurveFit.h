@@ -10,9 +10,42 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "FitCurves.h"
 
 @class WDPath;
 
 @interface WDCurveFit : NSObject
 + (WDPath *) smoothPathForPoints:(NSArray *)points error:(float)epsilon attemptToClose:(BOOL)shouldClose;
+
+// the same for an unboxed buffer (the ends are averaged in place when the path closes); the points are
+// split at the corners sharper than cornerAngle (M_PI for none), and the spans between fitted concurrently
++ (WDPath *) smoothPathForPoints:(CGPoint *)points count:(NSUInteger)count error:(float)epsilon cornerAngle:(float)cornerAngle
+                  attemptToClose:(BOOL)shouldClose;
+
+// replaces the nodes of each path by as few as it takes to stay within tolerance of its outline (see ReduceSegments)
+// the paths are read and updated on the calling thread, and reduced concurrently in between
++ (void) reduceNodesOfPaths:(NSArray *)paths tolerance:(float)tolerance;
+@end
+
+//
+// Fits the points of a stroke as they arrive, so that the curves are ready when it ends
+//
+@interface WDIncrementalCurveFit : NSObject {
+    FitCurveStream  stream_;
+    float           epsilon_;
+}
+
+@property (nonatomic, readonly) NSUInteger pointCount;
+@property (nonatomic, readonly) CGPoint firstPoint;
+@property (nonatomic, readonly) CGPoint lastPoint;
+
+- (id) initWithError:(float)epsilon;
+- (void) addPoint:(CGPoint)pt;
+
+// the nodes of the fit so far, as an open path; the nodes of the frozen segments are taken from
+// nodes (empty, or returned by an earlier call) rather than made again
+- (NSMutableArray *) nodesUpdatingNodes:(NSArray *)nodes;
+
+// the fitted path, closed under the same conditions as +smoothPathForPoints:error:attemptToClose:
+- (WDPath *) smoothPathAttemptingToClose:(BOOL)shouldClose;
 @end
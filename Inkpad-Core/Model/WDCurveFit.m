@@ -20,34 +20,123 @@
 
 + (WDPath *) smoothPathForPoints:(NSArray *)inPoints error:(float)epsilon attemptToClose:(BOOL)shouldClose
 {
-    NSMutableArray  *points = [inPoints mutableCopy];
-    CGPoint         unboxedPts[points.count];
-    BOOL            closePath = NO;
+    NSUInteger      count = inPoints.count;
+    CGPoint         *unboxedPts = malloc(count * sizeof(CGPoint));
     int             ix = 0;
     
     // transfer the wrapped CGPoints to an unboxed array
-    for (NSValue *value in points) {
+    for (NSValue *value in inPoints) {
         unboxedPts[ix++] = [value CGPointValue];
     }
     
+    WDPath *path = [WDCurveFit smoothPathForPoints:unboxedPts count:count error:epsilon cornerAngle:M_PI attemptToClose:shouldClose];
+    
+    free(unboxedPts);
+    return path;
+}
+
++ (WDPath *) smoothPathForPoints:(CGPoint *)points count:(NSUInteger)count error:(float)epsilon cornerAngle:(float)cornerAngle
+                  attemptToClose:(BOOL)shouldClose
+{
+    BOOL            closePath = NO;
+    
     // see if this path should be closed, and if so, average the first and last points
-    if (shouldClose && points.count > 3) {
-        CGPoint first = unboxedPts[0];
-        CGPoint last = unboxedPts[points.count - 1];
+    if (shouldClose && count > 3) {
+        CGPoint first = points[0];
+        CGPoint last = points[count - 1];
         
         if (WDDistance(first, last) < (epsilon * 2)) {
             closePath = YES;
-            unboxedPts[0] = WDAveragePoints(first, last);
-            unboxedPts[points.count - 1] = unboxedPts[0];
+            points[0] = WDAveragePoints(first, last);
+            points[count - 1] = points[0];
         }
     }
     
-    // finally, do the actual curve fitting!
-    WDBezierSegment segments[points.count];
-    int numSegments = FitCurve(segments, unboxedPts, (int) points.count, epsilon);
+    // finally, do the actual curve fitting! (on the heap: long tracings would overflow the stack)
+    WDBezierSegment *segments = malloc(MAX(count, 1) * sizeof(WDBezierSegment));
+    int numSegments = FitCurveAtCorners(segments, points, (int) count, epsilon, cornerAngle);
     
     // ... and turn those segments into an Inkpad path
-    return [WDCurveFit pathFromSegments:segments numSegments:numSegments closePath:closePath];
+    WDPath *path = [WDCurveFit pathFromSegments:segments numSegments:numSegments closePath:closePath];
+    
+    free(segments);
+    return path;
+}
+
++ (void) reduceNodesOfPaths:(NSArray *)paths tolerance:(float)tolerance
+{
+    NSUInteger          count = paths.count;
+    
+    if (count == 0) {
+        return;
+    }
+    
+    WDBezierSegment     **segments = calloc(count, sizeof(WDBezierSegment *));
+    int                 *segmentCounts = calloc(count, sizeof(int));
+    WDBezierSegment     **reduced = calloc(count, sizeof(WDBezierSegment *));
+    int                 *reducedCounts = calloc(count, sizeof(int));
+    BOOL                *closed = calloc(count, sizeof(BOOL));
+    
+    // the nodes are read here, on the calling thread; paths with fewer than 3 nodes keep a count of 0
+    for (NSUInteger t = 0; t < count; t++) {
+        WDPath  *path = paths[t];
+        NSArray *nodes = path.nodes;
+        
+        if (nodes.count < 3) {
+            continue;
+        }
+        
+        closed[t] = path.closed;
+        segmentCounts[t] = (int) (closed[t] ? nodes.count : nodes.count - 1);
+        segments[t] = malloc(segmentCounts[t] * sizeof(WDBezierSegment));
+        
+        for (int i = 0; i < segmentCounts[t]; i++) {
+            segments[t][i] = WDBezierSegmentMake(nodes[i], nodes[(i + 1) % nodes.count]);
+        }
+    }
+    
+    // the reduction only touches the segments, so the paths are reduced in parallel
+    size_t  workers = MIN(count, [NSProcessInfo processInfo].activeProcessorCount);
+    
+    dispatch_apply(workers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t worker) {
+        for (size_t t = worker; t < count; t += workers) {
+            if (segmentCounts[t] > 0) {
+                reducedCounts[t] = ReduceSegments(segments[t], segmentCounts[t], closed[t], tolerance, &reduced[t]);
+            }
+        }
+    });
+    
+    for (NSUInteger t = 0; t < count; t++) {
+        if (reducedCounts[t] > 0 && reducedCounts[t] < segmentCounts[t]) {
+            WDPath          *path = paths[t];
+            WDBezierSegment *newSegments = reduced[t];
+            int             numSegments = reducedCounts[t];
+            NSMutableArray  *nodes = [NSMutableArray array];
+            
+            // an open path keeps the outer handles of its end nodes
+            for (int i = 0; i < numSegments; i++) {
+                CGPoint inPoint = (i > 0) ? newSegments[i-1].in_ : (closed[t] ? newSegments[numSegments - 1].in_ : [path firstNode].inPoint);
+                [nodes addObject:[WDBezierNode bezierNodeWithInPoint:inPoint anchorPoint:newSegments[i].a_ outPoint:newSegments[i].out_]];
+            }
+            
+            if (!closed[t]) {
+                [nodes addObject:[WDBezierNode bezierNodeWithInPoint:newSegments[numSegments - 1].in_
+                                                         anchorPoint:newSegments[numSegments - 1].b_
+                                                            outPoint:[path lastNode].outPoint]];
+            }
+            
+            path.nodes = nodes;
+        }
+        
+        free(reduced[t]);
+        free(segments[t]);
+    }
+    
+    free(closed);
+    free(reducedCounts);
+    free(reduced);
+    free(segmentCounts);
+    free(segments);
 }
 
 //
@@ -112,3 +201,105 @@
 }
 
 @end
+
+@implementation WDIncrementalCurveFit
+
+- (id) initWithError:(float)epsilon
+{
+    self = [super init];
+    
+    if (!self) {
+        return nil;
+    }
+    
+    epsilon_ = epsilon;
+    FitCurveStreamInit(&stream_, epsilon);
+    
+    return self;
+}
+
+- (void) dealloc
+{
+    FitCurveStreamFree(&stream_);
+}
+
+- (NSUInteger) pointCount
+{
+    return stream_.nPts;
+}
+
+- (CGPoint) firstPoint
+{
+    return stream_.nPts ? stream_.pts[0] : CGPointZero;
+}
+
+- (CGPoint) lastPoint
+{
+    return stream_.nPts ? stream_.pts[stream_.nPts - 1] : CGPointZero;
+}
+
+- (void) addPoint:(CGPoint)pt
+{
+    FitCurveStreamAddPoint(&stream_, pt);
+}
+
+- (NSMutableArray *) nodesUpdatingNodes:(NSArray *)oldNodes
+{
+    WDBezierSegment *segments = stream_.segments;
+    NSUInteger      firstLive = MIN(oldNodes.count, (NSUInteger) stream_.nFrozen);
+    NSMutableArray  *nodes = [NSMutableArray arrayWithCapacity:(stream_.nSegments + 1)];
+    
+    // the node at the start of a frozen segment has both its handles in frozen segments
+    [nodes addObjectsFromArray:[oldNodes subarrayWithRange:NSMakeRange(0, firstLive)]];
+    
+    if (stream_.nSegments == 0) {
+        if (stream_.nPts) {
+            [nodes addObject:[WDBezierNode bezierNodeWithAnchorPoint:stream_.pts[0]]];
+        }
+        return nodes;
+    }
+    
+    for (NSUInteger i = firstLive; i < stream_.nSegments; i++) {
+        [nodes addObject:[WDBezierNode bezierNodeWithInPoint:(i == 0 ? segments[0].a_ : segments[i-1].in_)
+                                                 anchorPoint:segments[i].a_
+                                                    outPoint:segments[i].out_]];
+    }
+    
+    WDBezierSegment last = segments[stream_.nSegments - 1];
+    [nodes addObject:[WDBezierNode bezierNodeWithInPoint:last.in_ anchorPoint:last.b_ outPoint:last.b_]];
+    
+    return nodes;
+}
+
+- (WDPath *) smoothPathAttemptingToClose:(BOOL)shouldClose
+{
+    CGPoint *pts = stream_.pts;
+    int     nPts = stream_.nPts;
+    BOOL    closePath = NO;
+    
+    // see if this path should be closed, and if so, average the first and last points
+    if (shouldClose && nPts > 3) {
+        CGPoint first = pts[0];
+        CGPoint last = pts[nPts - 1];
+        
+        if (WDDistance(first, last) < (epsilon_ * 2)) {
+            CGPoint average = WDAveragePoints(first, last);
+            
+            closePath = YES;
+            if (stream_.nFrozen) {
+                // the first segment is frozen: move it along with its start point
+                CGPoint delta = WDSubtractPoints(average, first);
+                stream_.segments[0].a_ = average;
+                stream_.segments[0].out_ = WDAddPoints(stream_.segments[0].out_, delta);
+            }
+            pts[0] = pts[nPts - 1] = average;
+            
+            // only the tail depends on the last point
+            FitCurveStreamRefit(&stream_);
+        }
+    }
+    
+    return [WDCurveFit pathFromSegments:stream_.segments numSegments:stream_.nSegments closePath:closePath];
+}
+
+@end
@@ -11,23 +11,37 @@
 
 #import <UIKit/UIKit.h>
 #import "WDAbstractPath.h"
+#import "WDBezierNode.h"
+#import "WDBezierSegment.h"
 #import "WDPickResult.h"
 
-@class WDBezierNode;
 @class WDColor;
 @class WDCompoundPath;
 @class WDFillTransform;
 
 @interface WDPath : WDAbstractPath <NSCoding, NSCopying> {
+    // the nodes, packed (WDBezierNodeData); never changed in place, so copies of the path share it
+    NSData              *nodeData_;
+    // the nodes as objects, made from nodeData_ when first asked for
     NSMutableArray      *nodes_;
     BOOL                closed_;
     BOOL                reversed_;
+    BOOL                knownSimple_;
     
     CGMutablePathRef    pathRef_;
     CGMutablePathRef    strokePathRef_;
     CGRect              bounds_;
     BOOL                boundsDirty_;
     
+    // bounds of each segment, along with the segment they were computed for
+    WDBezierSegment     *cachedSegments_;
+    CGRect              *segmentBounds_;
+    NSUInteger          segmentCount_;
+    NSUInteger          segmentCapacity_;
+    
+    // bounding volume hierarchy over those segments, for picking; built when first needed
+    WDSegmentTreeNode   *segmentTree_;
+    
     // arrowheads
     CGPoint             arrowStartAttachment_;
     float               arrowStartAngle_;
@@ -44,10 +58,18 @@
 
 @property (nonatomic, assign) BOOL closed;
 @property (nonatomic, assign) BOOL reversed;
+// the node objects are made on demand: to change the nodes, set a new array rather than changing this one
 @property (nonatomic, strong) NSMutableArray *nodes;
+// the same nodes, packed; reading them doesn't make any node objects
+@property (nonatomic, strong) NSData *nodeData;
+@property (nonatomic, readonly) NSUInteger nodeCount;
 @property (weak, nonatomic, readonly) NSMutableArray *reversedNodes;
 @property (nonatomic, weak) WDCompoundPath *superpath;
 
+// the path is known not to intersect itself (rects, ovals...), so the pathfinder can skip normalizing it
+// not archived, and cleared whenever the nodes change
+@property (nonatomic, assign) BOOL knownSimple;
+
 // to simplify rendering
 @property (nonatomic, strong) NSMutableArray *displayNodes;
 @property (nonatomic, strong) UIColor *displayColor;
@@ -87,6 +109,7 @@
 - (WDBezierNode *) firstNode;
 - (WDBezierNode *) lastNode;
 - (NSMutableArray *) reversedNodes;
+- (NSData *) reversedNodeData;
 - (NSSet *) nodesInRect:(CGRect)rect;
 
 - (WDBezierNode *) convertNode:(WDBezierNode *)node whichPoint:(WDPickResultType)whichPoint;
@@ -94,6 +117,10 @@
 - (CGRect) controlBounds;
 - (void) computeBounds;
 
+// appends the path as one polyline within tolerance of it (a closed one ends at its start); reads the nodes
+// but touches nothing else, so it can run on a worker thread while the path isn't being edited
+- (void) getFlattenedPoints:(WDPointBuffer *)buffer tolerance:(float)tolerance;
+
 - (NSString *) nodeSVGRepresentation;
 
 - (void) setClosedQuiet:(BOOL)closed;
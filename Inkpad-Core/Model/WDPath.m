@@ -15,6 +15,7 @@
 #import "WDBezierSegment.h"
 #import "WDColor.h"
 #import "WDCompoundPath.h"
+#import "WDCurveFit.h"
 #import "WDFillTransform.h"
 #import "WDGLUtilities.h"
 #import "WDLayer.h"
@@ -25,6 +26,7 @@
 
 const float kMiterLimit  = 10;
 const float circleFactor = 0.5522847498307936;
+static const float kIntersectionTolerance = 0.01f;
 
 NSString *WDReversedPathKey = @"WDReversedPathKey";
 NSString *WDSuperpathKey = @"WDSuperpathKey";
@@ -35,8 +37,8 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 @synthesize closed = closed_;
 @synthesize reversed = reversed_;
-@synthesize nodes = nodes_;
 @synthesize superpath = superpath_;
+@synthesize knownSimple = knownSimple_;
 
 // to simplify rendering
 @synthesize displayNodes = displayNodes_;
@@ -47,6 +49,7 @@ NSString *WDClosedKey = @"WDClosedKey";
 {
     self = [super init];
     
+    nodeData_ = [NSData data];
     nodes_ = [[NSMutableArray alloc] init];
     
     if (!self) {
@@ -63,6 +66,7 @@ NSString *WDClosedKey = @"WDClosedKey";
     self = [super init];
     
     nodes_ = [[NSMutableArray alloc] initWithObjects:node, nil];
+    nodeData_ = WDBezierNodeDataWithNodes(nodes_);
     
     if (!self) {
         return nil;
@@ -82,13 +86,17 @@ NSString *WDClosedKey = @"WDClosedKey";
     if (strokePathRef_) {
         CGPathRelease(strokePathRef_);
     }
+    
+    free(cachedSegments_);
+    free(segmentBounds_);
+    free(segmentTree_);
 }
 
 - (void)encodeWithCoder:(NSCoder *)coder
 {
     [super encodeWithCoder:coder];
     
-    [coder encodeObject:nodes_ forKey:WDNodesKey];
+    [coder encodeObject:self.nodes forKey:WDNodesKey];
     [coder encodeBool:closed_ forKey:WDClosedKey];
     [coder encodeBool:reversed_ forKey:WDReversedPathKey];
     
@@ -102,6 +110,7 @@ NSString *WDClosedKey = @"WDClosedKey";
     self = [super initWithCoder:coder];
     
     nodes_ = [coder decodeObjectForKey:WDNodesKey];
+    nodeData_ = WDBezierNodeDataWithNodes(nodes_);
     closed_ = [coder decodeBoolForKey:WDClosedKey];
     reversed_ = [coder decodeBoolForKey:WDReversedPathKey];
     superpath_ = [coder decodeObjectForKey:WDSuperpathKey];
@@ -111,13 +120,30 @@ NSString *WDClosedKey = @"WDClosedKey";
     return self; 
 }
 
+- (NSMutableArray *) nodes
+{
+    if (!nodes_) {
+        nodes_ = WDBezierNodesWithData(nodeData_);
+    }
+    
+    return nodes_;
+}
+
+- (NSUInteger) nodeCount
+{
+    return nodeData_.length / sizeof(WDBezierNodeData);
+}
+
 - (NSMutableArray *) reversedNodes
 {
-    NSMutableArray  *reversed = [NSMutableArray array];
+    return WDBezierNodesWithData([self reversedNodeData]);
+}
+
+- (NSData *) reversedNodeData
+{
+    NSMutableData *reversed = [NSMutableData dataWithLength:nodeData_.length];
     
-    for (WDBezierNode *node in [nodes_ reverseObjectEnumerator]) {
-        [reversed addObject:[node flippedNode]];
-    }
+    WDBezierNodeDataReverse(nodeData_.bytes, reversed.mutableBytes, self.nodeCount);
     
     return reversed;
 }
@@ -129,29 +155,33 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (void) computePathRef
 {
-    NSArray *nodes = reversed_ ? [self reversedNodes] : nodes_;
+    NSData                  *data = reversed_ ? [self reversedNodeData] : nodeData_;
+    const WDBezierNodeData  *nodes = data.bytes;
+    NSUInteger              count = self.nodeCount;
     
     // construct the path ref from the node list
-    WDBezierNode                *prevNode = nil;
-    BOOL                        firstTime = YES;
-    
     pathRef_ = CGPathCreateMutable();
     
-    for (WDBezierNode *node in nodes) {
-        if (firstTime) {
+    for (NSUInteger i = 0; i < count; i++) {
+        WDBezierNodeData node = nodes[i];
+        
+        if (i == 0) {
             CGPathMoveToPoint(pathRef_, NULL, node.anchorPoint.x, node.anchorPoint.y);
-            firstTime = NO;
-        } else if ([prevNode hasOutPoint] || [node hasInPoint]) {
-            CGPathAddCurveToPoint(pathRef_, NULL, prevNode.outPoint.x, prevNode.outPoint.y,
-                                  node.inPoint.x, node.inPoint.y, node.anchorPoint.x, node.anchorPoint.y);
         } else {
-            CGPathAddLineToPoint(pathRef_, NULL, node.anchorPoint.x, node.anchorPoint.y);
+            WDBezierNodeData prevNode = nodes[i - 1];
+            
+            if (!CGPointEqualToPoint(prevNode.outPoint, prevNode.anchorPoint) || !CGPointEqualToPoint(node.inPoint, node.anchorPoint)) {
+                CGPathAddCurveToPoint(pathRef_, NULL, prevNode.outPoint.x, prevNode.outPoint.y,
+                                      node.inPoint.x, node.inPoint.y, node.anchorPoint.x, node.anchorPoint.y);
+            } else {
+                CGPathAddLineToPoint(pathRef_, NULL, node.anchorPoint.x, node.anchorPoint.y);
+            }
         }
-        prevNode = node;
     }
     
-    if (closed_ && prevNode) {
-        WDBezierNode *node = nodes[0];
+    if (closed_ && count) {
+        WDBezierNodeData prevNode = nodes[count - 1];
+        WDBezierNodeData node = nodes[0];
         CGPathAddCurveToPoint(pathRef_, NULL, prevNode.outPoint.x, prevNode.outPoint.y,
                               node.inPoint.x, node.inPoint.y, node.anchorPoint.x, node.anchorPoint.y);
         
@@ -212,7 +242,7 @@ NSString *WDClosedKey = @"WDClosedKey";
     
     // need to calculate arrowhead positions and inset the path appropriately
     
-    NSArray *nodes = [nodes_ copy];
+    NSArray *nodes = [self.nodes copy];
     if (closed_) {
         nodes = [nodes arrayByAddingObject:nodes[0]];
     }
@@ -273,7 +303,7 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (CGPathRef) strokePathRef
 {
-    if (nodes_.count == 0) {
+    if (self.nodeCount == 0) {
         return NULL;
     }
     
@@ -286,7 +316,7 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (CGPathRef) pathRef
 {
-    if (nodes_.count == 0) {
+    if (self.nodeCount == 0) {
         return NULL;
     }
     
@@ -336,8 +366,11 @@ NSString *WDClosedKey = @"WDClosedKey";
     [nodes_ addObject:[WDBezierNode bezierNodeWithAnchorPoint:CGPointMake(CGRectGetMaxX(rect), CGRectGetMaxY(rect))]];
     [nodes_ addObject:[WDBezierNode bezierNodeWithAnchorPoint:CGPointMake(CGRectGetMinX(rect), CGRectGetMaxY(rect))]];
     
+    nodeData_ = WDBezierNodeDataWithNodes(nodes_);
+    
     self.closed = YES;
     bounds_ = rect;
+    knownSimple_ = YES;
     
     return self;
 }
@@ -404,8 +437,11 @@ NSString *WDClosedKey = @"WDClosedKey";
     node = [WDBezierNode bezierNodeWithInPoint:current anchorPoint:current outPoint:WDSubtractPoints(current, yDelta)];
     [nodes_ addObject:node];
     
+    nodeData_ = WDBezierNodeDataWithNodes(nodes_);
+    
     self.closed = YES;
     bounds_ = rect;
+    knownSimple_ = YES;
     
     return self;
 }
@@ -446,8 +482,11 @@ NSString *WDClosedKey = @"WDClosedKey";
     node = [WDBezierNode bezierNodeWithInPoint:WDAddPoints(anchor, xDelta) anchorPoint:anchor outPoint:WDSubtractPoints(anchor, xDelta)];
     [nodes_ addObject:node];
     
+    nodeData_ = WDBezierNodeDataWithNodes(nodes_);
+    
     self.closed = YES;
     bounds_ = rect;
+    knownSimple_ = YES;
     
     return self;
 }
@@ -462,6 +501,7 @@ NSString *WDClosedKey = @"WDClosedKey";
     
     [nodes_ addObject:[WDBezierNode bezierNodeWithAnchorPoint:start]];
     [nodes_ addObject:[WDBezierNode bezierNodeWithAnchorPoint:end]];
+    nodeData_ = WDBezierNodeDataWithNodes(nodes_);
     
     boundsDirty_ = YES;
     
@@ -470,7 +510,7 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (void) setClosedQuiet:(BOOL)closed
 {
-    if (closed && nodes_.count < 2) {
+    if (closed && self.nodeCount < 2) {
         // need at least 2 nodes to close a path
         return;
     }
@@ -482,7 +522,7 @@ NSString *WDClosedKey = @"WDClosedKey";
         if (CGPointEqualToPoint(first.anchorPoint, last.anchorPoint)) {
             WDBezierNode *closedNode = [WDBezierNode bezierNodeWithInPoint:last.inPoint anchorPoint:first.anchorPoint outPoint:first.outPoint];
             
-            NSMutableArray *newNodes = [NSMutableArray arrayWithArray:nodes_];
+            NSMutableArray *newNodes = [NSMutableArray arrayWithArray:self.nodes];
             newNodes[0] = closedNode;
             [newNodes removeLastObject];
             
@@ -495,7 +535,7 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (void) setClosed:(BOOL)closed
 {
-    if (closed && nodes_.count < 2) {
+    if (closed && self.nodeCount < 2) {
         // need at least 2 nodes to close a path
         return;
     }
@@ -513,10 +553,10 @@ NSString *WDClosedKey = @"WDClosedKey";
 {
     [self cacheDirtyBounds];
     
-    if (nodes_.count && WDDistance(node.anchorPoint, ((WDBezierNode *) nodes_[0]).anchorPoint) < (kNodeSelectionTolerance / scale)) {
+    if (self.nodeCount && WDDistance(node.anchorPoint, [self firstNode].anchorPoint) < (kNodeSelectionTolerance / scale)) {
         self.closed = YES;
     } else {
-        NSMutableArray *newNodes = [nodes_ mutableCopy];
+        NSMutableArray *newNodes = [self.nodes mutableCopy];
         [newNodes addObject:node];
         self.nodes = newNodes;
     }
@@ -528,21 +568,21 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (void) addNode:(WDBezierNode *)node
 {
-    NSMutableArray *newNodes = [NSMutableArray arrayWithArray:nodes_];
+    NSMutableArray *newNodes = [NSMutableArray arrayWithArray:self.nodes];
     [newNodes addObject:node];
     self.nodes = newNodes;
 }
 
 - (void) replaceFirstNodeWithNode:(WDBezierNode *)node
 {
-    NSMutableArray *newNodes = [NSMutableArray arrayWithArray:nodes_];
+    NSMutableArray *newNodes = [NSMutableArray arrayWithArray:self.nodes];
     newNodes[0] = node;
     self.nodes = newNodes;
 }
 
 - (void) replaceLastNodeWithNode:(WDBezierNode *)node
 {
-    NSMutableArray *newNodes = [NSMutableArray arrayWithArray:nodes_];
+    NSMutableArray *newNodes = [NSMutableArray arrayWithArray:self.nodes];
     [newNodes removeLastObject];
     [newNodes addObject:node];
     self.nodes = newNodes;
@@ -550,12 +590,12 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (WDBezierNode *) firstNode
 {
-    return nodes_[0];
+    return self.nodes[0];
 }
 
 - (WDBezierNode *) lastNode
 {
-    return (closed_ ? nodes_[0] : [nodes_ lastObject]); 
+    return (closed_ ? self.nodes[0] : [self.nodes lastObject]); 
 }
 
 - (void) reversePathDirection
@@ -593,6 +633,9 @@ NSString *WDClosedKey = @"WDClosedKey";
         strokePathRef_ = NULL;
     }
     
+    free(segmentTree_);
+    segmentTree_ = NULL;
+    
     if (self.superpath) {
         [self.superpath invalidatePath];
     }
@@ -600,31 +643,119 @@ NSString *WDClosedKey = @"WDClosedKey";
     boundsDirty_ = YES;
 }
 
-// alternative to CGPathGetPathBoundingBox() which didn't exist before iOS 4
+/*
+ * Union of the segment bounds. A segment's bounds are only recomputed when its geometry differs
+ * from the cached one, so moving a node costs the two segments on either side of it.
+ */
 - (CGRect) getPathBoundingBox
 {
-    NSInteger           numNodes = closed_ ? nodes_.count : nodes_.count - 1;
-    WDBezierSegment     segment;
-    CGRect              bbox = CGRectNull;
-
-    for (int i = 0; i < numNodes; i++) {
-        WDBezierNode *a = nodes_[i];
-        WDBezierNode *b = nodes_[(i+1) % nodes_.count];
-        
-        segment.a_ = a.anchorPoint;
-        segment.out_ = a.outPoint;
-        segment.in_ = b.inPoint;
-        segment.b_ = b.anchorPoint;
+    const WDBezierNodeData  *nodes = nodeData_.bytes;
+    NSUInteger              nodeCount = self.nodeCount;
+    
+    if (nodeCount == 0) {
+        return CGRectNull;
+    } else if (nodeCount == 1) {
+        CGPoint pt = nodes[0].anchorPoint;
+        return CGRectMake(pt.x, pt.y, 0, 0);
+    }
+    
+    NSUInteger numSegments = closed_ ? nodeCount : nodeCount - 1;
+    
+    if (numSegments > segmentCapacity_) {
+        segmentCapacity_ = numSegments * 2;
+        cachedSegments_ = realloc(cachedSegments_, sizeof(WDBezierSegment) * segmentCapacity_);
+        segmentBounds_ = realloc(segmentBounds_, sizeof(CGRect) * segmentCapacity_);
+    }
+    
+    // the changed segments are stored in place, and each run of them is bounded in one batch
+    NSUInteger      runStart = NSNotFound;
+    
+    for (NSUInteger i = 0; i < numSegments; i++) {
+        WDBezierSegment segment = WDBezierSegmentMakeWithData(nodes[i], nodes[(i+1) % nodeCount]);
         
-        bbox = CGRectUnion(bbox, WDBezierSegmentBounds(segment));
+        if (i < segmentCount_ && memcmp(&segment, &cachedSegments_[i], sizeof(WDBezierSegment)) == 0) {
+            if (runStart != NSNotFound) {
+                WDBezierSegmentBoundsArray(cachedSegments_ + runStart, segmentBounds_ + runStart, i - runStart);
+                runStart = NSNotFound;
+            }
+        } else {
+            cachedSegments_[i] = segment;
+            
+            if (runStart == NSNotFound) {
+                runStart = i;
+            }
+        }
+    }
+    
+    if (runStart != NSNotFound) {
+        WDBezierSegmentBoundsArray(cachedSegments_ + runStart, segmentBounds_ + runStart, numSegments - runStart);
+    }
+    
+    segmentCount_ = numSegments;
+    
+    CGRect bbox = segmentBounds_[0];
+    for (NSUInteger i = 1; i < numSegments; i++) {
+        bbox = CGRectUnion(bbox, segmentBounds_[i]);
     }
 
     return bbox;
 }
 
+/*
+ * Built over the segments cached by -getPathBoundingBox, in the order of nodeData_ (segment i starts at
+ * node i), so picking only looks at the segments near the point. NULL for a path without segments.
+ */
+- (WDSegmentTreeNode *) segmentTree
+{
+    if (boundsDirty_) {
+        [self computeBounds];
+    }
+    
+    if (!segmentTree_ && segmentCount_ > 0 && self.nodeCount > 1) {
+        segmentTree_ = malloc(sizeof(WDSegmentTreeNode) * (2 * segmentCount_ - 1));
+        WDSegmentTreeBuild(cachedSegments_, segmentCount_, segmentTree_);
+    }
+    
+    return segmentTree_;
+}
+
+/*
+ * Calls block with the index of each node whose anchor lies in rect, in increasing order.
+ */
+- (void) enumerateNodesInRect:(CGRect)rect usingBlock:(void (^)(NSUInteger index, BOOL *stop))block
+{
+    const WDBezierNodeData  *nodes = nodeData_.bytes;
+    NSUInteger              count = self.nodeCount;
+    WDSegmentTreeNode       *tree = [self segmentTree];
+    
+    if (!tree) {
+        BOOL stop = NO;
+        
+        for (NSUInteger i = 0; i < count && !stop; i++) {
+            if (CGRectContainsPoint(rect, nodes[i].anchorPoint)) {
+                block(i, &stop);
+            }
+        }
+        return;
+    }
+    
+    // every node starts a segment, except the last one of an open path, which ends the last segment
+    NSUInteger lastSegment = segmentCount_ - 1;
+    
+    WDSegmentTreeEnumerateSegmentsInRect(tree, rect, ^(NSUInteger segment, BOOL *stop) {
+        if (CGRectContainsPoint(rect, nodes[segment].anchorPoint)) {
+            block(segment, stop);
+        }
+        
+        if (!*stop && !closed_ && segment == lastSegment && CGRectContainsPoint(rect, nodes[count - 1].anchorPoint)) {
+            block(count - 1, stop);
+        }
+    });
+}
+
 - (void) computeBounds
 {
-    bounds_ = CGPathGetPathBoundingBox(self.pathRef);
+    bounds_ = [self getPathBoundingBox];
     boundsDirty_ = NO;
 }
 
@@ -642,31 +773,52 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (CGRect) controlBounds
 {
-    WDBezierNode     *initial = [nodes_ lastObject];
-    float           minX, maxX, minY, maxY;
+    const WDBezierNodeData  *nodes = nodeData_.bytes;
+    NSUInteger              count = self.nodeCount;
+    float                   minX, maxX, minY, maxY;
     
-    minX = maxX = initial.anchorPoint.x;
-    minY = maxY = initial.anchorPoint.y;
+    if (count == 0) {
+        return CGRectZero;
+    }
     
-    for (WDBezierNode *node in nodes_) {
-        minX = MIN(minX, node.anchorPoint.x);
-        maxX = MAX(maxX, node.anchorPoint.x);
-        minY = MIN(minY, node.anchorPoint.y);
-        maxY = MAX(maxY, node.anchorPoint.y);
+    WDSegmentTreeNode   *tree = [self segmentTree];
+    CGRect              bbox;
+    
+    if (tree) {
+        // the root bounds the control points of every segment, which leaves out the outer handles of an open path
+        bbox = tree[0].bounds;
+        
+        if (!closed_) {
+            bbox = WDGrowRectToPoint(bbox, nodes[0].inPoint);
+            bbox = WDGrowRectToPoint(bbox, nodes[count - 1].outPoint);
+        }
+    } else {
+        minX = maxX = nodes[count - 1].anchorPoint.x;
+        minY = maxY = nodes[count - 1].anchorPoint.y;
         
-        minX = MIN(minX, node.inPoint.x);
-        maxX = MAX(maxX, node.inPoint.x);
-        minY = MIN(minY, node.inPoint.y);
-        maxY = MAX(maxY, node.inPoint.y);
+        for (NSUInteger i = 0; i < count; i++) {
+            WDBezierNodeData node = nodes[i];
+            
+            minX = MIN(minX, node.anchorPoint.x);
+            maxX = MAX(maxX, node.anchorPoint.x);
+            minY = MIN(minY, node.anchorPoint.y);
+            maxY = MAX(maxY, node.anchorPoint.y);
+            
+            minX = MIN(minX, node.inPoint.x);
+            maxX = MAX(maxX, node.inPoint.x);
+            minY = MIN(minY, node.inPoint.y);
+            maxY = MAX(maxY, node.inPoint.y);
+            
+            minX = MIN(minX, node.outPoint.x);
+            maxX = MAX(maxX, node.outPoint.x);
+            minY = MIN(minY, node.outPoint.y);
+            maxY = MAX(maxY, node.outPoint.y);
+        }
         
-        minX = MIN(minX, node.outPoint.x);
-        maxX = MAX(maxX, node.outPoint.x);
-        minY = MIN(minY, node.outPoint.y);
-        maxY = MAX(maxY, node.outPoint.y);
+        bbox = CGRectMake(minX, minY, maxX - minX, maxY - minY);
     }
-      
-    CGRect bbox = CGRectMake(minX, minY, maxX - minX, maxY - minY);
     
+    // the fill handles can be picked, so they count too
     if (self.fillTransform) {
         bbox = WDGrowRectToPoint(bbox, self.fillTransform.transformedStart);
         bbox = WDGrowRectToPoint(bbox, self.fillTransform.transformedEnd);
@@ -721,19 +873,20 @@ NSString *WDClosedKey = @"WDClosedKey";
     CGRect styleBounds = CGRectInset(self.bounds, -outset, -outset);
     
     // include miter joins on corners
-    if (nodes_.count > 2 && strokeStyle.join == kCGLineJoinMiter) {
-        NSInteger       nodeCount = closed_ ? nodes_.count + 1 : nodes_.count;
-        WDBezierNode    *prev = nodes_[0];
-        WDBezierNode    *curr = nodes_[1];
-        WDBezierNode    *next;
-        CGPoint         inPoint, outPoint, inVec, outVec;
-        float           miterLength, angle;
+    if (self.nodeCount > 2 && strokeStyle.join == kCGLineJoinMiter) {
+        const WDBezierNodeData  *nodes = nodeData_.bytes;
+        NSInteger               nodeCount = closed_ ? self.nodeCount + 1 : self.nodeCount;
+        WDBezierNodeData        prev = nodes[0];
+        WDBezierNodeData        curr = nodes[1];
+        WDBezierNodeData        next;
+        CGPoint                 inPoint, outPoint, inVec, outVec;
+        float                   miterLength, angle;
         
         for (int i = 1; i < nodeCount; i++) {
-            next = nodes_[(i+1) % nodes_.count];
+            next = nodes[(i+1) % self.nodeCount];
             
-            inPoint = [curr hasInPoint] ? curr.inPoint : prev.outPoint;
-            outPoint = [curr hasOutPoint] ? curr.outPoint : next.inPoint;
+            inPoint = !CGPointEqualToPoint(curr.inPoint, curr.anchorPoint) ? curr.inPoint : prev.outPoint;
+            outPoint = !CGPointEqualToPoint(curr.outPoint, curr.anchorPoint) ? curr.outPoint : next.inPoint;
             
             inVec = WDSubtractPoints(inPoint, curr.anchorPoint);
             outVec = WDSubtractPoints(outPoint, curr.anchorPoint);
@@ -757,7 +910,7 @@ NSString *WDClosedKey = @"WDClosedKey";
     }
     
     // add in arrowheads, if any
-    if ([strokeStyle hasArrow] && self.nodes && self.nodes.count) {
+    if ([strokeStyle hasArrow] && self.nodeCount) {
         float               scale = strokeStyle.width;
         CGRect              arrowBounds;
         WDArrowhead         *arrow;
@@ -787,50 +940,39 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (BOOL) intersectsRect:(CGRect)rect
 {
-    WDBezierNode 		*prev = nil;
-    WDBezierSegment 	seg;
+    const WDBezierNodeData  *nodes = nodeData_.bytes;
+    NSUInteger              count = self.nodeCount;
     
-    if (nodes_.count == 1) {
-        return CGRectContainsPoint(rect, [self firstNode].anchorPoint);
+    if (count == 0) {
+        return NO;
+    } else if (count == 1) {
+        return CGRectContainsPoint(rect, nodes[0].anchorPoint);
     }
     
     if (!CGRectIntersectsRect(self.bounds, rect)) {
         return NO;
     }
     
-    for (WDBezierNode *node in nodes_) {
-        if (!prev) {
-            prev = node;
-            continue;
-        }
-        
-        seg = WDBezierSegmentMake(prev, node);
-        if (WDBezierSegmentIntersectsRect(seg, rect)) {
-            return YES;
-        }
-        
-        prev = node;
-    }
+    __block BOOL intersects = NO;
     
-    if (self.closed) {
-        seg = WDBezierSegmentMake([nodes_ lastObject], nodes_[0]);
-        if (WDBezierSegmentIntersectsRect(seg, rect)) {
-            return YES;
+    WDSegmentTreeEnumerateSegmentsInRect([self segmentTree], rect, ^(NSUInteger segment, BOOL *stop) {
+        if (WDBezierSegmentIntersectsRect(WDBezierSegmentMakeWithData(nodes[segment], nodes[(segment + 1) % count]), rect,
+                                          kDefaultFlattenTolerance)) {
+            intersects = *stop = YES;
         }
-    }
+    });
     
-    return NO;
+    return intersects;
 }
 
 - (NSSet *) nodesInRect:(CGRect)rect
 {
-    NSMutableSet *nodesInRect = [NSMutableSet set];
+    NSMutableSet    *nodesInRect = [NSMutableSet set];
+    NSArray         *nodes = self.nodes;
     
-    for (WDBezierNode *node in nodes_) {
-        if (CGRectContainsPoint(rect, node.anchorPoint)) {
-            [nodesInRect addObject:node];
-        }
-    }
+    [self enumerateNodesInRect:rect usingBlock:^(NSUInteger index, BOOL *stop) {
+        [nodesInRect addObject:nodes[index]];
+    }];
     
     return nodesInRect;
 }
@@ -847,34 +989,31 @@ NSString *WDClosedKey = @"WDClosedKey";
         return;
     }    
     
-    if (!nodes_ || nodes_.count == 0) {
+    if (self.nodeCount == 0) {
         return;
     }
     
-    NSArray             *nodes = nodes_;
-    NSInteger           numNodes = closed_ ? nodes.count : nodes.count - 1;
-    CGPoint             prevIn, prevAnchor, prevOut;
-    CGPoint             currIn, currAnchor, currOut;
+    const WDBezierNodeData  *nodes = nodeData_.bytes;
+    NSUInteger          count = self.nodeCount;
+    NSInteger           numNodes = closed_ ? count : count - 1;
+    CGPoint             prevOut;
+    CGPoint             currIn, currAnchor;
     WDBezierSegment     segment;
     
-    static GLfloat      *vertices = NULL;
-    static NSUInteger   size = 128;
+    NSUInteger          size = 128;
     NSUInteger          index = 0;
-    
-    if (!vertices) {
-        vertices = calloc(sizeof(GLfloat), size);
-    }
+    GLfloat             *vertices = malloc(sizeof(GLfloat) * size);
     
     // pre-condition
-    WDBezierNode *prev = nodes[0];
-    [prev getInPoint:&prevIn anchorPoint:&prevAnchor outPoint:&prevOut selected:NULL];
+    CGPoint prevAnchor = nodes[0].anchorPoint;
+    prevOut = nodes[0].outPoint;
     
     segment.a_.x = viewTransform.a * prevAnchor.x + viewTransform.c * prevAnchor.y + viewTransform.tx;
     segment.a_.y = viewTransform.b * prevAnchor.x + viewTransform.d * prevAnchor.y + viewTransform.ty;
     
     for (int i = 1; i <= numNodes; i++) {
-        WDBezierNode *curr = nodes[i % nodes.count];
-        [curr getInPoint:&currIn anchorPoint:&currAnchor outPoint:&currOut selected:NULL];
+        currIn = nodes[i % count].inPoint;
+        currAnchor = nodes[i % count].anchorPoint;
         
         segment.out_.x = viewTransform.a * prevOut.x + viewTransform.c * prevOut.y + viewTransform.tx;
         segment.out_.y = viewTransform.b * prevOut.x + viewTransform.d * prevOut.y + viewTransform.ty;
@@ -885,28 +1024,32 @@ NSString *WDClosedKey = @"WDClosedKey";
         segment.b_.x = viewTransform.a * currAnchor.x + viewTransform.c * currAnchor.y + viewTransform.tx;
         segment.b_.y = viewTransform.b * currAnchor.x + viewTransform.d * currAnchor.y + viewTransform.ty;
         
-        WDGLFlattenBezierSegment(segment, &vertices, &size, &index);
+        WDGLFlattenBezierSegment(segment, kGLFlattenTolerance, &vertices, &size, &index);
         
         // set up for the next iteration
-        prevOut = currOut;
+        prevOut = nodes[i % count].outPoint;
         segment.a_ = segment.b_;
     }
     
     // assumes proper color set by caller
     WDGLDrawLineStrip(vertices, index);
+    free(vertices);
 }
 
 - (void) drawOpenGLHighlightWithTransform:(CGAffineTransform)transform viewTransform:(CGAffineTransform)viewTransform
 {    
+    // without node objects, nothing is selected and the packed nodes will do
     NSArray             *nodes = displayNodes_ ? displayNodes_ : nodes_;
+    const WDBezierNodeData  *packed = nodeData_.bytes;
+    NSUInteger          count = nodes ? nodes.count : self.nodeCount;
     
-    if (!nodes || nodes.count == 0) {
+    if (count == 0) {
         return;
     }
     
     BOOL                transformAll = ![self anyNodesSelected];
     BOOL                closed = displayNodes_ ? displayClosed_ : closed_;
-    NSInteger           numNodes = closed ? nodes.count : nodes.count - 1;
+    NSInteger           numNodes = closed ? count : count - 1;
     CGAffineTransform   combined = CGAffineTransformConcat(transform, viewTransform);
     CGPoint             prevIn, prevAnchor, prevOut;
     CGPoint             currIn, currAnchor, currOut;
@@ -914,17 +1057,17 @@ NSString *WDClosedKey = @"WDClosedKey";
     CGAffineTransform   prevTx, currTx;
     WDBezierSegment     segment;
     
-    static GLfloat      *vertices = NULL;
-    static NSUInteger   size = 128;
+    NSUInteger          size = 128;
     NSUInteger          index = 0;
-    
-    if (!vertices) {
-        vertices = calloc(sizeof(GLfloat), size);
-    }
+    GLfloat             *vertices = malloc(sizeof(GLfloat) * size);
     
     // pre-condition
-    WDBezierNode *prev = nodes[0];
-    [prev getInPoint:&prevIn anchorPoint:&prevAnchor outPoint:&prevOut selected:&prevSelected];
+    if (nodes) {
+        [nodes[0] getInPoint:&prevIn anchorPoint:&prevAnchor outPoint:&prevOut selected:&prevSelected];
+    } else {
+        prevIn = packed[0].inPoint, prevAnchor = packed[0].anchorPoint, prevOut = packed[0].outPoint;
+        prevSelected = NO;
+    }
     
     prevTx = (prevSelected || transformAll) ? combined : viewTransform;
     
@@ -933,8 +1076,12 @@ NSString *WDClosedKey = @"WDClosedKey";
     segment.a_.y = prevTx.b * prevAnchor.x + prevTx.d * prevAnchor.y + prevTx.ty;
     
     for (int i = 1; i <= numNodes; i++) {
-        WDBezierNode *curr = nodes[i % nodes.count];
-        [curr getInPoint:&currIn anchorPoint:&currAnchor outPoint:&currOut selected:&currSelected];
+        if (nodes) {
+            [nodes[i % count] getInPoint:&currIn anchorPoint:&currAnchor outPoint:&currOut selected:&currSelected];
+        } else {
+            currIn = packed[i % count].inPoint, currAnchor = packed[i % count].anchorPoint, currOut = packed[i % count].outPoint;
+            currSelected = NO;
+        }
         
         // segment.out_ = CGPointApplyAffineTransform(prevOut, (prevSelected || transformAll) ? combined : viewTransform);
         segment.out_.x = prevTx.a * prevOut.x + prevTx.c * prevOut.y + prevTx.tx;
@@ -950,7 +1097,7 @@ NSString *WDClosedKey = @"WDClosedKey";
         segment.b_.x = currTx.a * currAnchor.x + currTx.c * currAnchor.y + currTx.tx;
         segment.b_.y = currTx.b * currAnchor.x + currTx.d * currAnchor.y + currTx.ty;
 
-        WDGLFlattenBezierSegment(segment, &vertices, &size, &index);
+        WDGLFlattenBezierSegment(segment, kGLFlattenTolerance, &vertices, &size, &index);
         
         // set up for the next iteration
         prevSelected = currSelected;
@@ -961,12 +1108,13 @@ NSString *WDClosedKey = @"WDClosedKey";
     
     displayColor_ ? [displayColor_ openGLSet]: [self.layer.highlightColor openGLSet];
     WDGLDrawLineStrip(vertices, index);
+    free(vertices);
 }
 
 - (void) drawOpenGLAnchorsWithViewTransform:(CGAffineTransform)transform
 {
     UIColor *color = displayColor_ ? displayColor_ : self.layer.highlightColor;
-    NSArray *nodes = displayNodes_ ? displayNodes_ : nodes_;
+    NSArray *nodes = displayNodes_ ? displayNodes_ : self.nodes;
     
     for (WDBezierNode *node in nodes) {
         [node drawGLWithViewTransform:transform color:color mode:kWDBezierNodeRenderClosed];
@@ -977,7 +1125,7 @@ NSString *WDClosedKey = @"WDClosedKey";
 {
     CGAffineTransform   combined = CGAffineTransformConcat(transform, viewTransform);
     UIColor             *color = displayColor_ ? displayColor_ : self.layer.highlightColor;
-    NSArray             *nodes = displayNodes_ ? displayNodes_ : nodes_;
+    NSArray             *nodes = displayNodes_ ? displayNodes_ : self.nodes;
     
     for (WDBezierNode *node in nodes) {
         if (node.selected) {
@@ -990,6 +1138,7 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (BOOL) anyNodesSelected
 {
+    // selection lives on the node objects, so there's none until they are made
     for (WDBezierNode *node in nodes_) {
         if (node.selected) {
             return YES;
@@ -1001,6 +1150,10 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (BOOL) allNodesSelected
 {
+    if (!nodes_) {
+        return (self.nodeCount == 0);
+    }
+    
     for (WDBezierNode *node in nodes_) {
         if (!node.selected) {
             return NO;
@@ -1023,7 +1176,7 @@ NSString *WDClosedKey = @"WDClosedKey";
     NSMutableArray      *newNodes = [NSMutableArray array];
     NSMutableSet        *exchangedNodes = [NSMutableSet set];
     
-    for (WDBezierNode *node in nodes_) {
+    for (WDBezierNode *node in self.nodes) {
         if (node.selected) {
             switch(align) {
                 case WDAlignLeft:
@@ -1059,17 +1212,55 @@ NSString *WDClosedKey = @"WDClosedKey";
     return exchangedNodes;
 }
 
+- (void) registerUndoForNodes
+{
+    // undo brings back the same node objects, if any were made, since the selection refers to them
+    if (nodes_) {
+        [[self.undoManager prepareWithInvocationTarget:self] setNodes:nodes_];
+    } else {
+        [[self.undoManager prepareWithInvocationTarget:self] setNodeData:nodeData_];
+    }
+}
+
 - (void) setNodes:(NSMutableArray *)nodes
 {
-    if ([nodes_ isEqualToArray:nodes]) {
+    NSData *nodeData = WDBezierNodeDataWithNodes(nodes);
+    
+    if ([nodeData_ isEqualToData:nodeData]) {
         return;
     }
     
     [self cacheDirtyBounds];
     
-    [[self.undoManager prepareWithInvocationTarget:self] setNodes:nodes_];
+    [self registerUndoForNodes];
     
+    nodeData_ = nodeData;
     nodes_ = nodes;
+    knownSimple_ = NO;
+    
+    [self invalidatePath];
+    
+    [self postDirtyBoundsChange];
+}
+
+- (NSData *) nodeData
+{
+    return nodeData_;
+}
+
+- (void) setNodeData:(NSData *)nodeData
+{
+    if ([nodeData_ isEqualToData:nodeData]) {
+        return;
+    }
+    
+    [self cacheDirtyBounds];
+    
+    [self registerUndoForNodes];
+    
+    nodeData_ = [nodeData copy];
+    nodes_ = nil;
+    knownSimple_ = NO;
     
     [self invalidatePath];
     
@@ -1078,26 +1269,35 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (NSSet *) transform:(CGAffineTransform)transform
 {
-    NSMutableArray      *newNodes = [[NSMutableArray alloc] init];
     BOOL                transformAll = [self anyNodesSelected] ? NO : YES;
     NSMutableSet        *exchangedNodes = [NSMutableSet set];
+    BOOL                wasSimple = knownSimple_;
     
-    for (WDBezierNode *node in nodes_) {
-        if (transformAll || node.selected) {
-            WDBezierNode *transformed = [node transform:transform];
-            [newNodes addObject:transformed];
-            
+    if (transformAll) {
+        // one pass over the packed nodes, without making any node objects
+        NSMutableData *transformed = [NSMutableData dataWithLength:nodeData_.length];
+        WDBezierNodeDataTransform(nodeData_.bytes, transformed.mutableBytes, self.nodeCount, transform);
+        self.nodeData = transformed;
+    } else {
+        NSMutableArray *newNodes = [[NSMutableArray alloc] init];
+        
+        for (WDBezierNode *node in nodes_) {
             if (node.selected) {
+                WDBezierNode *transformed = [node transform:transform];
+                [newNodes addObject:transformed];
                 [exchangedNodes addObject:transformed];
+            } else {
+                [newNodes addObject:node];
             }
-        } else {
-            [newNodes addObject:node];
         }
+        
+        self.nodes = newNodes;
     }
     
-    self.nodes = newNodes;
-    
     if (transformAll) {
+        // an invertible transform of the whole path can't introduce self intersections
+        knownSimple_ = wasSimple && (transform.a * transform.d - transform.b * transform.c) != 0;
+        
         // parent transforms masked elements and fill transform
         [super transform:transform];
     }
@@ -1123,17 +1323,17 @@ NSString *WDClosedKey = @"WDClosedKey";
 - (NSDictionary *) splitAtNode:(WDBezierNode *)node
 {
     NSMutableDictionary *whatToSelect = [NSMutableDictionary dictionary];
-    NSUInteger          i, startIx = [nodes_ indexOfObject:node];
+    NSUInteger          i, startIx = [self.nodes indexOfObject:node];
     
     if (self.closed) {
         NSMutableArray  *newNodes = [NSMutableArray array];
         
-        for (i = startIx; i < nodes_.count; i++) {
-            [newNodes addObject:nodes_[i]];
+        for (i = startIx; i < self.nodeCount; i++) {
+            [newNodes addObject:self.nodes[i]];
         }
         
         for (i = 0; i < startIx; i++) {
-            [newNodes addObject:nodes_[i]];
+            [newNodes addObject:self.nodes[i]];
         }
         
         [newNodes addObject:[node copy]]; // copy this node since it would otherwise be shared
@@ -1147,15 +1347,15 @@ NSString *WDClosedKey = @"WDClosedKey";
         // the original path gets the first half of the original nodes
         NSMutableArray  *newNodes = [NSMutableArray array];
         for (i = 0; i < startIx; i++) {
-            [newNodes addObject:nodes_[i]];
+            [newNodes addObject:self.nodes[i]];
         }
         [newNodes addObject:[node copy]]; // copy this node since it would otherwise be shared
         
         // create a new path to take the rest of the nodes
         WDPath *sibling = [[WDPath alloc] init];
         NSMutableArray  *siblingNodes = [NSMutableArray array];
-        for (i = startIx; i < nodes_.count; i++) {
-            [siblingNodes addObject:nodes_[i]];
+        for (i = startIx; i < self.nodeCount; i++) {
+            [siblingNodes addObject:self.nodes[i]];
         }
         
         // set this after building siblingNodes so that nodes_ doesn't go away
@@ -1195,20 +1395,18 @@ NSString *WDClosedKey = @"WDClosedKey";
 - (WDBezierNode *) addAnchorAtPoint:(CGPoint)pt viewScale:(float)viewScale
 {
     NSMutableArray      *newNodes = [NSMutableArray array];
-    NSInteger           numNodes = closed_ ? (nodes_.count + 1) : nodes_.count;
+    NSInteger           numNodes = closed_ ? (self.nodeCount + 1) : self.nodeCount;
     NSInteger           numSegments = numNodes; // includes an extra one for the one that gets split
     WDBezierSegment     segments[numSegments];
     WDBezierSegment     segment;
-    WDBezierNode        *prev, *curr, *node, *newestNode = nil;
+    const WDBezierNodeData  *nodes = nodeData_.bytes;
+    WDBezierNode        *node, *newestNode = nil;
     NSUInteger          newestNodeSegmentIx = 0, segmentIndex = 0;
     float               t;
     BOOL                added = NO;
 
-    prev = nodes_[0];
     for (int i = 1; i < numNodes; i++, segmentIndex ++) {
-        curr = nodes_[(i % nodes_.count)];
-        
-        segment = WDBezierSegmentMake(prev, curr);
+        segment = WDBezierSegmentMakeWithData(nodes[i - 1], nodes[i % self.nodeCount]);
         
         if (!added && WDBezierSegmentFindPointOnSegment(segment, pt, kNodeSelectionTolerance / viewScale, NULL, &t)) {
             WDBezierSegmentSplitAtT(segment,  &segments[segmentIndex], &segments[segmentIndex+1], t);
@@ -1218,8 +1416,6 @@ NSString *WDClosedKey = @"WDClosedKey";
         } else {
             segments[segmentIndex] = segment;
         }
-        
-        prev = curr;
     }
 
     // convert the segments back to nodes
@@ -1251,21 +1447,17 @@ NSString *WDClosedKey = @"WDClosedKey";
 - (void) addAnchors
 {
     NSMutableArray      *newNodes = [NSMutableArray array];
-    NSInteger           numNodes = closed_ ? (nodes_.count + 1) : nodes_.count;
+    NSInteger           numNodes = closed_ ? (self.nodeCount + 1) : self.nodeCount;
     NSInteger           numSegments = (numNodes - 1) * 2;
     WDBezierSegment     segments[numSegments];
     WDBezierSegment     segment;
-    WDBezierNode        *prev, *curr, *node;
+    const WDBezierNodeData  *nodes = nodeData_.bytes;
+    WDBezierNode        *node;
     NSUInteger          segmentIndex = 0;
     
-    prev = nodes_[0];
     for (int i = 1; i < numNodes; i++, segmentIndex += 2) {
-        curr = nodes_[(i % nodes_.count)];
-        
-        segment = WDBezierSegmentMake(prev, curr);
+        segment = WDBezierSegmentMakeWithData(nodes[i - 1], nodes[i % self.nodeCount]);
         WDBezierSegmentSplit(segment, &segments[segmentIndex], &segments[segmentIndex+1]);
-        
-        prev = curr;
     }
     
     // convert the segments back to nodes
@@ -1293,7 +1485,7 @@ NSString *WDClosedKey = @"WDClosedKey";
     NSUInteger unselectedCount = 0;
     NSUInteger selectedCount = 0;
     
-    for (WDBezierNode *node in nodes_) {
+    for (WDBezierNode *node in self.nodes) {
         if (!node.selected) {
             unselectedCount++;
         } else {
@@ -1310,8 +1502,8 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (void) deleteAnchor:(WDBezierNode *)node
 {
-    if (nodes_.count > 2) {
-        NSMutableArray *newNodes = [nodes_ mutableCopy];
+    if (self.nodeCount > 2) {
+        NSMutableArray *newNodes = [self.nodes mutableCopy];
         [newNodes removeObject:node];
         self.nodes = newNodes;
     }
@@ -1319,7 +1511,7 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (void) deleteAnchors
 {   
-    NSMutableArray *newNodes = [nodes_ mutableCopy];
+    NSMutableArray *newNodes = [self.nodes mutableCopy];
     [newNodes removeObjectsInArray:[self selectedNodes]];
     self.nodes = newNodes;
 }
@@ -1402,22 +1594,22 @@ NSString *WDClosedKey = @"WDClosedKey";
         if (node.hasInPoint || node.hasOutPoint) {
             newNode = [node chopHandles];
         } else {
-            NSInteger ix = [nodes_ indexOfObject:node];
+            NSInteger ix = [self.nodes indexOfObject:node];
             NSInteger pix, nix;
             WDBezierNode *prev = nil, *next = nil;
             
             pix = ix - 1;
             if (pix >= 0) {
-                prev = nodes_[pix];
-            } else if (closed_ && nodes_.count > 2) {
-                prev = [nodes_ lastObject];
+                prev = self.nodes[pix];
+            } else if (closed_ && self.nodeCount > 2) {
+                prev = [self.nodes lastObject];
             }
             
             nix = ix + 1;
-            if (nix < nodes_.count) {
-                next = nodes_[nix];
-            } else if (closed_ && nodes_.count > 2) {
-                next = nodes_[0];
+            if (nix < self.nodeCount) {
+                next = self.nodes[nix];
+            } else if (closed_ && self.nodeCount > 2) {
+                next = self.nodes[0];
             }
             
             if (!prev) {
@@ -1441,7 +1633,7 @@ NSString *WDClosedKey = @"WDClosedKey";
     }
     
     NSMutableArray *newNodes = [NSMutableArray array];
-    for (WDBezierNode *oldNode in nodes_) {
+    for (WDBezierNode *oldNode in self.nodes) {
         if (node == oldNode) {
             [newNodes addObject:newNode];
         } else {
@@ -1510,13 +1702,22 @@ NSString *WDClosedKey = @"WDClosedKey";
             } 
         }
         
-        for (WDBezierNode *node in nodes_) {
-            distance = WDDistance(node.anchorPoint, point);
-            if (distance < MIN(tolerance, minDistance)) {
-                result.node = node;
-                result.type = kWDAnchorPoint;
-                minDistance = distance;
+        // only the node that's hit needs to be an object
+        const WDBezierNodeData  *nodes = nodeData_.bytes;
+        __block NSUInteger      hitIndex = NSNotFound;
+        __block float           closest = minDistance;
+        
+        [self enumerateNodesInRect:CGRectInset(pointRect, -tolerance / 2, -tolerance / 2) usingBlock:^(NSUInteger index, BOOL *stop) {
+            float d = WDDistance(nodes[index].anchorPoint, point);
+            if (d < MIN(tolerance, closest)) {
+                hitIndex = index;
+                closest = d;
             }
+        }];
+        
+        if (hitIndex != NSNotFound) {
+            result.node = self.nodes[hitIndex];
+            result.type = kWDAnchorPoint;
         }
         
         if (result.type != kWDEther) {
@@ -1526,27 +1727,30 @@ NSString *WDClosedKey = @"WDClosedKey";
     }
     
     if (flags & kWDSnapEdges) {
-        // check path edges
-        NSInteger           numNodes = closed_ ? nodes_.count : nodes_.count - 1;
-        WDBezierSegment     segment;
-        
-        for (int i = 0; i < numNodes; i++) {
-            WDBezierNode    *a = nodes_[i];
-            WDBezierNode    *b = nodes_[(i+1) % nodes_.count];
-            CGPoint         nearest;
-            
-            segment.a_ = a.anchorPoint;
-            segment.out_ = a.outPoint;
-            segment.in_ = b.inPoint;
-            segment.b_ = b.anchorPoint;
+        // check path edges, just the ones near the point, and snap to the closest
+        const WDBezierNodeData  *nodes = nodeData_.bytes;
+        NSUInteger              count = self.nodeCount;
+        __block float           closest = tolerance;
+        __block BOOL            found = NO;
+        __block CGPoint         nearest;
+        
+        WDSegmentTreeEnumerateSegmentsInRect([self segmentTree], CGRectInset(pointRect, -tolerance / 2, -tolerance / 2), ^(NSUInteger segment, BOOL *stop) {
+            WDBezierSegment seg = WDBezierSegmentMakeWithData(nodes[segment], nodes[(segment + 1) % count]);
+            CGPoint         pt;
             
-            if (WDBezierSegmentFindPointOnSegment(segment, point, kNodeSelectionTolerance / viewScale, &nearest, NULL)) {
-                result.element = self;
-                result.type = kWDEdge;
-                result.snappedPoint = nearest;
-                
-                return result;
+            if (WDBezierSegmentFindPointOnSegment(seg, point, closest, &pt, NULL)) {
+                closest = WDDistance(pt, point);
+                nearest = pt;
+                found = YES;
             }
+        });
+        
+        if (found) {
+            result.element = self;
+            result.type = kWDEdge;
+            result.snappedPoint = nearest;
+            
+            return result;
         }
     }
     
@@ -1571,50 +1775,63 @@ NSString *WDClosedKey = @"WDClosedKey";
     }
     
     if (flags & kWDSnapNodes) {
-        for (WDBezierNode *node in nodes_) {
-            if (WDDistance(node.anchorPoint, point) < (kNodeSelectionTolerance / viewScale)) {
-                result.element = self;
-                result.node = node;
-                result.type = kWDAnchorPoint;
-                result.nodePosition = kWDMiddleNode;
-                result.snappedPoint = node.anchorPoint;
-                
-                if (!closed_) {
-                    if (node == nodes_[0]) {
-                        result.nodePosition = kWDFirstNode;
-                    } else if (node == [nodes_ lastObject]) {
-                        result.nodePosition = kWDLastNode;
-                    }
+        const WDBezierNodeData  *nodes = nodeData_.bytes;
+        NSUInteger              count = self.nodeCount;
+        float                   tolerance = kNodeSelectionTolerance / viewScale;
+        __block NSUInteger      i = NSNotFound;
+        
+        [self enumerateNodesInRect:CGRectInset(pointRect, -tolerance / 2, -tolerance / 2) usingBlock:^(NSUInteger index, BOOL *stop) {
+            if (WDDistance(nodes[index].anchorPoint, point) < tolerance) {
+                i = index;
+                *stop = YES;
+            }
+        }];
+        
+        if (i != NSNotFound) {
+            result.element = self;
+            result.node = self.nodes[i];
+            result.type = kWDAnchorPoint;
+            result.nodePosition = kWDMiddleNode;
+            result.snappedPoint = nodes[i].anchorPoint;
+            
+            if (!closed_) {
+                if (i == 0) {
+                    result.nodePosition = kWDFirstNode;
+                } else if (i == count - 1) {
+                    result.nodePosition = kWDLastNode;
                 }
-                
-                return result;
             }
+            
+            return result;
         }
     }
     
     if (flags & kWDSnapEdges) {
-        // check path edges
-        NSInteger           numNodes = closed_ ? nodes_.count : nodes_.count - 1;
-        WDBezierSegment     segment;
-        
-        
-        for (int i = 0; i < numNodes; i++) {
-            WDBezierNode    *a = nodes_[i];
-            WDBezierNode    *b = nodes_[(i+1) % nodes_.count];
-            CGPoint         nearest;
-            
-            segment.a_ = a.anchorPoint;
-            segment.out_ = a.outPoint;
-            segment.in_ = b.inPoint;
-            segment.b_ = b.anchorPoint;
+        // check path edges, just the ones near the point, and snap to the closest
+        const WDBezierNodeData  *nodes = nodeData_.bytes;
+        NSUInteger              count = self.nodeCount;
+        float                   tolerance = kNodeSelectionTolerance / viewScale;
+        __block float           closest = tolerance;
+        __block BOOL            found = NO;
+        __block CGPoint         nearest;
+        
+        WDSegmentTreeEnumerateSegmentsInRect([self segmentTree], CGRectInset(pointRect, -tolerance / 2, -tolerance / 2), ^(NSUInteger segment, BOOL *stop) {
+            WDBezierSegment seg = WDBezierSegmentMakeWithData(nodes[segment], nodes[(segment + 1) % count]);
+            CGPoint         pt;
             
-            if (WDBezierSegmentFindPointOnSegment(segment, point, kNodeSelectionTolerance / viewScale, &nearest, NULL)) {
-                result.element = self;
-                result.type = kWDEdge;
-                result.snappedPoint = nearest;
-                
-                return result;
+            if (WDBezierSegmentFindPointOnSegment(seg, point, closest, &pt, NULL)) {
+                closest = WDDistance(pt, point);
+                nearest = pt;
+                found = YES;
             }
+        });
+        
+        if (found) {
+            result.element = self;
+            result.type = kWDEdge;
+            result.snappedPoint = nearest;
+            
+            return result;
         }
     }
     
@@ -1659,100 +1876,127 @@ NSString *WDClosedKey = @"WDClosedKey";
     return (!self.superpath && !self.maskedElements);
 }
 
+- (BOOL) erasesWithPathfinder
+{
+    return self.closed;
+}
+
+- (NSArray *) eraseResult:(WDAbstractPath *)result
+{
+    if (!result) {
+        return @[];
+    }
+    
+    [result takeStylePropertiesFrom:self];
+    
+    if (self.superpath && [result isKindOfClass:[WDCompoundPath class]]) {
+        WDCompoundPath *cp = (WDCompoundPath *)result;
+        [[cp subpaths] makeObjectsPerformSelector:@selector(setSuperpath:) withObject:nil];
+        return cp.subpaths;
+    }
+    
+    return @[result];
+}
+
+- (WDPath *) erasePieceWithNodes:(const WDBezierNodeData *)nodes count:(NSUInteger)count
+{
+    WDPath *piece = [[WDPath alloc] init];
+    
+    [piece takeStylePropertiesFrom:self];
+    piece.nodeData = [NSData dataWithBytes:nodes length:count * sizeof(WDBezierNodeData)];
+    
+    return piece;
+}
+
 - (NSArray *) erase:(WDAbstractPath *)erasePath
 {
     if (self.closed) {
-        WDAbstractPath *result = [WDPathfinder combinePaths:@[self, erasePath] operation:WDPathFinderSubtract];
-        
-        if (!result) {
-            return @[];
-        }
-        
-        [result takeStylePropertiesFrom:self];
-        
-        if (self.superpath && [result isKindOfClass:[WDCompoundPath class]]) {
-            WDCompoundPath *cp = (WDCompoundPath *)result;
-            [[cp subpaths] makeObjectsPerformSelector:@selector(setSuperpath:) withObject:nil];
-            return cp.subpaths;
-        }
-        
-        return @[result];
+        return [self eraseResult:[WDPathfinder combinePaths:@[self, erasePath] operation:WDPathFinderSubtract]];
     } else {
         if (!CGRectIntersectsRect(self.bounds, erasePath.bounds)) {
             WDPath *clone = [[WDPath alloc] init];
             [clone takeStylePropertiesFrom:self];
-            NSMutableArray *nodes = [self.nodes mutableCopy];
-            clone.nodes = nodes;
+            clone.nodeData = nodeData_;
             
             NSArray *result = @[clone];
             return result;
         }
         
         // break down path
-        NSArray             *nodes = reversed_ ? [self reversedNodes] : nodes_;
-        NSInteger           segmentCount = nodes.count - 1;
-        WDBezierSegment     segments[segmentCount]; 
+        NSData                  *nodeData = reversed_ ? [self reversedNodeData] : nodeData_;
+        const WDBezierNodeData  *nodes = nodeData.bytes;
+        NSInteger               segmentCount = self.nodeCount - 1;
+        WDBezierSegment         *segments = malloc(segmentCount * sizeof(WDBezierSegment));
         
-        WDBezierSegment     *splitSegments;
-        NSUInteger          splitSegmentSize = 256;
-        int                 splitSegmentIx = 0;
+        for (int i = 1; i <= segmentCount; i++) {
+            segments[i-1] = WDBezierSegmentMakeWithData(nodes[i-1], nodes[i]);
+        }
+        
+        // the outline of the erase path, closing segments included
+        NSArray             *subpaths = [erasePath isKindOfClass:[WDPath class]] ? @[erasePath] : [(WDCompoundPath *)erasePath subpaths];
+        NSUInteger          eraseCount = 0;
         
-        WDBezierNode        *prev, *curr;
+        for (WDPath *subpath in subpaths) {
+            if (subpath.nodeCount > 1) {
+                eraseCount += subpath.closed ? subpath.nodeCount : subpath.nodeCount - 1;
+            }
+        }
         
-        // this might need to grow, so dynamically allocate it
-        splitSegments = calloc(sizeof(WDBezierSegment), splitSegmentSize);
+        WDBezierSegment     *eraseSegments = malloc(MAX(eraseCount, 1) * sizeof(WDBezierSegment));
+        NSUInteger          eraseIx = 0;
         
-        prev = nodes[0];
-        for (int i = 1; i < nodes.count; i++, prev = curr) {
-            curr = nodes[i];
-            segments[i-1] = WDBezierSegmentMake(prev, curr);
+        for (WDPath *subpath in subpaths) {
+            const WDBezierNodeData  *eraseNodes = subpath.nodeData.bytes;
+            NSUInteger              eraseNodeCount = subpath.nodeCount;
+            
+            if (eraseNodeCount < 2) {
+                continue;
+            }
+            
+            NSUInteger  numSegments = subpath.closed ? eraseNodeCount : eraseNodeCount - 1;
+            
+            for (NSUInteger n = 0; n < numSegments; n++) {
+                eraseSegments[eraseIx++] = WDBezierSegmentMakeWithData(eraseNodes[n], eraseNodes[(n + 1) % eraseNodeCount]);
+            }
         }
         
-        erasePath = [erasePath pathByFlatteningPath];
+        // all the crossings at once, sorted along the path
+        WDBezierIntersection    *intersections;
+        NSUInteger              intersectionCount = WDBezierSegmentsIntersect(segments, segmentCount, eraseSegments, eraseCount,
+                                                                              kIntersectionTolerance, &intersections);
         
+        // split the segments into more segments at every intersection with the erasing path
+        WDBezierSegment     *splitSegments = malloc((segmentCount + intersectionCount) * sizeof(WDBezierSegment));
+        int                 splitSegmentIx = 0;
+        NSUInteger          hit = 0;
         WDBezierSegment     L, R;
-        NSArray             *subpaths = [erasePath isKindOfClass:[WDPath class]] ? @[erasePath] : [(WDCompoundPath *)erasePath subpaths];
-        float               smallestT, t;
-        BOOL                intersected;
         
         for (int i = 0; i < segmentCount; i++) {
-            smallestT = MAXFLOAT;
-            intersected = NO;
+            WDBezierSegment remainder = segments[i];
+            float           start = 0; // where the remainder starts on the segment
             
-            // split the segments into more segments at every intersection with the erasing path
-            for (WDPath *subpath in subpaths) {
-                prev = (subpath.nodes)[0];
+            for (; hit < intersectionCount && intersections[hit].segment1 == i; hit++) {
+                float t = intersections[hit].t1;
                 
-                for (int n = 1; n < subpath.nodes.count; n++, prev = curr) {
-                    curr = (subpath.nodes)[n];
-                    
-                    if (WDBezierSegmentGetIntersection(segments[i], prev.anchorPoint, curr.anchorPoint, &t)) {
-                        if (t < smallestT && (fabs(t) > 0.001)) {
-                            smallestT = t;
-                            intersected = YES;
-                        }
-                    }
+                if (t - start < 0.001f || 1 - t < 0.001f) {
+                    continue;
                 }
-            }
                 
-            if (!intersected || fabs(1 - smallestT) < 0.001) {
-                splitSegments[splitSegmentIx++] = segments[i];
-            } else {
-                WDBezierSegmentSplitAtT(segments[i], &L, &R, smallestT);
-                                    
+                WDBezierSegmentSplitAtT(remainder, &L, &R, (t - start) / (1 - start));
                 splitSegments[splitSegmentIx++] = L;
-                segments[i] = R;
-                i--;
+                remainder = R;
+                start = t;
             }
             
-            if (splitSegmentIx >= splitSegmentSize) {
-                splitSegmentSize *= 2;
-                splitSegments = realloc(splitSegments, sizeof(WDBezierSegment) * splitSegmentSize);
-            }
+            splitSegments[splitSegmentIx++] = remainder;
         }
         
+        free(intersections);
+        free(eraseSegments);
+        free(segments);
+        
         // toss out any segment that's inside the erase path
-        WDBezierSegment newSegments[splitSegmentIx];
+        WDBezierSegment *newSegments = malloc(MAX(splitSegmentIx, 1) * sizeof(WDBezierSegment));
         int             newSegmentIx = 0;
         
         for (int i = 0; i < splitSegmentIx; i++) {
@@ -1767,34 +2011,32 @@ NSString *WDClosedKey = @"WDClosedKey";
         free(splitSegments);
                     
         if (newSegmentIx == 0) {
+            free(newSegments);
             return @[];
         }
         
-        // reassemble segments
-        NSMutableArray  *array = [NSMutableArray array];
-        WDPath          *currentPath = [[WDPath alloc] init];
-        
-        [currentPath takeStylePropertiesFrom:self];
-        [array addObject:currentPath];
+        // reassemble the segments into runs of packed nodes, and give each run its path in one go
+        WDBezierNodeData    *nodes = malloc(2 * newSegmentIx * sizeof(WDBezierNodeData));
+        NSMutableArray      *array = [NSMutableArray array];
+        NSUInteger          nodeCount = 0, runStart = 0;
         
         for (int i = 0; i < newSegmentIx; i++) {
-            WDBezierNode *lastNode = [currentPath lastNode];
-            
-            if (!lastNode) {            
-                [currentPath addNode:[WDBezierNode bezierNodeWithInPoint:newSegments[i].a_ anchorPoint:newSegments[i].a_ outPoint:newSegments[i].out_]];
-            } else if (CGPointEqualToPoint(lastNode.anchorPoint, newSegments[i].a_)) {
-                [currentPath replaceLastNodeWithNode:[WDBezierNode bezierNodeWithInPoint:lastNode.inPoint anchorPoint:lastNode.anchorPoint outPoint:newSegments[i].out_]];
+            if (nodeCount > 0 && CGPointEqualToPoint(nodes[nodeCount - 1].anchorPoint, newSegments[i].a_)) {
+                nodes[nodeCount - 1].outPoint = newSegments[i].out_;
             } else {
-                currentPath = [[WDPath alloc] init];
-                [currentPath takeStylePropertiesFrom:self];
-                [array addObject:currentPath];
-                
-                [currentPath addNode:[WDBezierNode bezierNodeWithInPoint:newSegments[i].a_ anchorPoint:newSegments[i].a_ outPoint:newSegments[i].out_]];
+                if (nodeCount > 0) {
+                    [array addObject:[self erasePieceWithNodes:nodes + runStart count:nodeCount - runStart]];
+                    runStart = nodeCount;
+                }
+                nodes[nodeCount++] = (WDBezierNodeData) {newSegments[i].a_, newSegments[i].a_, newSegments[i].out_};
             }
             
-            [currentPath addNode:[WDBezierNode bezierNodeWithInPoint:newSegments[i].in_ anchorPoint:newSegments[i].b_ outPoint:newSegments[i].b_]];
+            nodes[nodeCount++] = (WDBezierNodeData) {newSegments[i].in_, newSegments[i].b_, newSegments[i].b_};
         }
+        [array addObject:[self erasePieceWithNodes:nodes + runStart count:nodeCount - runStart]];
         
+        free(nodes);
+        free(newSegments);
         return array;
     }
 }
@@ -1803,18 +2045,19 @@ NSString *WDClosedKey = @"WDClosedKey";
 {
     // strip collinear anchors
     
-    if (nodes_.count < 3) {
+    if (self.nodeCount < 3) {
         return;
     }
     
+    NSArray         *nodes = self.nodes;
     NSMutableArray  *newNodes = [NSMutableArray array];
     WDBezierNode    *current, *next, *nextnext;
-    NSInteger       nodeCount = closed_ ? nodes_.count + 1 : nodes_.count;
+    NSInteger       nodeCount = closed_ ? nodes.count + 1 : nodes.count;
     NSInteger       ix = 0;
     
-    current = nodes_[ix++];
-    next = nodes_[ix++];
-    nextnext = nodes_[ix++];
+    current = nodes[ix++];
+    next = nodes[ix++];
+    nextnext = nodes[ix++];
     
     [newNodes addObject:current];
     
@@ -1833,7 +2076,7 @@ NSString *WDClosedKey = @"WDClosedKey";
         next = nextnext;
         
         if (ix < nodeCount) {
-            nextnext = nodes_[(ix % nodes_.count)];
+            nextnext = nodes[(ix % nodes.count)];
         } else {
             nextnext = nil;
         }
@@ -1847,9 +2090,9 @@ NSString *WDClosedKey = @"WDClosedKey";
     
     if (closed_) {
         // see if we should remove the first node
-        current = [nodes_ lastObject];
-        next = nodes_[0];
-        nextnext = nodes_[1];
+        current = [nodes lastObject];
+        next = nodes[0];
+        nextnext = nodes[1];
         
         if (WDCollinear(current.anchorPoint, current.outPoint, next.inPoint) &&
             WDCollinear(current.anchorPoint, next.inPoint, next.anchorPoint) &&
@@ -1864,37 +2107,47 @@ NSString *WDClosedKey = @"WDClosedKey";
     self.nodes = newNodes;
 }
 
-- (NSMutableArray *) flattenedNodes
+- (void) getFlattenedPoints:(WDPointBuffer *)buffer tolerance:(float)tolerance
 {
-    NSMutableArray      *flatNodes = [NSMutableArray array];
-    NSInteger           numNodes = closed_ ? nodes_.count : nodes_.count - 1;
-    WDBezierSegment     segment;
-    static CGPoint      *vertices = NULL;
-    static NSUInteger   size = 128;
-    NSUInteger          index = 0;
+    const WDBezierNodeData  *nodes = nodeData_.bytes;
+    NSUInteger              nodeCount = self.nodeCount;
+    NSUInteger              numSegments = closed_ ? nodeCount : nodeCount - 1;
     
-    if (!vertices) {
-        vertices = calloc(sizeof(CGPoint), size);
+    if (nodeCount == 0) {
+        return;
+    } else if (nodeCount == 1) {
+        WDPointBufferAdd(buffer, nodes[0].anchorPoint);
+        return;
     }
     
-    for (int i = 0; i < numNodes; i++) {
-        WDBezierNode *a = nodes_[i];
-        WDBezierNode *b = nodes_[(i+1) % nodes_.count];
-        
-        // reset the index for the current segment
-        index = 0;
-        
-        segment.a_ = a.anchorPoint;
-        segment.out_ = a.outPoint;
-        segment.in_ = b.inPoint;
-        segment.b_ = b.anchorPoint;
-        
-        WDBezierSegmentFlatten(segment, &vertices, &size, &index);
-        for (int v = 0; v < index; v++) {
-            [flatNodes addObject:[WDBezierNode bezierNodeWithAnchorPoint:vertices[v]]];
-        }
+    WDBezierSegment *segments = malloc(sizeof(WDBezierSegment) * numSegments);
+    
+    for (NSUInteger i = 0; i < numSegments; i++) {
+        segments[i] = WDBezierSegmentMakeWithData(nodes[i], nodes[(i+1) % nodeCount]);
+    }
+    
+    // a fresh polyline, even if the buffer holds others
+    WDPointBufferAdd(buffer, segments[0].a_);
+    WDBezierSegmentsFlatten(segments, numSegments, tolerance, buffer);
+    
+    free(segments);
+}
+
+- (NSMutableArray *) flattenedNodes
+{
+    WDPointBuffer   buffer = {NULL, 0, 0};
+    
+    [self getFlattenedPoints:&buffer tolerance:kDefaultFlattenTolerance];
+    
+    NSMutableArray  *flatNodes = [NSMutableArray arrayWithCapacity:buffer.count];
+    // a closed path comes back to its start, which the closing segment covers
+    NSUInteger      count = (closed_ && buffer.count > 1) ? buffer.count - 1 : buffer.count;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        [flatNodes addObject:[WDBezierNode bezierNodeWithAnchorPoint:buffer.points[i]]];
     }
     
+    WDPointBufferFree(&buffer);
     return flatNodes;
 }
 
@@ -1903,6 +2156,11 @@ NSString *WDClosedKey = @"WDClosedKey";
     self.nodes = [self flattenedNodes];
 }
 
+- (void) reduceNodesWithTolerance:(float)tolerance
+{
+    [WDCurveFit reduceNodesOfPaths:@[self] tolerance:tolerance];
+}
+
 - (WDAbstractPath *) pathByFlatteningPath
 {
     WDPath *flatPath = [[WDPath alloc] init];
@@ -1914,14 +2172,16 @@ NSString *WDClosedKey = @"WDClosedKey";
 
 - (NSString *) nodeSVGRepresentation
 {
-    NSArray         *nodes = reversed_ ? [self reversedNodes] : nodes_;
-    WDBezierNode    *node;
-    NSInteger       numNodes = closed_ ? nodes.count + 1 : nodes.count;
-    CGPoint         pt, prev_pt, in_pt, prev_out;
-    NSMutableString *svg = [NSMutableString string];
+    NSData                  *nodeData = reversed_ ? [self reversedNodeData] : nodeData_;
+    const WDBezierNodeData  *nodes = nodeData.bytes;
+    NSUInteger              nodeCount = self.nodeCount;
+    WDBezierNodeData        node;
+    NSInteger               numNodes = closed_ ? nodeCount + 1 : nodeCount;
+    CGPoint                 pt, prev_pt, in_pt, prev_out;
+    NSMutableString         *svg = [NSMutableString string];
     
     for(int i = 0; i < numNodes; i++) {
-        node = nodes[(i % nodes.count)];
+        node = nodes[(i % nodeCount)];
         
         if (i == 0) {
             pt = node.anchorPoint;
@@ -1953,9 +2213,11 @@ NSString *WDClosedKey = @"WDClosedKey";
 {       
     WDPath *path = [super copyWithZone:zone];
     
+    path->nodeData_ = nodeData_;
     path->nodes_ = [nodes_ mutableCopy];
     path->closed_ = closed_;
     path->reversed_ = reversed_;
+    path->knownSimple_ = knownSimple_;
     path->boundsDirty_ = YES;
 
     return path;
@@ -25,4 +25,16 @@ typedef enum {
 
 @interface WDPathfinder : NSObject
 + (WDAbstractPath *) combinePaths:(NSArray *)paths operation:(WDPathfinderOperation)operation;
+
+// subtracts erasePath from each of paths, converting the eraser only once and running the subtractions in parallel
+// returns one entry per path: the difference, or NSNull if nothing is left
+// paths whose bounds miss the eraser come back as an unchanged copy, without any conversion
++ (NSArray *) erasePaths:(NSArray *)paths withPath:(WDAbstractPath *)erasePath;
+
+// recent results are kept in a small LRU cache keyed by the geometry of the inputs, bounded by the size
+// of the geometry it holds on to
+// purgeCache also resets the counters
++ (NSUInteger) cacheHits;
++ (NSUInteger) cacheMisses;
++ (void) purgeCache;
 @end
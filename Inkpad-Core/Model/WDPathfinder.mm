@@ -20,6 +20,7 @@
 
 @interface WDPath (Livarot)
 - (Path *) convertToLivarotPath;
+- (BOOL) isAxisAlignedRect:(CGRect *)rect;
 @end
 
 @implementation WDPath (Livarot)
@@ -66,14 +67,144 @@
     return thePath;
 }
 
+- (BOOL) isAxisAlignedRect:(CGRect *)rect
+{
+    if (!self.closed || self.nodes.count != 4) {
+        return NO;
+    }
+    
+    for (WDBezierNode *node in self.nodes) {
+        if ([node hasInPoint] || [node hasOutPoint]) {
+            return NO;
+        }
+    }
+    
+    // the sides must alternate between horizontal and vertical
+    for (int i = 0; i < 4; i++) {
+        CGPoint a = ((WDBezierNode *) self.nodes[i]).anchorPoint;
+        CGPoint b = ((WDBezierNode *) self.nodes[(i+1) % 4]).anchorPoint;
+        CGPoint c = ((WDBezierNode *) self.nodes[(i+2) % 4]).anchorPoint;
+        
+        BOOL horizontal = (a.y == b.y && b.x == c.x);
+        BOOL vertical = (a.x == b.x && b.y == c.y);
+        
+        if (!horizontal && !vertical) {
+            return NO;
+        }
+    }
+    
+    CGPoint a = ((WDBezierNode *) self.nodes[0]).anchorPoint;
+    CGPoint c = ((WDBezierNode *) self.nodes[2]).anchorPoint;
+    
+    *rect = CGRectStandardize(CGRectMake(a.x, a.y, c.x - a.x, c.y - a.y));
+    
+    return !CGRectIsEmpty(*rect);
+}
+
+@end
+
+// fills and normalizes the livarot paths first..first+count-1 of one input, with their index as path ID
+// it only touches livarot, so it can run off the main thread (with its own temp)
+static Shape *NormalizedShape(Path **paths, int first, int count, BOOL single, BOOL knownSimple, Shape *temp)
+{
+    Shape *shape = new Shape();
+    
+    if (single) {
+        temp->Reset();
+        paths[first]->Fill(temp, first);
+        
+        // a single contour that doesn't cross itself only needs to be oriented, which is much cheaper than the full sweep
+        // (nonzero and even-odd agree on it, so this doesn't hold for compound paths)
+        temp->SetKnownSimple(knownSimple);
+        if (!temp->IntersectionFree() || shape->Reoriente(temp) != 0) {
+            shape->ConvertToShape(temp, fill_nonZero);
+        }
+    } else {
+        shape->ConvertToShape(paths, first, count, fill_nonZero, temp);
+    }
+    
+    return shape;
+}
+
+#define kPathfinderCacheSize   16
+#define kPathfinderCacheBytes  (1024 * 1024)
+
+// the inputs of a combinePaths: call, flattened to bytes; equal keys have identical geometry
+@interface WDPathfinderCacheKey : NSObject <NSCopying> {
+    NSData      *data_;
+    NSUInteger  hash_;
+}
+- (id) initWithData:(NSData *)data;
+- (NSUInteger) length;
+@end
+
+@implementation WDPathfinderCacheKey
+
+- (id) initWithData:(NSData *)data
+{
+    self = [super init];
+    
+    if (!self) {
+        return nil;
+    }
+    
+    data_ = data;
+    
+    // FNV-1a over all the bytes (NSData only hashes the first few)
+    const uint8_t   *bytes = (const uint8_t *) data.bytes;
+    uint64_t        hash = 14695981039346656037ULL;
+    
+    for (NSUInteger i = 0; i < data.length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    hash_ = (NSUInteger) (hash ^ (hash >> 32));
+    
+    return self;
+}
+
+- (NSUInteger) hash
+{
+    return hash_;
+}
+
+- (NSUInteger) length
+{
+    return data_.length;
+}
+
+- (BOOL) isEqual:(WDPathfinderCacheKey *)key
+{
+    if (key == self) {
+        return YES;
+    }
+    
+    if (![key isKindOfClass:[WDPathfinderCacheKey class]] || key->hash_ != hash_) {
+        return NO;
+    }
+    
+    return [data_ isEqualToData:key->data_];
+}
+
+- (id) copyWithZone:(NSZone *)zone
+{
+    // immutable
+    return self;
+}
+
 @end
 
+static NSMutableDictionary  *resultCache_ = nil;   // key -> array of node arrays (never handed out)
+static NSMutableArray       *cacheOrder_ = nil;    // keys, least recently used first
+static NSUInteger           cacheBytes_ = 0;      // size of the cached keys and nodes, packed
+static NSUInteger           cacheHits_ = 0;
+static NSUInteger           cacheMisses_ = 0;
+
 @implementation WDPathfinder
 
-+ (WDAbstractPath *) fromLivarotPath:(Path *)path
++ (NSArray *) subpathNodesFromLivarotPath:(Path *)path
 {
     NSMutableArray  *subpaths = [NSMutableArray array];
-    WDPath          *currentPath = [[WDPath alloc] init];
     NSMutableArray  *nodes = [NSMutableArray array];
     
 	for (int i = 0; i <path->descr_nb; i++) {
@@ -99,15 +230,26 @@
                                                      anchorPoint:anchorPoint
                                                         outPoint:anchorPoint]];
 		} else if ( ty == descr_close ) {
-            currentPath.nodes = nodes;
-            currentPath.closed = YES;
+            [subpaths addObject:nodes];
             nodes = [NSMutableArray array];
-            
-            [subpaths addObject:currentPath];
-            currentPath = [[WDPath alloc] init];
 		}
 	}
     
+    return subpaths;
+}
+
+// the nodes are copied, so that the cached ones never end up in the drawing
++ (WDAbstractPath *) pathWithSubpathNodes:(NSArray *)subpathNodes
+{
+    NSMutableArray  *subpaths = [NSMutableArray array];
+    
+    for (NSArray *nodes in subpathNodes) {
+        WDPath *path = [[WDPath alloc] init];
+        path.nodes = [[NSMutableArray alloc] initWithArray:nodes copyItems:YES];
+        path.closed = YES;
+        
+        [subpaths addObject:path];
+    }
     
     if (subpaths.count > 1) {
         WDCompoundPath  *compoundPath = [[WDCompoundPath alloc] init];
@@ -118,7 +260,132 @@
     }
 }
 
+// what an entry keeps alive, counting each node as its 3 points: the key holds the input nodes, the value the result's
++ (NSUInteger) cacheSizeForKey:(WDPathfinderCacheKey *)key subpathNodes:(NSArray *)subpathNodes
+{
+    NSUInteger size = key.length;
+    
+    for (NSArray *nodes in subpathNodes) {
+        size += nodes.count * 3 * sizeof(CGPoint);
+    }
+    
+    return size;
+}
+
++ (WDPathfinderCacheKey *) cacheKeyForPaths:(NSArray *)abstractPaths operation:(WDPathfinderOperation)operation
+{
+    NSMutableData   *data = [NSMutableData data];
+    int32_t         header[2] = { (int32_t) operation, (int32_t) abstractPaths.count };
+    
+    [data appendBytes:header length:sizeof(header)];
+    
+    for (WDAbstractPath *ap in abstractPaths) {
+        NSArray *subpaths = [ap isKindOfClass:[WDCompoundPath class]] ? ((WDCompoundPath *) ap).subpaths : @[ap];
+        int32_t info[2] = { (int32_t) ap.fillRule, (int32_t) subpaths.count };
+        
+        [data appendBytes:info length:sizeof(info)];
+        
+        for (WDPath *path in subpaths) {
+            // knownSimple picks the cheaper conversion, it doesn't change the result, but keep the keys honest
+            int32_t flags[4] = { path.closed, path.reversed, path.knownSimple, (int32_t) path.nodeCount };
+            
+            [data appendBytes:flags length:sizeof(flags)];
+            
+            // the packed nodes as they are, without making node objects
+            [data appendData:path.nodeData];
+        }
+    }
+    
+    return [[WDPathfinderCacheKey alloc] initWithData:data];
+}
+
 + (WDAbstractPath *) combinePaths:(NSArray *)abstractPaths operation:(WDPathfinderOperation)operation
+{
+    WDPathfinderCacheKey    *key = [self cacheKeyForPaths:abstractPaths operation:operation];
+    NSArray                 *subpathNodes = nil;
+    
+    @synchronized(self) {
+        if (!resultCache_) {
+            resultCache_ = [[NSMutableDictionary alloc] init];
+            cacheOrder_ = [[NSMutableArray alloc] init];
+        }
+        
+        subpathNodes = resultCache_[key];
+        if (subpathNodes) {
+            cacheHits_++;
+            [cacheOrder_ removeObject:key];
+            [cacheOrder_ addObject:key];
+        } else {
+            cacheMisses_++;
+        }
+    }
+    
+    if (!subpathNodes) {
+        subpathNodes = [self subpathNodesByCombiningPaths:abstractPaths operation:operation];
+        
+        NSUInteger size = [self cacheSizeForKey:key subpathNodes:subpathNodes];
+        
+        @synchronized(self) {
+            // a result bigger than the whole cache would only flush it
+            if (!resultCache_[key] && size <= kPathfinderCacheBytes) {
+                resultCache_[key] = subpathNodes;
+                [cacheOrder_ addObject:key];
+                cacheBytes_ += size;
+                
+                while (cacheOrder_.count > kPathfinderCacheSize || cacheBytes_ > kPathfinderCacheBytes) {
+                    WDPathfinderCacheKey *oldest = cacheOrder_[0];
+                    
+                    cacheBytes_ -= [self cacheSizeForKey:oldest subpathNodes:resultCache_[oldest]];
+                    [resultCache_ removeObjectForKey:oldest];
+                    [cacheOrder_ removeObjectAtIndex:0];
+                }
+            }
+        }
+    }
+    
+    return [self pathWithSubpathNodes:subpathNodes];
+}
+
++ (NSUInteger) cacheHits
+{
+    @synchronized(self) {
+        return cacheHits_;
+    }
+}
+
++ (NSUInteger) cacheMisses
+{
+    @synchronized(self) {
+        return cacheMisses_;
+    }
+}
+
++ (void) purgeCache
+{
+    @synchronized(self) {
+        [resultCache_ removeAllObjects];
+        [cacheOrder_ removeAllObjects];
+        cacheBytes_ = 0;
+        cacheHits_ = cacheMisses_ = 0;
+    }
+}
+
++ (int) convertPath:(WDAbstractPath *)ap toLivarotPaths:(Path **)paths
+{
+    if (ap.subpathCount == 1) {
+        paths[0] = [((WDPath *) ap) convertToLivarotPath];
+        return 1;
+    }
+    
+    int i = 0;
+    for (WDPath *sp in ((WDCompoundPath *) ap).subpaths) {
+        paths[i++] = [sp convertToLivarotPath];
+    }
+    
+    return i;
+}
+
++ (NSArray *) subpathNodesByCombiningPaths:(NSArray *)abstractPaths operation:(WDPathfinderOperation)operation
 {    
     int     pathCount = 0;
     
@@ -130,41 +397,40 @@
     Shape  *temp = new Shape();
     Shape   *shapes[pathCount];
     Shape   *result;
+    CGRect  clipRects[pathCount];
+    BOOL    isClipRect[pathCount];
     int     i = 0, shapeIx = 0;
     
     for (WDAbstractPath *ap in abstractPaths) {
-        if (ap.subpathCount == 1) {
-            paths[i] = [((WDPath *) ap) convertToLivarotPath];
-            
-            temp->Reset();
-            paths[i]->Fill(temp, i);
-            shapes[shapeIx] = new Shape();
-            shapes[shapeIx]->ConvertToShape(temp, fill_nonZero);
-            i++;
-            shapeIx++;
-            
-        } else {
-            WDCompoundPath *cp = (WDCompoundPath *) ap;
-            
-            temp->Reset();
-            
-            for (WDPath *sp in cp.subpaths) {
-                paths[i] = [sp convertToLivarotPath];
-                paths[i]->Fill(temp, i, true);
-                i++;
-            }
-            
-            shapes[shapeIx] = new Shape();
-            shapes[shapeIx]->ConvertToShape(temp, fill_nonZero);
-    
-            shapeIx++;
-        }
+        BOOL single = (ap.subpathCount == 1);
+        int  count = [WDPathfinder convertPath:ap toLivarotPaths:&paths[i]];
+        
+        isClipRect[shapeIx] = single ? [((WDPath *) ap) isAxisAlignedRect:&clipRects[shapeIx]] : NO;
+        shapes[shapeIx] = NormalizedShape(paths, i, count, single, single && ((WDPath *) ap).knownSimple, temp);
+        
+        i += count;
+        shapeIx++;
     }
     
     Shape *prev = shapes[0];
     for (int i = 1; i < shapeIx; i++) {
         result = new Shape();
-        result->Booleen(prev, shapes[i], (BooleanOp) operation);
+        
+        if (operation == WDPathfinderIntersect && (isClipRect[i] || (i == 1 && isClipRect[0]))) {
+            // intersecting with an axis-aligned rectangle doesn't need a sweep
+            Shape   *clipped = isClipRect[i] ? prev : shapes[i];
+            CGRect  rect = isClipRect[i] ? clipRects[i] : clipRects[0];
+            bool    usedBooleen;
+            
+            result->ClipToRect(clipped, CGRectGetMinX(rect), CGRectGetMinY(rect), CGRectGetMaxX(rect), CGRectGetMaxY(rect), usedBooleen);
+#if WD_DEBUG
+            if (usedBooleen) {
+                NSLog(@"Rectangle clipping fell back to a boolean operation");
+            }
+#endif
+        } else {
+            result->Booleen(prev, shapes[i], (BooleanOp) operation);
+        }
         
         if (i != 1) {
             delete prev;
@@ -174,7 +440,7 @@
     
     Path *dest = new Path();
     result->ConvertToForme(dest, pathCount, paths);
-    WDAbstractPath *finalResult = [WDPathfinder fromLivarotPath:dest];
+    NSArray *finalResult = [WDPathfinder subpathNodesFromLivarotPath:dest];
     delete dest;
     delete result;
     
@@ -189,4 +455,128 @@
     return finalResult;
 }
 
++ (WDAbstractPath *) untouchedCopyOfPath:(WDAbstractPath *)ap
+{
+    NSArray         *subpaths = (ap.subpathCount == 1) ? @[ap] : ((WDCompoundPath *) ap).subpaths;
+    NSMutableArray  *copies = [NSMutableArray array];
+    
+    for (WDPath *path in subpaths) {
+        WDPath *copy = [[WDPath alloc] init];
+        copy.nodes = [[NSMutableArray alloc] initWithArray:(path.reversed ? [path reversedNodes] : path.nodes) copyItems:YES];
+        copy.closed = path.closed;
+        
+        [copies addObject:copy];
+    }
+    
+    if (copies.count > 1) {
+        WDCompoundPath  *compoundPath = [[WDCompoundPath alloc] init];
+        compoundPath.subpaths = copies;
+        return compoundPath;
+    } else {
+        return [copies lastObject];
+    }
+}
+
++ (NSArray *) erasePaths:(NSArray *)abstractPaths withPath:(WDAbstractPath *)erasePath
+{
+    NSUInteger      count = abstractPaths.count;
+    NSMutableArray  *results = [NSMutableArray arrayWithCapacity:count];
+    
+    if (count == 0) {
+        return results;
+    }
+    
+    CGRect  eraseBounds = erasePath.bounds;
+    int     eraseCount = (int) erasePath.subpathCount;
+    Path    *erasePaths[eraseCount];
+    Shape   *temp = new Shape();
+    BOOL    single = (eraseCount == 1);
+    
+    // the eraser is converted and normalized once, and its subpaths take the path IDs 0..eraseCount-1
+    [WDPathfinder convertPath:erasePath toLivarotPaths:erasePaths];
+    Shape *eraser = NormalizedShape(erasePaths, 0, eraseCount, single, single && ((WDPath *) erasePath).knownSimple, temp);
+    delete temp;
+    
+    // the inputs are read here, on the calling thread; the subpaths of each one come after the eraser's,
+    // so that the back data of a difference indexes a single array
+    // inputs that miss the eraser keep a count of 0 and aren't converted at all
+    Path    ***paths = (Path ***) calloc(count, sizeof(Path **));
+    int     *pathCounts = (int *) calloc(count, sizeof(int));
+    BOOL    *simple = (BOOL *) calloc(count, sizeof(BOOL));
+    Path    **dests = (Path **) calloc(count, sizeof(Path *));
+    
+    for (NSUInteger t = 0; t < count; t++) {
+        WDAbstractPath *ap = abstractPaths[t];
+        
+        if (!CGRectIntersectsRect(eraseBounds, ap.bounds)) {
+            continue;
+        }
+        
+        pathCounts[t] = (int) ap.subpathCount;
+        paths[t] = (Path **) malloc((eraseCount + pathCounts[t]) * sizeof(Path *));
+        memcpy(paths[t], erasePaths, eraseCount * sizeof(Path *));
+        [WDPathfinder convertPath:ap toLivarotPaths:paths[t] + eraseCount];
+        simple[t] = (pathCounts[t] == 1) && ((WDPath *) ap).knownSimple;
+    }
+    
+    // the subtractions only touch livarot, so they run in parallel; the sweep writes its temporary data
+    // into its inputs, so each worker subtracts its own copy of the eraser
+    size_t  workers = MIN(count, [NSProcessInfo processInfo].activeProcessorCount);
+    
+    dispatch_apply(workers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t worker) {
+        Shape   *ownEraser = new Shape();
+        Shape   *ownTemp = new Shape();
+        
+        ownEraser->Copy(eraser, true);
+        
+        for (size_t t = worker; t < count; t += workers) {
+            if (pathCounts[t] == 0) {
+                continue;
+            }
+            
+            Shape *shape = NormalizedShape(paths[t], eraseCount, pathCounts[t], pathCounts[t] == 1, simple[t], ownTemp);
+            Shape *difference = new Shape();
+            
+            difference->Booleen(shape, ownEraser, bool_op_diff);
+            
+            dests[t] = new Path();
+            difference->ConvertToForme(dests[t], eraseCount + pathCounts[t], paths[t]);
+            
+            delete difference;
+            delete shape;
+        }
+        
+        delete ownTemp;
+        delete ownEraser;
+    });
+    
+    for (NSUInteger t = 0; t < count; t++) {
+        if (pathCounts[t] == 0) {
+            [results addObject:[self untouchedCopyOfPath:abstractPaths[t]]];
+            continue;
+        }
+        
+        WDAbstractPath *difference = [self pathWithSubpathNodes:[self subpathNodesFromLivarotPath:dests[t]]];
+        [results addObject:(difference ?: [NSNull null])];
+        
+        delete dests[t];
+        for (int i = eraseCount; i < eraseCount + pathCounts[t]; i++) {
+            delete paths[t][i];
+        }
+        free(paths[t]);
+    }
+    
+    free(paths);
+    free(pathCounts);
+    free(simple);
+    free(dests);
+    
+    for (int i = 0; i < eraseCount; i++) {
+        delete erasePaths[i];
+    }
+    delete eraser;
+    
+    return results;
+}
+
 @end
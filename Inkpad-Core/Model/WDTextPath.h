@@ -33,6 +33,8 @@ typedef enum {
     
     CGRect                  styleBounds_;
     
+    WDBezierArcLengthTable  *arcLengthTables_; // per segment, in natural space
+    
     NSString                *cachedText_;
     NSNumber                *cachedStartOffset_;
 }
@@ -86,6 +86,8 @@ NSString *WDTextPathAlignmentKey = @"WDTextPathAlignmentKey";
     if (fontRef_) {
         CFRelease(fontRef_);
     }
+    
+    free(arcLengthTables_);
 }
 
 - (void)encodeWithCoder:(NSCoder *)coder
@@ -332,16 +334,30 @@ NSString *WDTextPathAlignmentKey = @"WDTextPathAlignmentKey";
 
 - (CGPoint) getPointOnPathAtDistance:(float)distance tangentVector:(CGPoint *)tangent transformed:(BOOL)transformed
 {
-    NSArray             *nodes = reversed_ ? [self reversedNodes] : nodes_;
+    if (transformed) {
+        WDBezierArcLengthTable  *tables = [self arcLengthTables];
+        NSInteger               numSegments = [self segmentCount];
+        
+        for (int i = 0; i < numSegments; i++) {
+            if (distance < tables[i].length) {
+                return WDBezierArcLengthTablePointAtDistance(&tables[i], distance, tangent, NULL);
+            }
+            
+            distance -= tables[i].length;
+        }
+        
+        return CGPointZero;
+    }
+    
+    NSArray             *nodes = reversed_ ? [self reversedNodes] : self.nodes;
     NSInteger           numNodes = closed_ ? (nodes.count + 1) : nodes.count;
     WDBezierSegment     segment;
     WDBezierNode        *prev, *curr;
     float               length = 0;
-    CGAffineTransform   inverse = transformed ? CGAffineTransformInvert(transform_) : CGAffineTransformIdentity;
     
-    prev = [nodes[0] transform:inverse];
+    prev = nodes[0];
     for (int i = 1; i < numNodes; i++) {
-        curr = [nodes[(i % nodes.count)] transform:inverse];
+        curr = nodes[(i % nodes.count)];
         
         segment = WDBezierSegmentMake(prev, curr);
         length = WDBezierSegmentLength(segment);
@@ -362,11 +378,39 @@ NSString *WDTextPathAlignmentKey = @"WDTextPathAlignmentKey";
 {
     [super invalidatePath];
     needsLayout_ = YES;
+    
+    free(arcLengthTables_);
+    arcLengthTables_ = NULL;
+}
+
+/*
+ * Arc length tables of the segments in natural space. They only depend on the path, so they
+ * survive text and style changes, and are rebuilt on the first layout after the path changes.
+ */
+- (WDBezierArcLengthTable *) arcLengthTables
+{
+    if (!arcLengthTables_) {
+        NSArray             *nodes = reversed_ ? [self reversedNodes] : self.nodes;
+        NSInteger           numSegments = [self segmentCount];
+        CGAffineTransform   inverse = CGAffineTransformInvert(transform_);
+        WDBezierNode        *prev, *curr;
+        
+        arcLengthTables_ = malloc(sizeof(WDBezierArcLengthTable) * MAX(numSegments, 1));
+        
+        prev = [nodes[0] transform:inverse];
+        for (int i = 0; i < numSegments; i++) {
+            curr = [nodes[((i + 1) % nodes.count)] transform:inverse];
+            WDBezierArcLengthTableInit(&arcLengthTables_[i], WDBezierSegmentMake(prev, curr));
+            prev = curr;
+        }
+    }
+    
+    return arcLengthTables_;
 }
 
 - (float) getSegments:(WDBezierSegment *)segments andLengths:(float *)lengths naturalSpace:(BOOL)transform
 {
-    NSArray             *nodes = reversed_ ? [self reversedNodes] : nodes_;
+    NSArray             *nodes = reversed_ ? [self reversedNodes] : self.nodes;
     NSInteger           numNodes = closed_ ? (nodes.count + 1) : nodes.count;
     WDBezierNode        *prev, *curr;
     CGAffineTransform   inverse = transform ? CGAffineTransformInvert(transform_) : CGAffineTransformIdentity;
@@ -389,6 +433,18 @@ NSString *WDTextPathAlignmentKey = @"WDTextPathAlignmentKey";
 - (float) length:(BOOL)naturalSpace
 {
     NSInteger           numSegments = [self segmentCount];
+    
+    if (naturalSpace) {
+        WDBezierArcLengthTable  *tables = [self arcLengthTables];
+        float                   totalLength = 0.0f;
+        
+        for (int i = 0; i < numSegments; i++) {
+            totalLength += tables[i].length;
+        }
+        
+        return totalLength;
+    }
+    
     WDBezierSegment     segments[numSegments];
     float               lengths[numSegments];
     
@@ -407,7 +463,7 @@ NSString *WDTextPathAlignmentKey = @"WDTextPathAlignmentKey";
 
 - (NSInteger) segmentCount
 {
-    return (closed_ ? nodes_.count : (nodes_.count - 1));
+    return (closed_ ? self.nodeCount : (self.nodeCount - 1));
 }
 
 - (void) layout
@@ -440,14 +496,19 @@ NSString *WDTextPathAlignmentKey = @"WDTextPathAlignmentKey";
         return;
     }
     
-    NSInteger           numSegments = [self segmentCount];
-    WDBezierSegment     segments[numSegments];
-    float               lengths[numSegments];
-    float               totalLength = 0;
-    WDQuad              glyphQuad, prevGlyphQuad = WDQuadNull();
+    NSInteger               numSegments = [self segmentCount];
+    WDBezierArcLengthTable  *tables = [self arcLengthTables];
+    WDBezierSegment         segments[numSegments];
+    float                   lengths[numSegments];
+    float                   totalLength = 0;
+    WDQuad                  glyphQuad, prevGlyphQuad = WDQuadNull();
     
-    // precalculate the segments and their arc lengths
-    totalLength = [self getSegments:segments andLengths:lengths naturalSpace:YES];
+    // the segments and their arc lengths come from the cached tables
+    for (int i = 0; i < numSegments; i++) {
+        segments[i] = tables[i].segment;
+        lengths[i] = tables[i].length;
+        totalLength += lengths[i];
+    }
     
     CFArrayRef  runArray = CTLineGetGlyphRuns(line);
     CFIndex     runCount = CFArrayGetCount(runArray);
@@ -522,7 +583,7 @@ NSString *WDTextPathAlignmentKey = @"WDTextPathAlignmentKey";
                 }
             }
 
-            CGPoint result = WDBezierSegmentPointAndTangentAtDistance(segments[currentSegment % numSegments], (midGlyph - cumulativeSegmentLength), &tangent, &curvature);
+            CGPoint result = WDBezierArcLengthTablePointAtDistance(&tables[currentSegment % numSegments], (midGlyph - cumulativeSegmentLength), &tangent, &curvature);
             
             if (curvature > 0) {
                 avoidPreviousGlyph = YES;
@@ -726,7 +787,7 @@ done:
     UIColor     *color = displayColor_ ? displayColor_ : self.layer.highlightColor;
     
     if (!closed_) {
-        NSArray *nodes = reversed_ ? [self reversedNodes] : nodes_;
+        NSArray *nodes = reversed_ ? [self reversedNodes] : self.nodes;
         WDBezierNode *lastNode = [nodes lastObject];
         overflowPoint = CGPointApplyAffineTransform(lastNode.anchorPoint, viewTransform);
         selected = lastNode.selected;
@@ -912,33 +973,31 @@ done:
 
 - (void) moveStartKnobToNearestPoint:(CGPoint)pt
 {
-    NSInteger           numSegments = [self segmentCount];
-    WDBezierSegment     segments[numSegments];
-    float               lengths[numSegments];
-    float               lowestError = MAXFLOAT;
-    int                 closestSegmentIx = 0;
-    float               distanceAlongPath = 0;
+    NSInteger               numSegments = [self segmentCount];
+    WDBezierArcLengthTable  *tables = [self arcLengthTables];
+    WDBezierSegment         segments[numSegments];
+    NSUInteger              closestSegmentIx;
+    float                   t, distanceAlongPath = 0;
     
     CGAffineTransform invert = CGAffineTransformInvert(transform_);
     pt = CGPointApplyAffineTransform(pt, invert);
     
-    // precalculate the segments and their arc lengths
-    [self getSegments:segments andLengths:lengths naturalSpace:YES];
-    
     for (int i = 0; i < numSegments; i++) {
-        float   error, distance;
-        WDBezierSegmentGetClosestPoint(segments[i], pt, &error, &distance);
-        
-        if (error < lowestError) {
-            lowestError = error;
-            closestSegmentIx = i;
-            distanceAlongPath = distance;
-        }
+        segments[i] = tables[i].segment;
+    }
+    
+    closestSegmentIx = WDBezierSegmentsNearestPoint(segments, numSegments, pt, MAXFLOAT, NULL, &t);
+    
+    if (closestSegmentIx == NSNotFound) {
+        closestSegmentIx = 0;
+    } else {
+        // measured by the tables the glyphs are laid out with, so that the text starts under the knob
+        distanceAlongPath = WDBezierArcLengthTableDistanceAtT(&tables[closestSegmentIx], t);
     }
     
     float sum = distanceAlongPath;
     for (int i = 0; i < closestSegmentIx; i++) {
-        sum += lengths[i];
+        sum += tables[i].length;
     }
     
     startOffset_ = sum;
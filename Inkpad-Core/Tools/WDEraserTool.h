@@ -9,12 +9,15 @@
 //  Copyright (c) 2011-2013 Steve Sprang
 //
 
+#import "WDBezierSegment.h"
 #import "WDTool.h"
 
 @class WDPath;
 
 @interface WDEraserTool : WDTool {
     WDPath              *tempPath_;
+    WDPointBuffer       points_;        // the stroke, for the fit when it ends
+    NSMutableData       *previewNodes_; // the same points as packed nodes, for tempPath_
     NSUInteger          eraserSize_;
     
 #if TARGET_OS_IPHONE
@@ -22,6 +22,7 @@
 NSString *WDEraserToolSize = @"WDEraserToolSize";
 
 #define kMaxError   5.0f
+#define kCornerAngle (M_PI / 2)
 
 @implementation WDEraserTool
 
@@ -47,26 +48,44 @@ NSString *WDEraserToolSize = @"WDEraserToolSize";
     return self;
 }
 
+- (void) dealloc
+{
+    WDPointBufferFree(&points_);
+}
+
+// appends a point to the stroke, and shows the stroke so far
+- (void) addPoint:(CGPoint)pt inCanvas:(WDCanvas *)canvas
+{
+    WDBezierNodeData node = {pt, pt, pt};
+    
+    WDPointBufferAdd(&points_, pt);
+    [previewNodes_ appendBytes:&node length:sizeof(WDBezierNodeData)];
+    
+    tempPath_.nodeData = previewNodes_;
+    canvas.eraserPath = tempPath_;
+}
+
 - (void) beginWithEvent:(WDEvent *)theEvent inCanvas:(WDCanvas *)canvas
 {
-    tempPath_ = [[WDPath alloc] initWithNode:[WDBezierNode bezierNodeWithAnchorPoint:theEvent.location]];
+    // the buffer keeps its memory from the last stroke
+    points_.count = 0;
+    previewNodes_ = [NSMutableData data];
     
+    tempPath_ = [[WDPath alloc] init];
     tempPath_.strokeStyle = [WDStrokeStyle strokeStyleWithWidth:eraserSize_ cap:kCGLineCapRound
                                                            join:kCGLineJoinRound
                                                           color:[WDColor colorWithWhite:0.9f alpha:0.85f]
                                                     dashPattern:nil];
-    canvas.eraserPath = tempPath_;
+    [self addPoint:theEvent.location inCanvas:canvas];
 }
 
 - (void) moveWithEvent:(WDEvent *)theEvent inCanvas:(WDCanvas *)canvas
 {
-    if (WDDistance(theEvent.location, [tempPath_ lastNode].anchorPoint) < (3.0f / canvas.viewScale)) {
+    if (WDDistance(theEvent.location, points_.points[points_.count - 1]) < (3.0f / canvas.viewScale)) {
         return;
     }
     
-    [tempPath_.nodes addObject:[WDBezierNode bezierNodeWithAnchorPoint:theEvent.location]];
-    [tempPath_ invalidatePath];
-    canvas.eraserPath = tempPath_;
+    [self addPoint:theEvent.location inCanvas:canvas];
     
     [canvas invalidateSelectionView];
 }
@@ -75,13 +94,10 @@ NSString *WDEraserToolSize = @"WDEraserToolSize";
 {
     canvas.eraserPath = nil;
     
-    if (tempPath_ && [tempPath_.nodes count] > 1) {
-        NSMutableArray *points = [NSMutableArray array];
-        for (WDBezierNode *node in tempPath_.nodes) {
-            [points addObject:[NSValue valueWithCGPoint:node.anchorPoint]];
-        }
-        
-        WDPath *smoothPath = [WDCurveFit smoothPathForPoints:points error:(kMaxError / canvas.viewScale) attemptToClose:NO];
+    if (tempPath_ && points_.count > 1) {
+        // keep the sharp turns of the stroke as corners, instead of rounding them off
+        WDPath *smoothPath = [WDCurveFit smoothPathForPoints:points_.points count:points_.count error:(kMaxError / canvas.viewScale)
+                                                 cornerAngle:kCornerAngle attemptToClose:NO];
         
         if (smoothPath) {
             smoothPath.strokeStyle = [WDStrokeStyle strokeStyleWithWidth:eraserSize_
@@ -96,6 +112,7 @@ NSString *WDEraserToolSize = @"WDEraserToolSize";
     }
     
     tempPath_ = nil;
+    previewNodes_ = nil;
 }
 
 #if TARGET_OS_IPHONE
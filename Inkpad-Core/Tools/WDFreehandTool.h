@@ -11,11 +11,13 @@
 
 #import "WDTool.h"
 
+@class WDIncrementalCurveFit;
 @class WDPath;
 
 @interface WDFreehandTool : WDTool {
-    WDPath          *tempPath_;
-    BOOL            pathStarted_;
+    WDPath                  *tempPath_;
+    WDIncrementalCurveFit   *curveFit_;
+    BOOL                    pathStarted_;
 }
 
 @property (nonatomic, assign) BOOL closeShape;
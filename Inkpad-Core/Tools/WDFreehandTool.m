@@ -56,6 +56,10 @@ NSString *WDDefaultFreehandTool = @"WDDefaultFreehandTool";
     
     pathStarted_ = YES;
     
+    // we're drawing free form closed shapes... let's relax the error
+    float maxError = (kMaxError / canvas.viewScale) * (closeShape_ ? 5 : 1);
+    curveFit_ = [[WDIncrementalCurveFit alloc] initWithError:maxError];
+    
     tempPath_ = [[WDPath alloc] init];
     canvas.shapeUnderConstruction = tempPath_;
     
@@ -64,36 +68,31 @@ NSString *WDDefaultFreehandTool = @"WDDefaultFreehandTool";
 
 - (void) moveWithEvent:(WDEvent *)theEvent inCanvas:(WDCanvas *)canvas
 {
-    [tempPath_.nodes addObject:[WDBezierNode bezierNodeWithAnchorPoint:theEvent.location]];
+    // the curves are fitted as the points come, so the stroke is previewed as it will end up
+    [curveFit_ addPoint:theEvent.location];
+    tempPath_.nodes = [curveFit_ nodesUpdatingNodes:tempPath_.nodes];
+    
     [canvas invalidateSelectionView];
 }
 
 - (void) endWithEvent:(WDEvent *)theEvent inCanvas:(WDCanvas *)canvas
 {
-    if (pathStarted_ && [tempPath_.nodes count] > 1) {
-        float maxError = (kMaxError / canvas.viewScale);
+    if (pathStarted_ && curveFit_.pointCount > 1) {
+        float maxError = (kMaxError / canvas.viewScale) * (closeShape_ ? 5 : 1);
         
         canvas.shapeUnderConstruction = nil;
         
-        NSMutableArray *points = [NSMutableArray array];
-        for (WDBezierNode *node in tempPath_.nodes) {
-            [points addObject:[NSValue valueWithCGPoint:node.anchorPoint]];
-        }
-        
-        if (closeShape_ && tempPath_.nodes.count > 2) {
-            // we're drawing free form closed shapes... let's relax the error
-            maxError *= 5;
-            
+        if (closeShape_ && curveFit_.pointCount > 2) {
             // add the first point at the end to make sure we close
-            CGPoint first = [points[0] CGPointValue];
-            CGPoint last = [[points lastObject] CGPointValue];
+            CGPoint first = curveFit_.firstPoint;
+            CGPoint last = curveFit_.lastPoint;
                 
             if (WDDistance(first, last) >= (maxError*2)) {
-                [points addObject:points[0]];
+                [curveFit_ addPoint:first];
             }
         }
         
-        WDPath *smoothPath = [WDCurveFit smoothPathForPoints:points error:maxError attemptToClose:YES];
+        WDPath *smoothPath = [curveFit_ smoothPathAttemptingToClose:YES];
         
         if (smoothPath) {
             smoothPath.fill = [canvas.drawingController.propertyManager activeFillStyle];
@@ -108,6 +107,7 @@ NSString *WDDefaultFreehandTool = @"WDDefaultFreehandTool";
     
     pathStarted_ = NO;
     tempPath_ = nil;
+    curveFit_ = nil;
 }
 
 @end
@@ -20,6 +20,9 @@
 
 #import "WDBezierSegment.h"
 
+// how far the drawn polylines may stray from the curves, in view points
+extern const float kGLFlattenTolerance;
+
 void WDGLFillRect(CGRect rect);
 void WDGLStrokeRect(CGRect rect);
 void WDGLFillCircle(CGPoint center, float radius, int sides);
@@ -27,7 +30,7 @@ void WDGLStrokeCircle(CGPoint center, float radius, int sides);
 void WDGLLineFromPointToPoint(CGPoint a, CGPoint b);
 void WDGLFillDiamond(CGPoint center, float dimension);
 
-void WDGLFlattenBezierSegment(WDBezierSegment seg, GLfloat **vertices, NSUInteger *size, NSUInteger *index);
+void WDGLFlattenBezierSegment(WDBezierSegment seg, float tolerance, GLfloat **vertices, NSUInteger *size, NSUInteger *index);
 void WDGLRenderBezierSegment(WDBezierSegment seg);
 void WDGLRenderCGPathRef(CGPathRef pathRef);
 
@@ -12,10 +12,13 @@
 #import "WDGLUtilities.h"
 #import "WDUtilities.h"
 
+const float kGLFlattenTolerance = 0.5f;
+
 typedef struct {
     GLfloat     *vertices;
     NSUInteger  size;
     NSUInteger  index;
+    CGPoint     prevPt, moveTo;
 } glPathRenderData;
 
 void renderPathElement(void *info, const CGPathElement *element);
@@ -145,44 +148,44 @@ inline void WDGLLineFromPointToPoint(CGPoint a, CGPoint b)
 #endif
 }
 
-void WDGLFlattenBezierSegment(WDBezierSegment seg, GLfloat **vertices, NSUInteger *size, NSUInteger *index)
+void WDGLFlattenBezierSegment(WDBezierSegment seg, float tolerance, GLfloat **vertices, NSUInteger *size, NSUInteger *index)
 {
-    if (*size < *index + 4) {
-        *size *= 2;
+    NSUInteger steps = WDBezierSegmentFlatteningSteps(seg, tolerance);
+    
+    if (*size < *index + 2 * (steps + 1)) {
+        *size = MAX(*size * 2, *index + 2 * (steps + 1));
         *vertices = realloc(*vertices, sizeof(GLfloat) * *size);
     }
-        
-    if (WDBezierSegmentIsFlat(seg, kDefaultFlatness)) {
-        if (*index == 0) {
-            (*vertices)[*index] = seg.a_.x;
-            (*vertices)[*index + 1] = seg.a_.y;
-            *index += 2;
-        }
-        
-        (*vertices)[*index] = seg.b_.x;
-        (*vertices)[*index + 1] = seg.b_.y;
+    
+    if (*index == 0) {
+        (*vertices)[*index] = seg.a_.x;
+        (*vertices)[*index + 1] = seg.a_.y;
         *index += 2;
-    } else {
-        WDBezierSegment L, R;
-        WDBezierSegmentSplit(seg, &L, &R);
+    }
+    
+    for (NSUInteger i = 1; i < steps; i++) {
+        CGPoint pt = WDBezierSegmentCalculatePointAtT(seg, (float) i / steps);
         
-        WDGLFlattenBezierSegment(L, vertices, size, index);
-        WDGLFlattenBezierSegment(R, vertices, size, index);
+        (*vertices)[*index] = pt.x;
+        (*vertices)[*index + 1] = pt.y;
+        *index += 2;
     }
+    
+    (*vertices)[*index] = seg.b_.x;
+    (*vertices)[*index + 1] = seg.b_.y;
+    *index += 2;
 }
 
 void WDGLRenderBezierSegment(WDBezierSegment seg)
 {
-    static GLfloat      *vertices = NULL;
-    static NSUInteger   size = 128;
-    NSUInteger          index = 0;
-    
-    if (!vertices) {
-        vertices = calloc(sizeof(GLfloat), size);
-    }
+    NSUInteger  size = 128;
+    NSUInteger  index = 0;
+    GLfloat     *vertices = malloc(sizeof(GLfloat) * size);
     
-    WDGLFlattenBezierSegment(seg, &vertices, &size, &index);
+    WDGLFlattenBezierSegment(seg, kGLFlattenTolerance, &vertices, &size, &index);
     WDGLDrawLineStrip(vertices, index);
+    
+    free(vertices);
 }
 
 void renderPathElement(void *info, const CGPathElement *element)
@@ -190,7 +193,7 @@ void renderPathElement(void *info, const CGPathElement *element)
     glPathRenderData    *renderData = (glPathRenderData *) info;
     WDBezierSegment     segment;
     CGPoint             inPoint, outPoint;
-    static CGPoint      prevPt, moveTo;
+    CGPoint             prevPt = renderData->prevPt, moveTo = renderData->moveTo;
     
     switch (element->type) {
         case kCGPathElementMoveToPoint:
@@ -234,7 +237,7 @@ void renderPathElement(void *info, const CGPathElement *element)
             segment.in_ = inPoint;
             segment.b_ = element->points[1];
             
-            WDGLFlattenBezierSegment(segment, &(renderData->vertices), &(renderData->size), &(renderData->index));
+            WDGLFlattenBezierSegment(segment, kGLFlattenTolerance, &(renderData->vertices), &(renderData->size), &(renderData->index));
             prevPt = element->points[1];
             break;
         case kCGPathElementAddCurveToPoint:
@@ -243,7 +246,7 @@ void renderPathElement(void *info, const CGPathElement *element)
             segment.in_ = element->points[1];
             segment.b_ = element->points[2];
             
-            WDGLFlattenBezierSegment(segment, &(renderData->vertices), &(renderData->size), &(renderData->index));
+            WDGLFlattenBezierSegment(segment, kGLFlattenTolerance, &(renderData->vertices), &(renderData->size), &(renderData->index));
             prevPt = element->points[2];
             break;
         case kCGPathElementCloseSubpath:
@@ -258,20 +261,20 @@ void renderPathElement(void *info, const CGPathElement *element)
             renderData->index += 2;                          
             break;
     }
+    
+    renderData->prevPt = prevPt;
+    renderData->moveTo = moveTo;
 }
 
 void WDGLRenderCGPathRef(CGPathRef pathRef)
 {
-    static glPathRenderData renderData = { NULL, 128, 0 };
-    
-    if (renderData.vertices == NULL) {
-        renderData.vertices = calloc(sizeof(GLfloat), renderData.size);
-    }
+    glPathRenderData renderData = { NULL, 128, 0, CGPointZero, CGPointZero };
     
-    renderData.index = 0;
+    renderData.vertices = calloc(sizeof(GLfloat), renderData.size);
     CGPathApply(pathRef, &renderData, &renderPathElement);
 
     WDGLDrawLineStrip(renderData.vertices, renderData.index);
+    free(renderData.vertices);
 }
 
 inline void WDGLFillDiamond(CGPoint center, float dimension)
@@ -76,7 +76,8 @@ CGRect WDShrinkRect(CGRect rect, float percentage);
 
 CGPathRef WDCreateCubicPathFromQuadraticPath(CGPathRef pathRef);
 
-void WDPathApplyAccumulateElement(void *info, const CGPathElement *element);
+// one WDPath per subpath of pathRef, with its quadratic curves made cubic
+NSMutableArray *WDSubpathsForPath(CGPathRef pathRef);
 CGRect WDStrokeBoundsForPath(CGPathRef pathRef, WDStrokeStyle *strokeStyle);
 
 CGPathRef WDCreateTransformedCGPathRef(CGPathRef pathRef, CGAffineTransform transform);
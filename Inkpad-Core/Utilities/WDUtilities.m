@@ -398,57 +398,74 @@ CGPathRef WDCreateCubicPathFromQuadraticPath(CGPathRef pathRef)
     return converted;
 }
 
-void WDPathApplyAccumulateElement(void *info, const CGPathElement *element)
+typedef struct {
+    __unsafe_unretained NSMutableArray      *nodeData;  // the nodes of each subpath, packed (NSMutableData)
+    __unsafe_unretained NSMutableIndexSet   *closed;    // the subpaths that end with a close
+} WDAccumulatedSubpaths;
+
+static void accumulateElement(void *info, const CGPathElement *element)
 {
-    NSMutableArray  *subpaths = (__bridge NSMutableArray *)info;
-    WDPath          *path = [subpaths lastObject];
-    WDBezierNode    *prev, *node;
+    WDAccumulatedSubpaths   *accumulated = (WDAccumulatedSubpaths *)info;
+    NSMutableData           *data = [accumulated->nodeData lastObject];
+    WDBezierNodeData        *prev = data.length ? (WDBezierNodeData *) data.mutableBytes + (data.length / sizeof(WDBezierNodeData) - 1) : NULL;
+    WDBezierNodeData        node;
     
     switch (element->type) {
         case kCGPathElementMoveToPoint:
-            path = [[WDPath alloc] init];
-            
-            node = [[WDBezierNode alloc] initWithAnchorPoint:element->points[0]];
-            [path.nodes addObject:node];
+            data = [NSMutableData data];
+            [accumulated->nodeData addObject:data];
             
-            [subpaths addObject:path];
+            node = (WDBezierNodeData) {element->points[0], element->points[0], element->points[0]};
+            [data appendBytes:&node length:sizeof(node)];
             break;
         case kCGPathElementAddLineToPoint:
-            node = [[WDBezierNode alloc] initWithAnchorPoint:element->points[0]];
-            [path.nodes addObject:node];
+            node = (WDBezierNodeData) {element->points[0], element->points[0], element->points[0]};
+            [data appendBytes:&node length:sizeof(node)];
             break;
         case kCGPathElementAddQuadCurveToPoint:
-            prev = [path lastNode];
-            
             // convert quadratic to cubic: http://fontforge.sourceforge.net/bezier.html
-            CGPoint outPoint = WDAddPoints(prev.anchorPoint, WDMultiplyPointScalar(WDSubtractPoints(element->points[0], prev.anchorPoint), 2.0f / 3));
-            CGPoint inPoint = WDAddPoints(element->points[1], WDMultiplyPointScalar(WDSubtractPoints(element->points[0], element->points[1]), 2.0f / 3));
+            prev->outPoint = WDAddPoints(prev->anchorPoint, WDMultiplyPointScalar(WDSubtractPoints(element->points[0], prev->anchorPoint), 2.0f / 3));
             
-            // update and replace previous node
-            node = [[WDBezierNode alloc] initWithInPoint:prev.inPoint anchorPoint:prev.anchorPoint outPoint:outPoint];
-            [path.nodes removeLastObject];
-            [path.nodes addObject:node];
-            
-            node = [[WDBezierNode alloc] initWithInPoint:inPoint anchorPoint:element->points[1] outPoint:element->points[1]];
-            [path.nodes addObject:node];
+            node.inPoint = WDAddPoints(element->points[1], WDMultiplyPointScalar(WDSubtractPoints(element->points[0], element->points[1]), 2.0f / 3));
+            node.anchorPoint = node.outPoint = element->points[1];
+            [data appendBytes:&node length:sizeof(node)];
             break;
         case kCGPathElementAddCurveToPoint:
-            prev = [path lastNode];
-            
-            // update and replace previous node
-            node = [[WDBezierNode alloc] initWithInPoint:prev.inPoint anchorPoint:prev.anchorPoint outPoint:element->points[0]];
-            [path.nodes removeLastObject];
-            [path.nodes addObject:node];
+            prev->outPoint = element->points[0];
             
-            node = [[WDBezierNode alloc] initWithInPoint:element->points[1] anchorPoint:element->points[2] outPoint:element->points[2]];
-            [path.nodes addObject:node];
+            node = (WDBezierNodeData) {element->points[1], element->points[2], element->points[2]};
+            [data appendBytes:&node length:sizeof(node)];
             break;
         case kCGPathElementCloseSubpath:
-            [path setClosedQuiet:YES];
+            [accumulated->closed addIndex:(accumulated->nodeData.count - 1)];
             break;
     }
 }
 
+NSMutableArray *WDSubpathsForPath(CGPathRef pathRef)
+{
+    NSMutableArray          *nodeData = [NSMutableArray array];
+    NSMutableIndexSet       *closed = [NSMutableIndexSet indexSet];
+    WDAccumulatedSubpaths   accumulated = {nodeData, closed};
+    
+    // the nodes are gathered in place, and each subpath is given its nodes once
+    CGPathApply(pathRef, &accumulated, &accumulateElement);
+    
+    NSMutableArray          *subpaths = [NSMutableArray arrayWithCapacity:nodeData.count];
+    
+    [nodeData enumerateObjectsUsingBlock:^(NSData *data, NSUInteger ix, BOOL *stop) {
+        WDPath *path = [[WDPath alloc] init];
+        
+        path.nodeData = data;
+        if ([closed containsIndex:ix]) {
+            [path setClosedQuiet:YES];
+        }
+        [subpaths addObject:path];
+    }];
+    
+    return subpaths;
+}
+
 CGRect WDStrokeBoundsForPath(CGPathRef pathRef, WDStrokeStyle *strokeStyle) 
 {
     CGRect basicBounds = CGPathGetPathBoundingBox(pathRef);
@@ -465,8 +482,7 @@ CGRect WDStrokeBoundsForPath(CGPathRef pathRef, WDStrokeStyle *strokeStyle)
     
     // include miter joins on corners
     if (strokeStyle.join == kCGLineJoinMiter) {
-        NSMutableArray *subpaths = [NSMutableArray array];
-        CGPathApply(pathRef, (__bridge void *)(subpaths), &WDPathApplyAccumulateElement);
+        NSArray *subpaths = WDSubpathsForPath(pathRef);
         
         for (WDPath *subpath in subpaths) {
             NSArray         *nodes = subpath.nodes;
@@ -8,6 +8,7 @@
 
 #include "AVL.h"
 #include "LivarotDefs.h"
+#include "LivarotStats.h"
 
 AVLTree::AVLTree(void):DblLinked()
 {
@@ -132,6 +133,7 @@ AVLTree::RestoreBalances(AVLTree* from,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=b;
 				}
 				if ( racine == a ) racine=b;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 
 				a->balance=0;
 				b->balance=0;
@@ -164,6 +166,7 @@ AVLTree::RestoreBalances(AVLTree* from,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=d;
 				}
 				if ( racine == a ) racine=d;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 				
 				int old_bal=d->balance;
 				d->balance=0;
@@ -210,6 +213,7 @@ AVLTree::RestoreBalances(AVLTree* from,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=b;
 				}
 				if ( racine == a ) racine=b;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 				a->balance=0;
 				b->balance=0;
 				return avl_no_err;
@@ -240,6 +244,7 @@ AVLTree::RestoreBalances(AVLTree* from,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=d;
 				}
 				if ( racine == a ) racine=d;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 				int old_bal=d->balance;
 				d->balance=0;
 				if ( old_bal == 0 ) {
@@ -297,6 +302,7 @@ AVLTree::RestoreBalances(int diff,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=e;
 				}
 				if ( racine == this ) racine=e;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 				e->balance=0;
 				a->balance=0;
 				if ( r ) {
@@ -319,6 +325,7 @@ AVLTree::RestoreBalances(int diff,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=e;
 				}
 				if ( racine == this ) racine=e;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 				e->balance=-1;
 				a->balance=1;
 				return avl_no_err;
@@ -348,6 +355,7 @@ AVLTree::RestoreBalances(int diff,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=f;
 				}
 				if ( racine == this ) racine=f;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 				int   oBal=f->balance;
 				f->balance=0;
 				if ( oBal > 0 ) {
@@ -402,6 +410,7 @@ AVLTree::RestoreBalances(int diff,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=e;
 				}
 				if ( racine == this ) racine=e;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 				e->balance=0;
 				a->balance=0;
 				if ( r ) {
@@ -424,6 +433,7 @@ AVLTree::RestoreBalances(int diff,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=e;
 				}
 				if ( racine == this ) racine=e;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 				e->balance=1;
 				a->balance=-1;
 				return avl_no_err;
@@ -453,6 +463,7 @@ AVLTree::RestoreBalances(int diff,AVLTree* &racine)
 					if ( r->sonR == a ) r->sonR=f;
 				}
 				if ( racine == this ) racine=f;
+				LIVAROT_COUNT(stat_avl_rotations,1);
 				int   oBal=f->balance;
 				f->balance=0;
 				if ( oBal > 0 ) {
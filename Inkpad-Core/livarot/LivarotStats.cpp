@@ -0,0 +1,198 @@
+/*
+ *  LivarotStats.cpp
+ *  nlivarot
+ *
+ */
+
+#include "LivarotStats.h"
+
+#if LIVAROT_STATS
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+long long                  LivarotStats::counters[stat_nb_counter];
+long long                  LivarotStats::phaseTime[stat_nb_phase];
+int                        LivarotStats::phaseCalls[stat_nb_phase];
+bool                       LivarotStats::tracing=false;
+long long                  LivarotStats::origin=-1;
+int                        LivarotStats::nbThread=0;
+int                        LivarotStats::nbEvent=0;
+int                        LivarotStats::maxEvent=0;
+LivarotStats::stat_event*  LivarotStats::events=NULL;
+
+static pthread_key_t       threadKey;
+static pthread_once_t      threadKeyOnce=PTHREAD_ONCE_INIT;
+static pthread_mutex_t     eventLock=PTHREAD_MUTEX_INITIALIZER;
+
+static const char* phaseNames[stat_nb_phase]={
+	"Convert",
+	"Fill",
+	"SortPointsRounded",
+	"ConvertToShape",
+	"Booleen",
+	"Sweep",
+	"AssembleAretes",
+	"GetWindings",
+	"ConvertToForme",
+	"MakeOffset",
+	"Reoriente"
+};
+static const char* counterNames[stat_nb_counter]={
+	"points",
+	"events",
+	"intersections",
+	"rotations",
+	"reallocs"
+};
+
+long long         LivarotStats::Now(void)
+{
+	struct timeval  tv;
+	gettimeofday(&tv,NULL);
+	return ((long long)tv.tv_sec)*1000000+(long long)tv.tv_usec;
+}
+void              LivarotStats::MakeThreadKey(void)
+{
+	pthread_key_create(&threadKey,LivarotStats::FreeThread);
+}
+LivarotStats::stat_thread* LivarotStats::Thread(void)
+{
+	pthread_once(&threadKeyOnce,MakeThreadKey);
+	stat_thread*  th=(stat_thread*)pthread_getspecific(threadKey);
+	if ( th == NULL ) {
+		th=(stat_thread*)calloc(1,sizeof(stat_thread));
+		th->tid=__sync_add_and_fetch(&nbThread,1);
+		pthread_setspecific(threadKey,th);
+	}
+	return th;
+}
+void              LivarotStats::Flush(stat_thread* th)
+{
+	for (int i=0;i<stat_nb_counter;i++) {
+		if ( th->counters[i] != th->flushed[i] ) {
+			__sync_fetch_and_add(counters+i,th->counters[i]-th->flushed[i]);
+			th->flushed[i]=th->counters[i];
+		}
+	}
+}
+void              LivarotStats::FreeThread(void* data)
+{
+	stat_thread*  th=(stat_thread*)data;
+	Flush(th);
+	if ( th->frames ) free(th->frames);
+	free(th);
+}
+void              LivarotStats::Reset(void)
+{
+	memset(counters,0,sizeof(counters));
+	memset(phaseTime,0,sizeof(phaseTime));
+	memset(phaseCalls,0,sizeof(phaseCalls));
+	pthread_mutex_lock(&eventLock);
+	nbEvent=0;
+	origin=-1;
+	pthread_mutex_unlock(&eventLock);
+}
+void              LivarotStats::SetTracing(bool nVal)
+{
+	pthread_mutex_lock(&eventLock);
+	tracing=nVal;
+	if ( tracing == false ) {
+		if ( events ) free(events);
+		events=NULL;
+		nbEvent=maxEvent=0;
+	}
+	pthread_mutex_unlock(&eventLock);
+}
+const char*       LivarotStats::PhaseName(int phase)
+{
+	if ( phase < 0 || phase >= stat_nb_phase ) return "?";
+	return phaseNames[phase];
+}
+const char*       LivarotStats::CounterName(int counter)
+{
+	if ( counter < 0 || counter >= stat_nb_counter ) return "?";
+	return counterNames[counter];
+}
+
+void              LivarotStats::Count(int counter,int n)
+{
+	stat_thread*  th=Thread();
+	th->counters[counter]+=n;
+	if ( th->nbFrame <= 0 ) Flush(th);
+}
+void              LivarotStats::BeginPhase(int phase)
+{
+	stat_thread*  th=Thread();
+	if ( th->nbFrame >= th->maxFrame ) {
+		th->maxFrame=2*th->nbFrame+1;
+		th->frames=(stat_frame*)realloc(th->frames,th->maxFrame*sizeof(stat_frame));
+	}
+	stat_frame*  f=th->frames+(th->nbFrame++);
+	f->phase=phase;
+	memcpy(f->counters,th->counters,sizeof(th->counters));
+	f->start=Now();
+	if ( origin < 0 ) __sync_bool_compare_and_swap(&origin,-1LL,f->start);
+}
+void              LivarotStats::EndPhase(int phase)
+{
+	stat_thread*  th=Thread();
+	long long     now=Now();
+	// unwind to the matching frame, so that a missing End (early return) doesn't shift everything
+	while ( th->nbFrame > 0 ) {
+		stat_frame*  f=th->frames+(--th->nbFrame);
+		long long    duration=now-f->start;
+		__sync_fetch_and_add(phaseTime+f->phase,duration);
+		__sync_fetch_and_add(phaseCalls+f->phase,1);
+		if ( tracing ) {
+			pthread_mutex_lock(&eventLock);
+			if ( nbEvent >= maxEvent ) {
+				maxEvent=2*nbEvent+1;
+				events=(stat_event*)realloc(events,maxEvent*sizeof(stat_event));
+			}
+			stat_event*  e=events+(nbEvent++);
+			e->phase=f->phase;
+			e->depth=th->nbFrame;
+			e->tid=th->tid;
+			e->start=f->start-origin;
+			e->duration=duration;
+			for (int i=0;i<stat_nb_counter;i++) e->deltas[i]=th->counters[i]-f->counters[i];
+			pthread_mutex_unlock(&eventLock);
+		}
+		if ( f->phase == phase ) break;
+	}
+	if ( th->nbFrame <= 0 ) Flush(th);
+}
+
+void              LivarotStats::Print(FILE* f)
+{
+	for (int i=0;i<stat_nb_phase;i++) {
+		if ( phaseCalls[i] <= 0 ) continue;
+		fprintf(f,"%-20s %8i calls %12lld us\n",phaseNames[i],phaseCalls[i],phaseTime[i]);
+	}
+	for (int i=0;i<stat_nb_counter;i++) {
+		fprintf(f,"%-20s %12lld\n",counterNames[i],counters[i]);
+	}
+}
+int               LivarotStats::WriteTrace(const char* fileName)
+{
+	FILE*  f=fopen(fileName,"w");
+	if ( f == NULL ) return -1;
+	fprintf(f,"{\"traceEvents\":[\n");
+	for (int i=0;i<nbEvent;i++) {
+		stat_event*  e=events+i;
+		fprintf(f,"{\"name\":\"%s\",\"cat\":\"livarot\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%lld,\"dur\":%lld,\"args\":{",
+				phaseNames[e->phase],e->tid,e->start,e->duration);
+		for (int j=0;j<stat_nb_counter;j++) {
+			fprintf(f,"%s\"%s\":%lld",(j > 0)?",":"",counterNames[j],e->deltas[j]);
+		}
+		fprintf(f,"}}%s\n",(i < nbEvent-1)?",":"");
+	}
+	fprintf(f,"],\"displayTimeUnit\":\"ms\"}\n");
+	if ( fclose(f) != 0 ) return -1;
+	return 0;
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ *  LivarotStats.h
+ *  nlivarot
+ *
+ *  opt-in phase timings and counters for the Shape and Path operations
+ *  build with LIVAROT_STATS=1 to get them; by default every macro below expands
+ *  to nothing and the library is unchanged
+ *
+ */
+
+#ifndef my_livarot_stats
+#define my_livarot_stats
+
+#ifndef LIVAROT_STATS
+#define LIVAROT_STATS 0
+#endif
+
+#include <stdio.h>
+
+// the timed phases
+enum {
+	stat_path_convert       =0, // Convert, ConvertEvenLines, ConvertWithBackData, ConvertForOffset
+	stat_path_fill          =1,
+	stat_sort_points        =2, // SortPoints / SortPointsRounded
+	stat_convert_to_shape   =3,
+	stat_booleen            =4,
+	stat_sweep              =5, // the event loop inside ConvertToShape / Booleen
+	stat_assemble_aretes    =6,
+	stat_get_windings       =7,
+	stat_convert_to_forme   =8,
+	stat_make_offset        =9,
+	stat_reoriente          =10,
+	stat_nb_phase           =11
+};
+
+// the counters
+enum {
+	stat_sweep_points       =0, // points consumed by the sweep
+	stat_sweep_events       =1, // intersection events queued (some get dropped when the neighbours change)
+	stat_intersections      =2, // intersection events taken out of the queue by the sweep
+	stat_avl_rotations      =3,
+	stat_reallocs           =4, // growth of a point / edge / command array
+	stat_nb_counter         =5
+};
+
+#if LIVAROT_STATS
+
+/*
+ * the stats are process-wide, and livarot may run on several threads at once (the eraser runs its
+ * booleans on dispatch_apply workers): each thread counts and nests its phases on its own, and adds
+ * its counts to the totals when its outermost phase ends; times and calls go straight to the totals
+ * Reset(), SetTracing(), Print() and WriteTrace() are meant to be called while no operation runs
+ * when tracing is on, each phase is also kept as a complete event ("ph":"X") with the counters
+ * that moved during it on its thread, and WriteTrace() dumps them as Chrome trace-event JSON
+ * (chrome://tracing), one track per thread
+ */
+class LivarotStats {
+public:
+	static void       Reset(void);
+	static void       SetTracing(bool nVal);
+
+	static void       BeginPhase(int phase);
+	static void       EndPhase(int phase);
+	static void       Count(int counter,int n);
+
+	static long long  Counter(int counter) {return counters[counter];};
+	static long long  PhaseTime(int phase) {return phaseTime[phase];}; // microseconds, nested phases included
+	static int        PhaseCalls(int phase) {return phaseCalls[phase];};
+	static const char* PhaseName(int phase);
+	static const char* CounterName(int counter);
+
+	static void       Print(FILE* f);
+	static int        WriteTrace(const char* fileName); // 0 if ok, -1 if the file couldn't be written
+
+private:
+	typedef struct stat_frame {
+		int        phase;
+		long long  start;
+		long long  counters[stat_nb_counter];
+	} stat_frame;
+	typedef struct stat_event {
+		int        phase;
+		int        depth;
+		int        tid;
+		long long  start,duration;
+		long long  deltas[stat_nb_counter];
+	} stat_event;
+	typedef struct stat_thread { // what each thread keeps for itself
+		int        tid;
+		long long  counters[stat_nb_counter]; // counted on this thread since it started
+		long long  flushed[stat_nb_counter];  // the part of it already in the totals
+		int        nbFrame,maxFrame;
+		stat_frame* frames;
+	} stat_thread;
+
+	static long long  counters[stat_nb_counter];
+	static long long  phaseTime[stat_nb_phase];
+	static int        phaseCalls[stat_nb_phase];
+
+	static bool       tracing;
+	static long long  origin;
+	static int        nbThread;
+	static int        nbEvent,maxEvent;
+	static stat_event* events;
+
+	static long long  Now(void);
+	static stat_thread* Thread(void); // the calling thread's, made on first use
+	static void       Flush(stat_thread* th);
+	static void       MakeThreadKey(void);
+	static void       FreeThread(void* th);
+};
+
+// times the enclosing block
+class LivarotPhase {
+public:
+	LivarotPhase(int iPhase) {phase=iPhase;LivarotStats::BeginPhase(phase);};
+	~LivarotPhase(void) {LivarotStats::EndPhase(phase);};
+private:
+	int   phase;
+};
+
+#define LIVAROT_SCOPE(p)       LivarotPhase livarot_scope_phase(p)
+#define LIVAROT_BEGIN(p)       LivarotStats::BeginPhase(p)
+#define LIVAROT_END(p)         LivarotStats::EndPhase(p)
+#define LIVAROT_COUNT(c,n)     LivarotStats::Count(c,n)
+
+#else
+
+#define LIVAROT_SCOPE(p)
+#define LIVAROT_BEGIN(p)
+#define LIVAROT_END(p)
+#define LIVAROT_COUNT(c,n)
+
+#endif
+
+#endif
@@ -9,6 +9,7 @@
 #include "Path.h"
 #include "Shape.h"
 #include "MyMath.h"
+#include "LivarotStats.h"
 #include <math.h>
 
 
@@ -17,6 +18,7 @@ Path::Path(void)
 	descr_flags=0;
 	descr_max=descr_nb=0;
 	descr_data=NULL;
+	descr_refs=NULL;
 	pending_bezier=-1;
 	pending_moveto=-1;
 
@@ -27,10 +29,7 @@ Path::Path(void)
 }
 Path::~Path(void)
 {
-	if ( descr_data ) {
-		free(descr_data);
-		descr_data=NULL;
-	}
+	ReleaseDescr();
 	if ( pts ) {
 		free(pts);
 		pts=NULL;
@@ -73,6 +72,7 @@ void					  Path::Affiche(void)
 }
 void            Path::Reset(void)
 {
+	if ( descr_refs ) MakeDescrUnique(false);
 	descr_nb=0;
 	pending_bezier=-1;
 	pending_moveto=-1;
@@ -81,24 +81,67 @@ void            Path::Reset(void)
 void            Path::Copy(Path* who)
 {
 	ResetPoints(0);
-	if ( who->descr_nb > descr_max ) {
-		descr_max=who->descr_nb;
-		descr_data=(path_descr*)realloc(descr_data,descr_max*sizeof(path_descr));
+	if ( who != this ) {
+		// share the description, like Shape::Copy() shares the points and edges
+		int*  refs=__atomic_load_n(&who->descr_refs,__ATOMIC_ACQUIRE);
+		if ( refs == NULL ) {
+			int*  nRefs=(int*)malloc(sizeof(int));
+			*nRefs=1;
+			refs=__sync_val_compare_and_swap(&who->descr_refs,(int*)NULL,nRefs);
+			if ( refs == NULL ) refs=nRefs; else free(nRefs);
+		}
+		__sync_fetch_and_add(refs,1);
+		ReleaseDescr();
+		descr_refs=refs;
+		descr_data=who->descr_data;
+		descr_max=who->descr_max;
 	}
 	SetWeighted(who->weighted);
 	descr_nb=who->descr_nb;
-	memcpy(descr_data,who->descr_data,descr_nb*sizeof(path_descr));
+}
+void            Path::MakeDescrUnique(bool keep)
+{
+	if ( descr_refs == NULL ) return;
+	if ( __sync_fetch_and_add(descr_refs,0) == 1 ) {
+		free(descr_refs);
+		descr_refs=NULL;
+		return;
+	}
+	path_descr*  nData=(path_descr*)malloc(descr_max*sizeof(path_descr));
+	if ( keep ) {
+		LIVAROT_COUNT(stat_reallocs,1);
+		memcpy(nData,descr_data,descr_nb*sizeof(path_descr));
+	}
+	if ( __sync_sub_and_fetch(descr_refs,1) == 0 ) {
+		free(descr_data);
+		free(descr_refs);
+	}
+	descr_refs=NULL;
+	descr_data=nData;
+}
+void            Path::ReleaseDescr(void)
+{
+	if ( descr_refs == NULL || __sync_sub_and_fetch(descr_refs,1) == 0 ) {
+		if ( descr_data ) free(descr_data);
+		if ( descr_refs ) free(descr_refs);
+	}
+	descr_refs=NULL;
+	descr_data=NULL;
+	descr_max=descr_nb=0;
 }
 
 void            Path::Alloue(int addSize)
 {
+	UnshareDescr();
 	if ( descr_nb+addSize > descr_max ) {
 		descr_max=2*descr_nb+addSize;
+		LIVAROT_COUNT(stat_reallocs,1);
 		descr_data=(path_descr*)realloc(descr_data,descr_max*sizeof(path_descr));
 	}
 }
 void            Path::CloseSubpath(int add)
 {
+	UnshareDescr();
 	for (int i=descr_nb-1;i>=0;i--) {
 		int ty=(descr_data+i)->flags&descr_type_mask;
 		if ( ty == descr_moveto ) {
@@ -389,6 +432,7 @@ int             Path::EndBezierTo(float ix,float iy)
 	} else {
 		return EndBezierTo();
 	}
+	UnshareDescr();
 	(descr_data+pending_bezier)->d.b.x=ix;
 	(descr_data+pending_bezier)->d.b.y=iy;
 	if ( (descr_data+pending_bezier)->flags&descr_weighted ) (descr_data+pending_bezier)->d.b.w=1;
@@ -411,6 +455,7 @@ int            Path::EndBezierTo(float ix,float iy,float iw)
 	} else {
 		return EndBezierTo();
 	}
+	UnshareDescr();
 	(descr_data+pending_bezier)->d.b.x=ix;
 	(descr_data+pending_bezier)->d.b.y=iy;
 	(descr_data+pending_bezier)->d.b.w=iw;
@@ -584,6 +629,7 @@ void            Path::ResetPoints(int expected)
 	}
 	if ( sizePt > maxPt ) {
 		maxPt=sizePt;
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(char*)realloc(pts,maxPt);
 	}
 }
@@ -599,6 +645,7 @@ int             Path::AddPoint(float ix,float iy,bool mvto)
 	int  nextSize=sizePt+sizeof(path_lineto);
 	if ( nextSize > maxPt ) {
 		maxPt=2*sizePt+sizeof(path_lineto);
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(char*)realloc(pts,maxPt);
 	}
 	if ( mvto == false && nbPt > 0 && ((path_lineto*)pts)[nbPt-1].x == ix && ((path_lineto*)pts)[nbPt-1].y == iy ) return -1;
@@ -622,6 +669,7 @@ int             Path::AddPoint(float ix,float iy,float iw,bool mvto)
 	int  nextSize=sizePt+sizeof(path_lineto_w);
 	if ( nextSize > maxPt ) {
 		maxPt=2*sizePt+sizeof(path_lineto_w);
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(char*)realloc(pts,maxPt);
 	}
 	if ( mvto == false && nbPt > 0 && ((path_lineto_w*)pts)[nbPt-1].x == ix && ((path_lineto_w*)pts)[nbPt-1].y == iy ) return -1;
@@ -645,6 +693,7 @@ int             Path::AddPoint(float ix,float iy,int ip,float it,bool mvto)
 	int  nextSize=sizePt+sizeof(path_lineto_b);
 	if ( nextSize > maxPt ) {
 		maxPt=2*sizePt+sizeof(path_lineto_b);
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(char*)realloc(pts,maxPt);
 	}
 	if ( mvto == false && nbPt > 0 && ((path_lineto_b*)pts)[nbPt-1].x == ix && ((path_lineto_b*)pts)[nbPt-1].y == iy ) return -1;
@@ -670,6 +719,7 @@ int             Path::AddPoint(float ix,float iy,float iw,int ip,float it,bool m
 	int  nextSize=sizePt+sizeof(path_lineto_wb);
 	if ( nextSize > maxPt ) {
 		maxPt=2*sizePt+sizeof(path_lineto_wb);
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(char*)realloc(pts,maxPt);
 	}
 	if ( mvto == false && nbPt > 0 && ((path_lineto_wb*)pts)[nbPt-1].x == ix && ((path_lineto_wb*)pts)[nbPt-1].y == iy ) return -1;
@@ -695,6 +745,7 @@ int             Path::AddForcedPoint(float ix,float iy)
 	int  nextSize=sizePt+sizeof(path_lineto);
 	if ( nextSize > maxPt ) {
 		maxPt=2*sizePt+sizeof(path_lineto);
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(char*)realloc(pts,maxPt);
 	}
 	if ( nbPt <= 0 || ((path_lineto*)pts)[nbPt-1].isMoveTo != polyline_lineto ) return-1 ;
@@ -718,6 +769,7 @@ int             Path::AddForcedPoint(float ix,float iy,float iw)
 	int  nextSize=sizePt+sizeof(path_lineto_w);
 	if ( nextSize > maxPt ) {
 		maxPt=2*sizePt+sizeof(path_lineto_w);
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(char*)realloc(pts,maxPt);
 	}
 	if ( nbPt <= 0 || ((path_lineto_w*)pts)[nbPt-1].isMoveTo != polyline_lineto ) return -1;
@@ -741,6 +793,7 @@ int             Path::AddForcedPoint(float ix,float iy,int ip,float it)
 	int  nextSize=sizePt+sizeof(path_lineto_b);
 	if ( nextSize > maxPt ) {
 		maxPt=2*sizePt+sizeof(path_lineto_b);
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(char*)realloc(pts,maxPt);
 	}
 	if ( nbPt <= 0 || ((path_lineto_b*)pts)[nbPt-1].isMoveTo != polyline_lineto ) return -1;
@@ -766,6 +819,7 @@ int             Path::AddForcedPoint(float ix,float iy,float iw,int ip,float it)
 	int  nextSize=sizePt+sizeof(path_lineto_wb);
 	if ( nextSize > maxPt ) {
 		maxPt=2*sizePt+sizeof(path_lineto_wb);
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(char*)realloc(pts,maxPt);
 	}
 	if ( nbPt <= 0 || ((path_lineto*)pts)[nbPt-1].isMoveTo != polyline_lineto ) return -1;
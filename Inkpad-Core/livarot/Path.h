@@ -169,7 +169,7 @@ public:
 
 	// creation of the path description
 	void            Reset(void); // reset to the empty description
-	void            Copy(Path* who);
+	void            Copy(Path* who); // shares who's description until one of the 2 paths changes it
 	
 	// dumps the path description on the standard output
 	void					  Affiche(void);
@@ -250,6 +250,13 @@ public:
 
 	void						PrevPoint(int i,float &x,float &y);
 private:
+	// non-NULL when descr_data is shared with other paths by Copy(): the number of paths sharing it
+	// anything that writes in descr_data calls UnshareDescr() first
+	int*            descr_refs;
+	void            UnshareDescr(void) {if ( descr_refs ) MakeDescrUnique(true);};
+	void            MakeDescrUnique(bool keep);
+	void            ReleaseDescr(void);
+
 	void            Alloue(int addSize);
 	void            CancelBezier(void);
 	void            CloseSubpath(int add);
@@ -9,9 +9,11 @@
 #include "Path.h"
 #include "Shape.h"
 #include "MyMath.h"
+#include "LivarotStats.h"
 
 void            Path::ConvertWithBackData(float treshhold)
 {
+	LIVAROT_SCOPE(stat_path_convert);
 	if ( descr_flags&descr_adding_bezier ) CancelBezier();
 	if ( descr_flags&descr_doing_subpath ) CloseSubpath(0);
 	
@@ -206,6 +208,7 @@ void            Path::ConvertWithBackData(float treshhold)
 }
 void            Path::ConvertForOffset(float treshhold,Path* orig,float off_dec)
 {
+	LIVAROT_SCOPE(stat_path_convert);
 	if ( descr_flags&descr_adding_bezier ) CancelBezier();
 	if ( descr_flags&descr_doing_subpath ) CloseSubpath(0);
 	
@@ -409,12 +412,14 @@ void            Path::ConvertForOffset(float treshhold,Path* orig,float off_dec)
 }
 void            Path::Convert(float treshhold)
 {
+	LIVAROT_SCOPE(stat_path_convert);
 	if ( descr_flags&descr_adding_bezier ) CancelBezier();
 	if ( descr_flags&descr_doing_subpath ) CloseSubpath(0);
 	
 	SetBackData(false);
 	ResetPoints(descr_nb);
 	if ( descr_nb <= 0 ) return;
+	UnshareDescr(); // the descriptions get their associated point
 	float    curX,curY,curW;
 	int      curP=1;
 	int      lastMoveTo=0;
@@ -673,12 +678,14 @@ void            Path::Convert(float treshhold)
 }
 void            Path::ConvertEvenLines(float treshhold)
 {
+	LIVAROT_SCOPE(stat_path_convert);
 	if ( descr_flags&descr_adding_bezier ) CancelBezier();
 	if ( descr_flags&descr_doing_subpath ) CloseSubpath(0);
 	
 	SetBackData(false);
 	ResetPoints(descr_nb);
 	if ( descr_nb <= 0 ) return;
+	UnshareDescr(); // the descriptions get their associated point
 	float    curX,curY,curW;
 	int      curP=1;
 	int      lastMoveTo=0;
@@ -1907,6 +1914,7 @@ void            Path::RecBezierTo(float px,float py,float sx,float sy,float ex,f
 
 void            Path::Fill(Shape* dest,int pathID,bool justAdd,bool closeIfNeeded,bool invert)
 {
+	LIVAROT_SCOPE(stat_path_fill);
 	if ( dest == NULL ) return;
 	if ( justAdd == false ) {
 		dest->Reset(nbPt,nbPt);
@@ -1938,11 +1946,13 @@ void            Path::Fill(Shape* dest,int pathID,bool justAdd,bool closeIfNeede
 								dest->DisconnectEnd(lEdge);
 								dest->ConnectEnd(first+lastM,lEdge);
 							} else {
-								dest->AddEdge(first+pathEnd,first+lastM);
-								dest->ebData[lEdge].pathID=pathID;
-								dest->ebData[lEdge].pieceID=lm->piece;
-								dest->ebData[lEdge].tSt=0.0;
-								dest->ebData[lEdge].tEn=1.0;
+								lEdge=dest->AddEdge(first+pathEnd,first+lastM);
+								if ( lEdge >= 0 ) {
+									dest->ebData[lEdge].pathID=pathID;
+									dest->ebData[lEdge].pieceID=lm->piece;
+									dest->ebData[lEdge].tSt=0.0;
+									dest->ebData[lEdge].tEn=1.0;
+								}
 							}
 						}
 						lastM=curP;
@@ -1979,10 +1989,12 @@ void            Path::Fill(Shape* dest,int pathID,bool justAdd,bool closeIfNeede
 					} else {
 						path_lineto_wb*    lm=((path_lineto_wb*)pts)+lastM;
 						lEdge=dest->AddEdge(first+pathEnd,first+lastM);
-						dest->ebData[lEdge].pathID=pathID;
-						dest->ebData[lEdge].pieceID=lm->piece;
-						dest->ebData[lEdge].tSt=0.0;
-						dest->ebData[lEdge].tEn=1.0;
+						if ( lEdge >= 0 ) {
+							dest->ebData[lEdge].pathID=pathID;
+							dest->ebData[lEdge].pieceID=lm->piece;
+							dest->ebData[lEdge].tSt=0.0;
+							dest->ebData[lEdge].tEn=1.0;
+						}
 					}
 				}
 			} else {
@@ -2003,11 +2015,13 @@ void            Path::Fill(Shape* dest,int pathID,bool justAdd,bool closeIfNeede
 								dest->DisconnectEnd(lEdge);
 								dest->ConnectEnd(first+lastM,lEdge);
 							} else {
-								dest->AddEdge(first+pathEnd,first+lastM);
-								dest->ebData[lEdge].pathID=pathID;
-								dest->ebData[lEdge].pieceID=lm->piece;
-								dest->ebData[lEdge].tSt=0.0;
-								dest->ebData[lEdge].tEn=1.0;
+								lEdge=dest->AddEdge(first+pathEnd,first+lastM);
+								if ( lEdge >= 0 ) {
+									dest->ebData[lEdge].pathID=pathID;
+									dest->ebData[lEdge].pieceID=lm->piece;
+									dest->ebData[lEdge].tSt=0.0;
+									dest->ebData[lEdge].tEn=1.0;
+								}
 							}
 						}
 						lastM=curP;
@@ -2044,10 +2058,12 @@ void            Path::Fill(Shape* dest,int pathID,bool justAdd,bool closeIfNeede
 					} else {
 						path_lineto_b*    lm=((path_lineto_b*)pts)+lastM;
 						lEdge=dest->AddEdge(first+pathEnd,first+lastM);
-						dest->ebData[lEdge].pathID=pathID;
-						dest->ebData[lEdge].pieceID=lm->piece;
-						dest->ebData[lEdge].tSt=0.0;
-						dest->ebData[lEdge].tEn=1.0;
+						if ( lEdge >= 0 ) {
+							dest->ebData[lEdge].pathID=pathID;
+							dest->ebData[lEdge].pieceID=lm->piece;
+							dest->ebData[lEdge].tSt=0.0;
+							dest->ebData[lEdge].tEn=1.0;
+						}
 					}
 				}
 			}
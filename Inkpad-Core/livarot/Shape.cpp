@@ -8,6 +8,7 @@
 
 #include "Shape.h"
 #include "MyMath.h"
+#include "LivarotStats.h"
 
 Shape::Shape(void)
 {
@@ -16,6 +17,7 @@ Shape::Shape(void)
 	pts=NULL;
 	nbAr=maxAr=0;
 	aretes=NULL;
+	geomRefs=NULL;
 
 	flags=0;
 	type=shape_polygon;
@@ -32,16 +34,7 @@ Shape::Shape(void)
 }
 Shape::~Shape(void)
 {
-	if ( maxPt > 0 ) {
-		free(pts);
-	}
-	nbPt=maxPt=0;
-	pts=NULL;
-	if ( maxAr > 0 ) {
-		free(aretes);
-	}
-	nbAr=maxAr=0;
-	aretes=NULL;
+	ReleaseGeom();
 	if ( eData ) free(eData);
 	if ( ebData ) free(ebData);
 	if ( swsData ) free(swsData);
@@ -223,7 +216,7 @@ void              Shape::MakeVoronoiData(bool nVal)
 /*
  *
  */
-void            Shape::Copy(Shape* who)
+void            Shape::Copy(Shape* who,bool withBackData)
 {
 	if ( who == NULL ) {
 		Reset(0,0);
@@ -242,28 +235,93 @@ SweepEvent::DestroyQueue(sEvts);
 		SetFlag(has_sweep_data,false);
 	}
 	
-	Reset(who->nbPt,who->nbAr);
+	if ( who != this ) {
+		// share who's points and edges instead of copying them; the first change on either side
+		// gives that side its own arrays (see UnshareGeom())
+		// Copy() can be called on the same source from several threads at once
+		int*  refs=__atomic_load_n(&who->geomRefs,__ATOMIC_ACQUIRE);
+		if ( refs == NULL ) {
+			int*  nRefs=(int*)malloc(sizeof(int));
+			*nRefs=1;
+			refs=__sync_val_compare_and_swap(&who->geomRefs,(int*)NULL,nRefs);
+			if ( refs == NULL ) refs=nRefs; else free(nRefs);
+		}
+		__sync_fetch_and_add(refs,1);
+		ReleaseGeom();
+		geomRefs=refs;
+		pts=who->pts;
+		aretes=who->aretes;
+		maxPt=who->maxPt;
+		maxAr=who->maxAr;
+		if ( HasVoronoiData() ) {
+			vorpData=(voronoi_point*)realloc(vorpData,maxPt*sizeof(voronoi_point));
+			voreData=(voronoi_edge*)realloc(voreData,maxAr*sizeof(voronoi_edge));
+		}
+	}
 	nbPt=who->nbPt;
 	nbAr=who->nbAr;
 	type=who->type;
-	flags=who->flags&(need_points_sorting+need_edges_sorting);
+	flags=who->flags&(need_points_sorting+need_edges_sorting+known_simple);
 	
-	memcpy(pts,who->pts,nbPt*sizeof(dg_point));
-	memcpy(aretes,who->aretes,nbAr*sizeof(dg_arete));
+	if ( withBackData && who->HasBackData() ) {
+		MakeBackData(true);
+		memcpy(ebData,who->ebData,nbAr*sizeof(back_data));
+	}
+}
+void              Shape::MakeGeomUnique(bool keep)
+{
+	if ( geomRefs == NULL ) return;
+	if ( __sync_fetch_and_add(geomRefs,0) == 1 ) {
+		// the other owners are gone, the arrays are ours already
+		free(geomRefs);
+		geomRefs=NULL;
+		return;
+	}
+	dg_point*  nPts=(dg_point*)malloc(maxPt*sizeof(dg_point));
+	dg_arete*  nAretes=(dg_arete*)malloc(maxAr*sizeof(dg_arete));
+	if ( keep ) {
+		LIVAROT_COUNT(stat_reallocs,1);
+		memcpy(nPts,pts,nbPt*sizeof(dg_point));
+		memcpy(nAretes,aretes,nbAr*sizeof(dg_arete));
+	}
+	if ( __sync_sub_and_fetch(geomRefs,1) == 0 ) {
+		free(pts);
+		free(aretes);
+		free(geomRefs);
+	}
+	geomRefs=NULL;
+	pts=nPts;
+	aretes=nAretes;
+}
+void              Shape::ReleaseGeom(void)
+{
+	if ( geomRefs == NULL || __sync_sub_and_fetch(geomRefs,1) == 0 ) {
+		if ( pts ) free(pts);
+		if ( aretes ) free(aretes);
+		if ( geomRefs ) free(geomRefs);
+	}
+	geomRefs=NULL;
+	nbPt=maxPt=0;
+	pts=NULL;
+	nbAr=maxAr=0;
+	aretes=NULL;
 }
 void              Shape::Reset(int n,int m)
 {
+	if ( geomRefs ) MakeGeomUnique(false);
 	nbPt=0;
 	nbAr=0;
 	type=shape_polygon;
 	if ( n > maxPt ) {
 		maxPt=n;
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(dg_point*)realloc(pts,maxPt*sizeof(dg_point));
 		if ( HasPointsData() ) pData=(point_data*)realloc(pData,maxPt*sizeof(point_data));
 		if ( HasVoronoiData() ) vorpData=(voronoi_point*)realloc(vorpData,maxPt*sizeof(voronoi_point));
 	}
-	if ( n > maxAr ) {
-		maxAr=n;
+	if ( m > maxAr ) {
+		maxAr=m;
+		LIVAROT_COUNT(stat_reallocs,1);
 		aretes=(dg_arete*)realloc(aretes,maxAr*sizeof(dg_arete));
 		if ( HasEdgesData() ) eData=(edge_data*)realloc(eData,maxAr*sizeof(edge_data));
 		if ( HasSweepDestData() ) swdData=(sweep_dest_data*)realloc(swdData,maxAr*sizeof(sweep_dest_data));
@@ -273,11 +331,14 @@ void              Shape::Reset(int n,int m)
 	}
 	SetFlag(need_points_sorting,false);
 	SetFlag(need_edges_sorting,false);
+	SetFlag(known_simple,false);
 }
 int               Shape::AddPoint(float x,float y)
 {
+	UnshareGeom();
 	if ( nbPt >= maxPt ) {
 		maxPt=2*nbPt+1;
+		LIVAROT_COUNT(stat_reallocs,1);
 		pts=(dg_point*)realloc(pts,maxPt*sizeof(dg_point));
 		if ( HasPointsData() ) pData=(point_data*)realloc(pData,maxPt*sizeof(point_data));
 		if ( HasVoronoiData() ) vorpData=(voronoi_point*)realloc(vorpData,maxPt*sizeof(voronoi_point));
@@ -304,6 +365,7 @@ int               Shape::AddPoint(float x,float y)
 void              Shape::SubPoint(int p)
 {
 	if ( p < 0 || p >= nbPt ) return;
+	UnshareGeom();
 	SetFlag(need_points_sorting,true);
 	int   cb;
 	cb=pts[p].firstA;
@@ -329,6 +391,7 @@ void              Shape::SubPoint(int p)
 void              Shape::SwapPoints(int a,int b)
 {
 	if ( a == b ) return;
+	UnshareGeom();
 	if ( pts[a].dI+pts[a].dO == 2 && pts[b].dI+pts[b].dO == 2 ) {
 		int cb=pts[a].firstA;
 		if ( aretes[cb].st == a ) {
@@ -420,11 +483,13 @@ void              Shape::SwapPoints(int a,int b,int c)
 }
 void              Shape::SortPoints(void)
 {
+	LIVAROT_SCOPE(stat_sort_points);
 	if ( GetFlag(need_points_sorting) && nbPt > 0 ) SortPoints(0,nbPt-1);
 	SetFlag(need_points_sorting,false);
 }
 void              Shape::SortPointsRounded(void)
 {
+	LIVAROT_SCOPE(stat_sort_points);
 	if ( nbPt > 0 ) SortPointsRounded(0,nbPt-1);
 }
 void              Shape::SortPoints(int s,int e)
@@ -807,9 +872,11 @@ int               Shape::AddEdge(int st,int en)
 {
 	if ( st == en ) return -1;
 	if ( st < 0 || en < 0 ) return -1;
+	UnshareGeom();
 	type=shape_graph;
 	if ( nbAr >= maxAr ) {
 		maxAr=2*nbAr+1;
+		LIVAROT_COUNT(stat_reallocs,1);
 		aretes=(dg_arete*)realloc(aretes,maxAr*sizeof(dg_arete));
 		if ( HasEdgesData() ) eData=(edge_data*)realloc(eData,maxAr*sizeof(edge_data));
 		if ( HasSweepSrcData() ) swsData=(sweep_src_data*)realloc(swsData,maxAr*sizeof(sweep_src_data));
@@ -866,8 +933,10 @@ int               Shape::AddEdge(int st,int en,int leF,int riF)
 		}
 	}
 	type=shape_graph;
+	UnshareGeom();
 	if ( nbAr >= maxAr ) {
 		maxAr=2*nbAr+1;
+		LIVAROT_COUNT(stat_reallocs,1);
 		aretes=(dg_arete*)realloc(aretes,maxAr*sizeof(dg_arete));
 		if ( HasEdgesData() ) eData=(edge_data*)realloc(eData,maxAr*sizeof(edge_data));
 		if ( HasSweepSrcData() ) swsData=(sweep_src_data*)realloc(swsData,maxAr*sizeof(sweep_src_data));
@@ -924,6 +993,7 @@ void              Shape::SubEdge(int e)
 void              Shape::SwapEdges(int a,int b)
 {
 	if ( a == b ) return;
+	UnshareGeom();
 	if ( aretes[a].prevS >= 0 && aretes[a].prevS != b ) {
 		if ( aretes[aretes[a].prevS].st == aretes[a].st ) {
 			aretes[aretes[a].prevS].nextS=b;
@@ -1039,7 +1109,8 @@ void              Shape::SortEdges(void)
 	}
 	SetFlag(need_edges_sorting,false);
 
-	edge_list*  list=(edge_list*)malloc(nbAr*sizeof(edge_list));
+	edge_list*  list=(edge_list*)malloc(2*nbAr*sizeof(edge_list));
+	UnshareGeom();
 	for (int p=0;p<nbPt;p++) {
 		int d=pts[p].dI+pts[p].dO;
 		if ( d > 1 ) {
@@ -1060,7 +1131,7 @@ void              Shape::SortEdges(void)
 				}
 				cb=NextAt(p,cb);
 			}
-			SortEdgesList(list,0,nb-1);
+			SortEdgesList(list,list+nbAr,nb);
 			pts[p].firstA=list[0].no;
 			pts[p].lastA=list[nb-1].no;
 			for (int i=0;i<nb;i++) {
@@ -1171,101 +1242,76 @@ int             Shape::CmpToVert(float ax,float ay,float bx,float by)
 	return tstSi;
 }
 
-void              Shape::SortEdgesList(edge_list* list,int s,int e)
+double            Shape::EdgeKey(float x,float y)
 {
-	if ( s >= e ) return;
-	if ( e == s+1 ) {
-		if ( CmpToVert(list[e].x,list[e].y,list[s].x,list[s].y) > 0 ) {
-			edge_list swap=list[s];list[s]=list[e];list[e]=swap;
+	// grows with the angle of (x,y) in the order of CmpToVert(): 1 for (0,-1), 2 for (1,0), 3 for (0,1),
+	// 4 for (-1,0), and below 5 for the rest of the turn; the null vector gets 0, like CmpToVert() puts it
+	// first
+	// the rounding of the division can make 2 close directions tie, but never swaps them, so the ties
+	// are left to CmpToVert()
+	double  dx=x,dy=y;
+	if ( dy < 0 && dx >= 0 ) return 1+dx/(dx-dy);
+	if ( dx > 0 && dy >= 0 ) return 2+dy/(dx+dy);
+	if ( dy > 0 && dx <= 0 ) return 3-dx/(dy-dx);
+	if ( dx < 0 && dy <= 0 ) return 4-dy/(-dx-dy);
+	return 0;
+}
+
+void              Shape::SortEdgesList(edge_list* list,edge_list* temp,int nb)
+{
+	if ( nb <= 1 ) return;
+	if ( nb == 2 ) {
+		// most points: a single comparison, no key
+		if ( CmpToVert(list[1].x,list[1].y,list[0].x,list[0].y) > 0 ) {
+			edge_list swap=list[0];list[0]=list[1];list[1]=swap;
 		}
 		return;
 	}
+	for (int i=0;i<nb;i++) list[i].key=EdgeKey(list[i].x,list[i].y);
 
-	int      ppos=(s+e)/2;
-	int      plast=ppos;
-	float   pvalx=list[ppos].x,pvaly=list[ppos].y;
-
-	int le=s,ri=e;
-	while ( le < ppos || ri > plast ) {
-		if ( le < ppos ) {
-			do {
-				int test=CmpToVert(pvalx,pvaly,list[le].x,list[le].y);
-				if ( test == 0 ) {
-					// on colle les valeurs egales au pivot ensemble
-					if ( le < ppos-1 ) {
-						edge_list swap=list[le];list[le]=list[ppos-1];list[ppos-1]=list[ppos];list[ppos]=swap;
-						ppos--;
-						continue; // sans changer le
-					} else if ( le == ppos-1 ) {
-						ppos--;
-						break;
-					} else {
-						// oupsie
-						break;
-					}
-				}
-				if ( test > 0 ) {
-					break;
-				}
-				le++;
-			} while ( le < ppos );
-		}
-		if ( ri > plast ) {
-			do {
-				int test=CmpToVert(pvalx,pvaly,list[ri].x,list[ri].y);
-				if ( test == 0 ) {
-					// on colle les valeurs egales au pivot ensemble
-					if ( ri > plast+1 ) {
-						edge_list swap=list[ri];list[ri]=list[plast+1];list[plast+1]=list[plast];list[plast]=swap;
-						plast++;
-						continue; // sans changer ri
-					} else if ( ri == plast+1 ) {
-						plast++;
-						break;
-					} else {
-						// oupsie
-						break;
-					}
-				}
-				if ( test < 0 ) {
-					break;
-				}
-				ri--;
-			} while ( ri > plast );
-		}
-		
-		if ( le < ppos ) {
-			if ( ri > plast ) {
-				edge_list swap=list[le];list[le]=list[ri];list[ri]=swap;
-				le++;ri--;
-			} else if ( le < ppos-1 ) {
-				edge_list swap=list[ppos-1];list[ppos-1]=list[plast];list[plast]=list[le];list[le]=swap;
-				ppos--;
-				plast--;
-			} else if ( le == ppos-1 ) {
-				edge_list swap=list[plast];list[plast]=list[le];list[le]=swap;
-				ppos--;
-				plast--;
-			} else {
-				break;
+	if ( nb > edge_sort_small ) {
+		// radix sort on the bits of the key rounded to a float (positive, so the bits sort like the
+		// values), one byte at a time; the insertion sort below then only has the ties left to fix
+		int      count[256];
+		edge_list* src=list;
+		edge_list* dst=temp;
+		for (int shift=0;shift<32;shift+=8) {
+			memset(count,0,256*sizeof(int));
+			for (int i=0;i<nb;i++) {
+				float         fk=src[i].key;
+				uint32_t      bits;
+				memcpy(&bits,&fk,sizeof(uint32_t));
+				count[(bits>>shift)&255]++;
 			}
-		} else {
-			if ( ri > plast+1 ) {
-				edge_list swap=list[plast+1];list[plast+1]=list[ppos];list[ppos]=list[ri];list[ri]=swap;
-				ppos++;
-				plast++;
-			} else if ( ri == plast+1 ) {
-				edge_list swap=list[ppos];list[ppos]=list[ri];list[ri]=swap;
-				ppos++;
-				plast++;
-			} else {
-				break;
+			bool     single=false;
+			for (int j=0;j<256;j++) if ( count[j] == nb ) single=true;
+			if ( single ) continue; // the same byte for all the edges
+			for (int j=0,pos=0;j<256;j++) {
+				int  c=count[j];
+				count[j]=pos;
+				pos+=c;
 			}
+			for (int i=0;i<nb;i++) {
+				float         fk=src[i].key;
+				uint32_t      bits;
+				memcpy(&bits,&fk,sizeof(uint32_t));
+				dst[count[(bits>>shift)&255]++]=src[i];
+			}
+			edge_list* swap=src;src=dst;dst=swap;
 		}
+		if ( src != list ) memcpy(list,src,nb*sizeof(edge_list));
+	}
+
+	for (int i=1;i<nb;i++) {
+		edge_list  cur=list[i];
+		int        j=i-1;
+		while ( j >= 0 && ( cur.key < list[j].key
+											|| ( cur.key == list[j].key && CmpToVert(cur.x,cur.y,list[j].x,list[j].y) > 0 ) ) ) {
+			list[j+1]=list[j];
+			j--;
+		}
+		list[j+1]=cur;
 	}
-	SortEdgesList(list,s,ppos-1);
-	SortEdgesList(list,plast+1,e);
-	
 }
 
 
@@ -1275,6 +1321,7 @@ void              Shape::SortEdgesList(edge_list* list,int s,int e)
  */
 void              Shape::ConnectStart(int p,int b)
 {
+	UnshareGeom();
 	if ( aretes[b].st >= 0 ) DisconnectStart(b);
 	aretes[b].st=p;
 	pts[p].dO++;
@@ -1292,6 +1339,7 @@ void              Shape::ConnectStart(int p,int b)
 }
 void              Shape::ConnectEnd(int p,int b)
 {
+	UnshareGeom();
 	if ( aretes[b].en >= 0 ) DisconnectEnd(b);
 	aretes[b].en=p;
 	pts[p].dI++;
@@ -1309,6 +1357,7 @@ void              Shape::ConnectEnd(int p,int b)
 }
 void              Shape::DisconnectStart(int b)
 {
+	UnshareGeom();
 	if ( aretes[b].st < 0 ) return;
 	pts[aretes[b].st].dO--;
 	if ( aretes[b].prevS >= 0 ) {
@@ -1331,6 +1380,7 @@ void              Shape::DisconnectStart(int b)
 }
 void              Shape::DisconnectEnd(int b)
 {
+	UnshareGeom();
 	if ( aretes[b].en < 0 ) return;
 	pts[aretes[b].en].dI--;
 	if ( aretes[b].prevE >= 0 ) {
@@ -1372,6 +1422,7 @@ bool              Shape::Eulerian(bool directed)
 }
 void              Shape::Inverse(int b)
 {
+	UnshareGeom();
 	int swap;
 	swap=aretes[b].st;aretes[b].st=aretes[b].en;aretes[b].en=swap;
 	swap=aretes[b].prevE;aretes[b].prevE=aretes[b].prevS;aretes[b].prevS=swap;
@@ -41,7 +41,9 @@ enum {
 	has_raster_data       = 128, // the swrData array is allocated
 	has_quick_raster_data = 256, // the swrData array is allocated
 	has_back_data					= 512, // the ebData array is allocated
-	has_voronoi_data			= 1024
+	has_voronoi_data			= 1024,
+	known_simple          = 2048 // provenance: whoever built the graph knows it's intersection-free (rectangles,
+	                             // ovals, contours of a polygon...); cleared by Reset()
 };
 
 class FloatLigne;
@@ -82,6 +84,16 @@ public:
 	int               flags;
 
 private:
+	// non-NULL when pts and aretes are shared with other shapes by Copy(): the number of shapes
+	// sharing them. the sharing is undone by the first change to the points or edges, so
+	// everything that writes in pts or aretes must call UnshareGeom() first (the functions below
+	// do; the sweeps and the offset write in shapes they have just Reset())
+	int*              geomRefs;
+
+	void              UnshareGeom(void) {if ( geomRefs ) MakeGeomUnique(true);};
+	void              MakeGeomUnique(bool keep); // keep: copy the shared content into the new arrays
+	void              ReleaseGeom(void);
+
 	// temporary data for the various algorithms
 	typedef struct edge_data {
 		int              weight;  // weight of the edge (to handle multiple edges)
@@ -205,7 +217,9 @@ public:
 	void              MakeVoronoiData(bool nVal);
 
 	// insertion/deletion/movement of elements in the graph
-	void              Copy(Shape* a);
+	// the copy shares a's points and edges until one of the 2 shapes changes them, so copies that are
+	// only read cost nothing; several threads can copy the same shape, as long as none changes it
+	void              Copy(Shape* a,bool withBackData=false); // withBackData: also copy a's ebData, if it has one
 	// -reset the graph, and ensure there's room for n points and m edges
 	void              Reset(int n=0,int m=0);
 	//  -points:
@@ -304,6 +318,12 @@ public:
 	int               ConvertToShape(Shape* a,FillRule directed=fill_nonZero,bool invert=false); // directed=true <=> non-zero fill rule
 																																									 // directed=false <=> even-odd fill rule
 																					// invert=true: make as if you inverted all edges in the source
+	// Path::Fill() and ConvertToShape() in one call: paths[first]..paths[first+count-1] are filled with their index as
+	// path ID, into a graph sized once for all of them; that graph is still built, since the sweep walks its
+	// per-point edge lists
+	// graph is scratch space for that graph; passing the same one from call to call reuses its arrays, NULL uses a
+	// temporary one
+	int               ConvertToShape(Path** paths,int first,int count,FillRule directed=fill_nonZero,Shape* graph=NULL);
 	int               Reoriente(Shape* a); // subcase of ConvertToShape: the input a is already intersection-free
 	                                       // all that's missing are the correct directions of the edges
 	                                       // Reoriented is equivalent to ConvertToShape(a,false,false) , but faster sicne
@@ -311,6 +331,12 @@ public:
 	void              ForceToPolygon(void); // force the Shape to believe it's a polygon (eulerian+intersection-free+no
 	                                        // duplicate edges+no duplicate points)
 	                                        // be careful when using this function
+	// is the graph intersection-free? edges may only meet at their endpoints
+	// O(n log n) sweep, skipped if the graph is flagged known_simple (only edges collapsing on the rounding grid are checked)
+	// nota: the points get sorted
+	bool              IntersectionFree(void);
+	void              SetKnownSimple(bool nVal) {SetFlag(known_simple,nVal);};
+	bool              IsKnownSimple(void) {return (flags&known_simple);};
 
 	// the coordinate rounding function
 	static float             Round(float x) {return ldexpf(roundf(ldexpf(x,5)),-5);};
@@ -356,6 +382,21 @@ public:
 	// the offset is dec, with joins between edges of type "join" (see LivarotDefs.h)
 	// the result is NOT a polygon; you need a subsequent call to ConvertToShape to get a real polygon
 	int               MakeOffset(Shape* of,float dec,JoinType join,float miter);
+	// same thing for nbShape polygons at once: the raw offsets all go in this graph, which is sized once up front
+	// with dec != 0, an empty polygon fails the whole batch with shape_input_err, like it fails the call above
+	int               MakeOffset(int nbShape,Shape** of,float dec,JoinType join,float miter);
+	// the whole pipeline for nbShape polygons: the raw offset graph is built in "work" and swept once with
+	// fill_positive into this, so a batch of glyphs costs one sweep instead of one per glyph plus the unions
+	int               ConvertToOffset(int nbShape,Shape** of,float dec,JoinType join,float miter,Shape* work);
+
+	// clip the polygon "a" against the axis-aligned rectangle [l,r]x[t,b]
+	// the edges of a are cut at the border of the rectangle, and the pieces of border that lie inside a are stitched
+	// back in; it's linear in the size of a (plus sorting the crossings) and doesn't need a sweep
+	// back data is kept: the edges of the border get pathID=-1, the other ones keep their piece with adjusted tSt/tEn
+	// degenerate cases (a point of a on the border, ambiguous crossings) are handed to Booleen(a,rectangle,bool_op_inters)
+	// and usedBooleen is set to true in that case
+	// same return code as Booleen
+	int               ClipToRect(Shape* a,float l,float t,float r,float b,bool &usedBooleen);
 
 private:
 		// coz' i'm lazy
@@ -391,14 +432,49 @@ private:
 			int             no;
 			bool            starting;
 			float          x,y;
+			double          key;  // pseudo-angle of (x,y), see EdgeKey()
 		} edge_list;
-	void              SortEdgesList(edge_list* edges,int s,int e); // edge sorting function
+		enum {
+			edge_sort_small=16    // up to this many edges at a point, SortEdgesList() uses an insertion sort
+		};
+	// sorts the nb edges in list by direction, using the nb entries in temp when there are more than
+	// edge_sort_small of them
+	void              SortEdgesList(edge_list* list,edge_list* temp,int nb); // edge sorting function
+	static double     EdgeKey(float x,float y);
 	static int        CmpToVert(float ax,float ay,float bx,float by); // edge direction comparison function
+	bool              EdgesTouch(int ea,int eb); // for IntersectionFree(): do the edges meet elsewhere than a shared endpoint?
+
+	typedef struct clip_event { // crossing of the rectangle's border, for ClipToRect()
+		double          pos;      // position along the border, going (l,t)->(l,b)->(r,b)->(r,t)
+		int             pt;       // the crossing point in the result
+		bool            entering; // the edge enters the rectangle at this point
+	} clip_event;
+	static int        CmpClipEvent(const void * p1, const void * p2) {
+		clip_event* d1=(clip_event*)p1;
+		clip_event* d2=(clip_event*)p2;
+		if ( d1->pos == d2->pos ) return 0;
+		return (( d1->pos < d2->pos )?-1:1);
+	};
+	int               ClipToRectBooleen(Shape* a,float l,float t,float r,float b,bool &usedBooleen);
 	
 	void              TesteIntersection(SweepTree* t,bool onLeft,bool onlyDiff); // test if there is an intersection
 	bool              TesteIntersection(SweepTree* iL,SweepTree* iR,float &atx,float &aty,float &atL,float &atR,bool onlyDiff);
 	bool              TesteIntersection(Shape* iL,Shape* iR,int ilb,int irb,float &atx,float &aty,float &atL,float &atR,bool onlyDiff);
 	bool              TesteAdjacency(Shape* iL,int ilb,float atx,float aty,int nPt,bool push);
+	typedef struct adjacency_edge { // an edge of the sweepline, ready to be tested against runs of points of the result
+		int             stPt,enPt;   // its endpoints in the result, never adjacent to it
+		double          stx,sty;     // rounded start point
+		double          dx,dy;       // rounded edge vector
+		double          length,isqlength;
+	} adjacency_edge;
+	enum {
+		adjacency_block = 16           // points tested per call of the kernel
+	};
+	static void       PrepareAdjacency(Shape* a,int no,adjacency_edge &e);
+	void              TesteAdjacencies(adjacency_edge &e,int st,int en,char* hits); // TesteAdjacency() for the points st..en-1
+	int               AdjacentRun(adjacency_edge &e,int from,int nb,int dir); // number of adjacent points in a row from `from`
+	bool              AdjacentSpan(adjacency_edge &e,int st,int en,int &first,int &last); // adjacent points among st..en-1
+	static void       MergeRnd(sweep_src_data &d,int first,int last,int lastChgtPt);
 	int               PushIncidence(Shape* a,int cb,int pt,float theta);
 	int               CreateIncidence(Shape* a,int cb,int pt);
 	void              AssemblePoints(Shape* a);
@@ -429,12 +505,31 @@ private:
 		return 0;
 	};
 
-	void              AddContour(Path* dest,int nbP,Path* *orig,int startBord,int curBord);
+		// recomposition index for ConvertToForme(): what a piece of an original path needs to be re-emitted, decoded
+		// once per (pathID,pieceID) even when the sweep split the piece in several runs
+		typedef struct forme_piece {
+			int             pathID,pieceID; // pathID < 0 for a free slot
+			float           stx,sty;        // end of the previous command, ie where the piece starts
+			float           sang,eang;      // arcs: the angles, already unwrapped in the arc's direction
+			int             inBezier,nbInterm; // quadratic splines: the descr_bezierto owning the piece, -1 if none
+			float           bstx,bsty;      // and where that spline starts
+		} forme_piece;
+		typedef struct forme_index {
+			int             nb,max;         // max is a power of 2
+			forme_piece*    pieces;
+		} forme_index;
+	static forme_piece* FormePiece(forme_index &index,Path* from,int nPath,int nPiece);
+
+	// appends the raw offset of a to this graph
+	int               AddOffset(Shape* a,float dec,JoinType join,float miter);
+	static void       OffsetSize(Shape* a,float dec,int &nbP,int &nbA);
+
+	void              AddContour(Path* dest,int nbP,Path* *orig,int startBord,int curBord,forme_index &index);
 	int               ReFormeLineTo(int bord,int curBord,Path *dest,Path* orig);
-	int               ReFormeArcTo(int bord,int curBord,Path *dest,Path* orig);
-	int               ReFormeCubicTo(int bord,int curBord,Path *dest,Path* orig);
-	int               ReFormeBezierTo(int bord,int curBord,Path *dest,Path* orig);
-	void							ReFormeBezierChunk(float px,float py,float nx,float ny,Path *dest,int inBezier,int nbInterm,Path* from,int p,float ts,float te);
+	int               ReFormeArcTo(int bord,int curBord,Path *dest,Path* orig,forme_piece* piece);
+	int               ReFormeCubicTo(int bord,int curBord,Path *dest,Path* orig,forme_piece* piece);
+	int               ReFormeBezierTo(int bord,int curBord,Path *dest,Path* orig,forme_piece* piece);
+	void							ReFormeBezierChunk(float px,float py,float nx,float ny,Path *dest,forme_piece* piece,Path* from,int p,float ts,float te);
 
 		// annexes pour la rasterization
 	void              CreateEdge(int no,float to,float step);
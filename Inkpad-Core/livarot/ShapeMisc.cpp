@@ -8,28 +8,20 @@
 
 #include "Shape.h"
 #include "Path.h"
+#include "LivarotStats.h"
 
 void              Shape::ConvertToForme(Path* dest)
 {
+	LIVAROT_SCOPE(stat_convert_to_forme);
 	if ( nbPt <= 1 || nbAr <= 1 ) return;
 	if ( Eulerian(true) == false ) return;
 
 	dest->Reset();
 	dest->SetWeighted(false);
 	
-	MakePointData(true);
-	MakeEdgeData(true);
+	// the walk only needs the sorted incidence lists and the traversal links
 	MakeSweepDestData(true);
 
-	for (int i=0;i<nbPt;i++) {
-		pData[i].rx=Round(pts[i].x);
-		pData[i].ry=Round(pts[i].y);
-	}
-	for (int i=0;i<nbAr;i++) {
-		eData[i].rdx=pData[aretes[i].en].rx-pData[aretes[i].st].rx;
-		eData[i].rdy=pData[aretes[i].en].ry-pData[aretes[i].st].ry;
-	}
-
 	SortEdges();
 
 	for (int i=0;i<nbAr;i++) {
@@ -111,6 +103,7 @@ void              Shape::ConvertToForme(Path* dest)
 }
 void				 Shape::ConvertToForme(Path* dest,int nbP,Path* *orig)
 {
+	LIVAROT_SCOPE(stat_convert_to_forme);
 	if ( nbPt <= 1 || nbAr <= 1 ) return;
 	if ( Eulerian(true) == false ) return;
 	
@@ -122,21 +115,16 @@ void				 Shape::ConvertToForme(Path* dest,int nbP,Path* *orig)
 	dest->Reset();
 	dest->SetWeighted(false);
 	
-	MakePointData(true);
-	MakeEdgeData(true);
 	MakeSweepDestData(true);
 	
-	for (int i=0;i<nbPt;i++) {
-		pData[i].rx=Round(pts[i].x);
-		pData[i].ry=Round(pts[i].y);
-	}
-	for (int i=0;i<nbAr;i++) {
-		eData[i].rdx=pData[aretes[i].en].rx-pData[aretes[i].st].rx;
-		eData[i].rdy=pData[aretes[i].en].ry-pData[aretes[i].st].ry;
-	}
-	
 	SortEdges();
 	
+	forme_index  index;
+	index.nb=0;
+	index.max=64;
+	index.pieces=(forme_piece*)malloc(index.max*sizeof(forme_piece));
+	for (int i=0;i<index.max;i++) index.pieces[i].pathID=-1;
+	
 	for (int i=0;i<nbAr;i++) {
 		swdData[i].misc=0;
 		swdData[i].precParc=swdData[i].suivParc=-1;
@@ -193,7 +181,7 @@ void				 Shape::ConvertToForme(Path* dest,int nbP,Path* *orig)
 //							dest->descr_nb--;
 						} else {
 							swdData[curBord].suivParc=-1;
-							AddContour(dest,nbP,orig,startBord,curBord);
+							AddContour(dest,nbP,orig,startBord,curBord,index);
 						}
 //						dest->Close();
 					}
@@ -212,7 +200,7 @@ void				 Shape::ConvertToForme(Path* dest,int nbP,Path* *orig)
             if ( aretes[curBord].en == curStartPt ) {
               //printf("contour %i ",curStartPt);
               swdData[curBord].suivParc = -1;
-              AddContour (dest, nbP, orig, startBord, curBord);
+              AddContour (dest, nbP, orig, startBord, curBord, index);
               startBord=nb;
             }
           }
@@ -229,6 +217,7 @@ void				 Shape::ConvertToForme(Path* dest,int nbP,Path* *orig)
 		}
 	} while ( lastPtUsed < nbPt );
 	
+	free(index.pieces);
 	MakePointData(false);
 	MakeEdgeData(false);
 	MakeSweepDestData(false);
@@ -236,29 +225,55 @@ void				 Shape::ConvertToForme(Path* dest,int nbP,Path* *orig)
 // offsets
 int          Shape::MakeOffset(Shape* a, float dec,JoinType join,float miter)
 {
-	Reset(0,0);
+	return MakeOffset(1,&a,dec,join,miter);
+}
+int          Shape::MakeOffset(int nbShape,Shape** of,float dec,JoinType join,float miter)
+{
+	LIVAROT_SCOPE(stat_make_offset);
+	for (int i=0;i<nbShape;i++) {
+		if ( of[i] == NULL || of[i] == this ) return shape_input_err;
+	}
+	int   nbP=0,nbA=0;
+	for (int i=0;i<nbShape;i++) OffsetSize(of[i],dec,nbP,nbA);
 	MakeBackData(false);
+	Reset(nbP,nbA);
+	for (int i=0;i<nbShape;i++) {
+		int  err=AddOffset(of[i],dec,join,miter);
+		if ( err != 0 ) {
+			Reset(0,0);
+			return err;
+		}
+	}
+	return 0;
+}
+int          Shape::ConvertToOffset(int nbShape,Shape** of,float dec,JoinType join,float miter,Shape* work)
+{
+	if ( work == NULL || work == this ) return shape_input_err;
+	Reset(0,0);
+	int  err=work->MakeOffset(nbShape,of,dec,join,miter);
+	if ( err != 0 ) return err;
+	return ConvertToShape(work,fill_positive);
+}
+// upper bound for the common joins, so that building the raw graph doesn't realloc; round joins can still grow it
+void         Shape::OffsetSize(Shape* a,float dec,int &nbP,int &nbA)
+{
 	if ( dec == 0 ) {
-		nbPt=a->nbPt;
-		if ( nbPt > maxPt ) {
-			maxPt=nbPt;
-			pts=(dg_point*)realloc(pts,maxPt*sizeof(dg_point));
-			if ( HasPointsData() ) pData=(point_data*)realloc(pData,maxPt*sizeof(point_data));
-		}
-		memcpy(pts,a->pts,nbPt*sizeof(dg_point));
-
-		nbAr=a->nbAr;
-		if ( nbAr > maxAr ) {
-			maxAr=nbAr;
-			aretes=(dg_arete*)realloc(aretes,maxAr*sizeof(dg_arete));
-			if ( HasEdgesData() ) eData=(edge_data*)realloc(eData,maxAr*sizeof(edge_data));
-			if ( HasSweepSrcData() ) swsData=(sweep_src_data*)realloc(swsData,maxAr*sizeof(sweep_src_data));
-			if ( HasSweepDestData() ) swdData=(sweep_dest_data*)realloc(swdData,maxAr*sizeof(sweep_dest_data));
-			if ( HasRasterData() ) swrData=(raster_data*)realloc(swrData,maxAr*sizeof(raster_data));
-		}
-		memcpy(aretes,a->aretes,nbAr*sizeof(dg_arete));
+		nbP+=a->nbPt;
+		nbA+=a->nbAr;
+	} else {
+		nbP+=3*a->nbAr;
+		nbA+=3*a->nbAr;
+	}
+}
+int          Shape::AddOffset(Shape* a, float dec,JoinType join,float miter)
+{
+	if ( dec == 0 ) {
+		int  firstP=nbPt;
+		for (int i=0;i<a->nbPt;i++) AddPoint(a->pts[i].x,a->pts[i].y);
+		for (int i=0;i<a->nbAr;i++) AddEdge(firstP+a->aretes[i].st,firstP+a->aretes[i].en);
 		return 0;
 	}
+	// as for the single-shape MakeOffset, an empty or non-polygon input is an error, and fails the whole batch
 	if ( a->nbPt <= 1 || a->nbAr <= 1 || a->type != shape_polygon ) return shape_input_err;
 	
 	a->SortEdges();
@@ -266,6 +281,7 @@ int          Shape::MakeOffset(Shape* a, float dec,JoinType join,float miter)
 	a->MakeSweepDestData(true);
 	a->MakeSweepSrcData(true);
 	
+	int   firstA=nbAr;
 	for (int i=0;i<a->nbAr;i++) {
 //		int    stP=a->swsData[i].stPt/*,enP=a->swsData[i].enPt*/;
 		int    stB=-1,enB=-1;
@@ -308,7 +324,7 @@ Path::DoLeftJoin(this,-dec,join,ptP,stD,seD,miter,stL,seL,stNo,enNo);
 		}
 	}
 	if ( dec < 0 ) {
-		for (int i=0;i<nbAr;i++) Inverse(i);
+		for (int i=firstA;i<nbAr;i++) Inverse(i);
 	}
 	for (int i=0;i<a->nbAr;i++) {
 		AddEdge(a->swsData[i].stPt,a->swsData[i].enPt);
@@ -319,7 +335,328 @@ Path::DoLeftJoin(this,-dec,join,ptP,stD,seD,miter,stL,seL,stNo,enNo);
 	
 	return 0;
 }
-void          Shape::AddContour(Path* dest,int nbP,Path* *orig,int startBord,int curBord)
+// clipping against an axis-aligned rectangle
+int          Shape::ClipToRect(Shape* a,float l,float t,float r,float b,bool &usedBooleen)
+{
+	usedBooleen=false;
+	if ( a == NULL || a == this ) return shape_input_err;
+	Reset(0,0);
+	if ( a->nbPt <= 1 || a->nbAr <= 1 ) return 0;
+	if ( a->type != shape_polygon ) return shape_input_err;
+
+	// the rectangle is put on the rounding grid, like the points of the sweep
+	l=Round(l);
+	t=Round(t);
+	r=Round(r);
+	b=Round(b);
+	if ( l >= r || t >= b ) return 0;
+
+	MakeBackData(a->HasBackData());
+
+	// trivial cases: a is entirely outside or entirely inside
+	a->CalcBBox();
+	if ( a->rightX < l || a->leftX > r || a->bottomY < t || a->topY > b ) return 0;
+	if ( a->leftX > l && a->rightX < r && a->topY > t && a->bottomY < b ) {
+		Copy(a,true);
+		return 0;
+	}
+
+	// points on the border make the stitching ambiguous
+	for (int i=0;i<a->nbPt;i++) {
+		float  px=a->pts[i].x,py=a->pts[i].y;
+		if ( py >= t && py <= b && ( px == l || px == r ) ) return ClipToRectBooleen(a,l,t,r,b,usedBooleen);
+		if ( px >= l && px <= r && ( py == t || py == b ) ) return ClipToRectBooleen(a,l,t,r,b,usedBooleen);
+	}
+
+	double       w=r-l,h=b-t;
+	double       perimeter=2*(w+h);
+	int*         ptMap=(int*)malloc(a->nbPt*sizeof(int));
+	clip_event*  evts=(clip_event*)malloc(2*a->nbAr*sizeof(clip_event));
+	int          nbEvt=0;
+	bool         degenerate=false;
+
+	for (int i=0;i<a->nbPt;i++) ptMap[i]=-1;
+
+	// cut the edges
+	for (int i=0;i<a->nbAr && degenerate == false;i++) {
+		int     st=a->aretes[i].st,en=a->aretes[i].en;
+		double  sx=a->pts[st].x,sy=a->pts[st].y;
+		double  dx=a->pts[en].x-sx,dy=a->pts[en].y-sy;
+		if ( dx == 0 && ( sx == l || sx == r ) ) {degenerate=true;break;}
+		if ( dy == 0 && ( sy == t || sy == b ) ) {degenerate=true;break;}
+
+		// liang-barsky: sides are 0= x=l, 1= x=r, 2= y=t, 3= y=b
+		double  p[4]={-dx,dx,-dy,dy};
+		double  q[4]={sx-l,r-sx,sy-t,b-sy};
+		double  t0=0,t1=1;
+		int     s0=-1,s1=-1;
+		bool    outside=false;
+		for (int k=0;k<4;k++) {
+			if ( p[k] == 0 ) {
+				if ( q[k] < 0 ) {outside=true;break;}
+				continue;
+			}
+			double  at=q[k]/p[k];
+			if ( p[k] < 0 ) {
+				if ( at > t1 ) {outside=true;break;}
+				if ( at > t0 ) {t0=at;s0=k;}
+			} else {
+				if ( at < t0 ) {outside=true;break;}
+				if ( at < t1 ) {t1=at;s1=k;}
+			}
+		}
+		if ( outside || t0 >= t1 ) continue;
+
+		int     nst,nen;
+		float   stx,sty,enx,eny;
+		if ( s0 < 0 ) {
+			if ( ptMap[st] < 0 ) {
+				ptMap[st]=AddPoint(a->pts[st].x,a->pts[st].y);
+				pts[ptMap[st]].oldDegree=a->pts[st].oldDegree;
+			}
+			nst=ptMap[st];
+		} else {
+			stx=sx+t0*dx;
+			sty=sy+t0*dy;
+			evts[nbEvt].pos=0;
+			if ( s0 == 0 ) {
+				stx=l;sty=Round(sty);if ( sty < t ) sty=t; else if ( sty > b ) sty=b;
+				evts[nbEvt].pos=sty-t;
+			} else if ( s0 == 1 ) {
+				stx=r;sty=Round(sty);if ( sty < t ) sty=t; else if ( sty > b ) sty=b;
+				evts[nbEvt].pos=h+w+(b-sty);
+			} else if ( s0 == 2 ) {
+				sty=t;stx=Round(stx);if ( stx < l ) stx=l; else if ( stx > r ) stx=r;
+				evts[nbEvt].pos=2*h+w+(r-stx);
+			} else {
+				sty=b;stx=Round(stx);if ( stx < l ) stx=l; else if ( stx > r ) stx=r;
+				evts[nbEvt].pos=h+(stx-l);
+			}
+			if ( evts[nbEvt].pos >= perimeter ) evts[nbEvt].pos-=perimeter;
+			nst=AddPoint(stx,sty);
+			pts[nst].oldDegree=2;
+			evts[nbEvt].pt=nst;
+			evts[nbEvt].entering=true;
+			nbEvt++;
+		}
+		if ( s1 < 0 ) {
+			if ( ptMap[en] < 0 ) {
+				ptMap[en]=AddPoint(a->pts[en].x,a->pts[en].y);
+				pts[ptMap[en]].oldDegree=a->pts[en].oldDegree;
+			}
+			nen=ptMap[en];
+		} else {
+			enx=sx+t1*dx;
+			eny=sy+t1*dy;
+			evts[nbEvt].pos=0;
+			if ( s1 == 0 ) {
+				enx=l;eny=Round(eny);if ( eny < t ) eny=t; else if ( eny > b ) eny=b;
+				evts[nbEvt].pos=eny-t;
+			} else if ( s1 == 1 ) {
+				enx=r;eny=Round(eny);if ( eny < t ) eny=t; else if ( eny > b ) eny=b;
+				evts[nbEvt].pos=h+w+(b-eny);
+			} else if ( s1 == 2 ) {
+				eny=t;enx=Round(enx);if ( enx < l ) enx=l; else if ( enx > r ) enx=r;
+				evts[nbEvt].pos=2*h+w+(r-enx);
+			} else {
+				eny=b;enx=Round(enx);if ( enx < l ) enx=l; else if ( enx > r ) enx=r;
+				evts[nbEvt].pos=h+(enx-l);
+			}
+			if ( evts[nbEvt].pos >= perimeter ) evts[nbEvt].pos-=perimeter;
+			nen=AddPoint(enx,eny);
+			pts[nen].oldDegree=2;
+			evts[nbEvt].pt=nen;
+			evts[nbEvt].entering=false;
+			nbEvt++;
+		}
+		if ( pts[nst].x == pts[nen].x && pts[nst].y == pts[nen].y ) {
+			// the rounding ate the edge
+			degenerate=true;
+			break;
+		}
+
+		int ne=AddEdge(nst,nen);
+		if ( HasBackData() ) {
+			ebData[ne].pathID=a->ebData[i].pathID;
+			ebData[ne].pieceID=a->ebData[i].pieceID;
+			ebData[ne].tSt=a->ebData[i].tSt*(1-t0)+a->ebData[i].tEn*t0;
+			ebData[ne].tEn=a->ebData[i].tSt*(1-t1)+a->ebData[i].tEn*t1;
+		}
+	}
+
+	// stitch the border: walking along the border in the direction of the polygons' orientation, each point where
+	// an edge leaves the rectangle is followed by a point where an edge comes back in
+	float    cornX[4]={l,l,r,r};
+	float    cornY[4]={t,b,b,t};
+	double   cornPos[4]={0,h,h+w,2*h+w};
+	if ( degenerate == false && nbEvt > 0 ) {
+		qsort(evts,nbEvt,sizeof(clip_event),CmpClipEvent);
+		if ( nbEvt%2 == 1 ) degenerate=true;
+		for (int i=0;i<nbEvt && degenerate == false;i++) {
+			int  ni=(i+1)%nbEvt;
+			if ( evts[i].pos == evts[ni].pos ) {degenerate=true;break;}
+			if ( evts[i].entering ) continue;
+			if ( evts[ni].entering == false ) {degenerate=true;break;}
+
+			double  stPos=evts[i].pos,enPos=evts[ni].pos;
+			if ( enPos < stPos ) enPos+=perimeter;
+			int     lastPt=evts[i].pt;
+			for (int k=0;k<8;k++) {
+				double  cPos=cornPos[k%4]+((k >= 4)?perimeter:0);
+				if ( cPos <= stPos || cPos >= enPos ) continue;
+				int     nPt=AddPoint(cornX[k%4],cornY[k%4]);
+				pts[nPt].oldDegree=2;
+				int     ne=AddEdge(lastPt,nPt);
+				if ( HasBackData() ) {
+					ebData[ne].pathID=ebData[ne].pieceID=-1;
+					ebData[ne].tSt=0.0;
+					ebData[ne].tEn=1.0;
+				}
+				lastPt=nPt;
+			}
+			int     ne=AddEdge(lastPt,evts[ni].pt);
+			if ( HasBackData() ) {
+				ebData[ne].pathID=ebData[ne].pieceID=-1;
+				ebData[ne].tSt=0.0;
+				ebData[ne].tEn=1.0;
+			}
+		}
+	} else if ( degenerate == false ) {
+		// no crossing: the border is either entirely inside a or entirely outside
+		// test with the middle of the left side, which can't be on an edge of a
+		double  px=l,py=0.5*(t+b);
+		int     wind=0;
+		for (int i=0;i<a->nbAr;i++) {
+			double  ax=a->pts[a->aretes[i].st].x,ay=a->pts[a->aretes[i].st].y;
+			double  bx=a->pts[a->aretes[i].en].x,by=a->pts[a->aretes[i].en].y;
+			if ( ( ay <= py ) == ( by <= py ) ) continue;
+			double  cx=ax+(py-ay)*(bx-ax)/(by-ay);
+			if ( cx < px ) wind+=(by > ay)?1:-1;
+		}
+		if ( wind != 0 ) {
+			int  cPt[4];
+			for (int k=0;k<4;k++) {
+				cPt[k]=AddPoint(cornX[k],cornY[k]);
+				pts[cPt[k]].oldDegree=2;
+			}
+			for (int k=0;k<4;k++) {
+				int ne=AddEdge(cPt[k],cPt[(k+1)%4]);
+				if ( HasBackData() ) {
+					ebData[ne].pathID=ebData[ne].pieceID=-1;
+					ebData[ne].tSt=0.0;
+					ebData[ne].tEn=1.0;
+				}
+			}
+		}
+	}
+
+	free(ptMap);
+	free(evts);
+
+	if ( degenerate || Eulerian(true) == false ) return ClipToRectBooleen(a,l,t,r,b,usedBooleen);
+
+	type=shape_polygon;
+	return 0;
+}
+int          Shape::ClipToRectBooleen(Shape* a,float l,float t,float r,float b,bool &usedBooleen)
+{
+	usedBooleen=true;
+
+	Shape*  rect=new Shape;
+	rect->Reset(4,4);
+	if ( a->HasBackData() ) rect->MakeBackData(true);
+	int  p0=rect->AddPoint(l,t);
+	int  p1=rect->AddPoint(l,b);
+	int  p2=rect->AddPoint(r,b);
+	int  p3=rect->AddPoint(r,t);
+	rect->AddEdge(p0,p1);
+	rect->AddEdge(p1,p2);
+	rect->AddEdge(p2,p3);
+	rect->AddEdge(p3,p0);
+	if ( rect->HasBackData() ) {
+		for (int i=0;i<rect->nbAr;i++) {
+			rect->ebData[i].pathID=rect->ebData[i].pieceID=-1;
+			rect->ebData[i].tSt=0.0;
+			rect->ebData[i].tEn=1.0;
+		}
+	}
+	rect->type=shape_polygon;
+
+	int  res=Booleen(a,rect,bool_op_inters);
+	delete rect;
+	return res;
+}
+static inline int   FormeHash(int nPath,int nPiece,int mask)
+{
+	uint32_t  h=((uint32_t)nPath)*0x9E3779B1u+(uint32_t)nPiece;
+	h^=h>>16;
+	h*=0x85EBCA6Bu;
+	h^=h>>13;
+	return (int)(h&(uint32_t)mask);
+}
+Shape::forme_piece*  Shape::FormePiece(forme_index &index,Path* from,int nPath,int nPiece)
+{
+	int  mask=index.max-1;
+	int  i=FormeHash(nPath,nPiece,mask);
+	while ( index.pieces[i].pathID >= 0 ) {
+		if ( index.pieces[i].pathID == nPath && index.pieces[i].pieceID == nPiece ) return index.pieces+i;
+		i=(i+1)&mask;
+	}
+	if ( 2*(index.nb+1) > index.max ) {
+		// keep the table at most half full
+		forme_piece*  old=index.pieces;
+		int           oldMax=index.max;
+		index.max*=2;
+		mask=index.max-1;
+		index.pieces=(forme_piece*)malloc(index.max*sizeof(forme_piece));
+		for (int j=0;j<index.max;j++) index.pieces[j].pathID=-1;
+		for (int j=0;j<oldMax;j++) {
+			if ( old[j].pathID < 0 ) continue;
+			int  k=FormeHash(old[j].pathID,old[j].pieceID,mask);
+			while ( index.pieces[k].pathID >= 0 ) k=(k+1)&mask;
+			index.pieces[k]=old[j];
+		}
+		free(old);
+		i=FormeHash(nPath,nPiece,mask);
+		while ( index.pieces[i].pathID >= 0 ) i=(i+1)&mask;
+	}
+	forme_piece*  n=index.pieces+i;
+	index.nb++;
+	n->pathID=nPath;
+	n->pieceID=nPiece;
+	n->stx=n->sty=0;
+	n->sang=n->eang=0;
+	n->inBezier=n->nbInterm=-1;
+	n->bstx=n->bsty=0;
+	from->PrevPoint(nPiece-1,n->stx,n->sty);
+
+	int   typ=from->descr_data[nPiece].flags&descr_type_mask;
+	if ( typ == descr_arcto ) {
+		bool  nClockwise=from->descr_data[nPiece].d.a.clockwise;
+Path::ArcAngles(n->stx,n->sty,from->descr_data[nPiece].d.a.x,from->descr_data[nPiece].d.a.y,from->descr_data[nPiece].d.a.rx,from->descr_data[nPiece].d.a.ry,
+						from->descr_data[nPiece].d.a.angle,from->descr_data[nPiece].d.a.large,nClockwise,n->sang,n->eang);
+		if ( nClockwise ) {
+			if ( n->sang < n->eang ) n->sang+=2*M_PI;
+		} else {
+			if ( n->sang > n->eang ) n->sang-=2*M_PI;
+		}
+	} else if ( typ == descr_bezierto ) {
+		n->inBezier=nPiece;
+		n->nbInterm=from->descr_data[nPiece].d.b.nb;
+	} else if ( typ == descr_interm_bezier ) {
+		for (int j=nPiece-1;j>0;j--) {
+			if ( (from->descr_data[j].flags&descr_type_mask) == descr_bezierto ) {
+				n->inBezier=j;
+				n->nbInterm=from->descr_data[j].d.b.nb;
+				break;
+			}
+		}
+	}
+	if ( n->inBezier >= 0 ) from->PrevPoint(n->inBezier-1,n->bstx,n->bsty);
+	return n;
+}
+
+void          Shape::AddContour(Path* dest,int nbP,Path* *orig,int startBord,int curBord,forme_index &index)
 {	
 	int      bord=startBord;
 	
@@ -348,17 +685,17 @@ void          Shape::AddContour(Path* dest,int nbP,Path* *orig,int startBord,int
 				} else if ( nType == descr_lineto ) {
 					bord=ReFormeLineTo(bord,curBord,dest,from);
 				} else if ( nType == descr_arcto ) {
-					bord=ReFormeArcTo(bord,curBord,dest,from);
+					bord=ReFormeArcTo(bord,curBord,dest,from,FormePiece(index,from,nPath,nPiece));
 				} else if ( nType == descr_cubicto ) {
-					bord=ReFormeCubicTo(bord,curBord,dest,from);
+					bord=ReFormeCubicTo(bord,curBord,dest,from,FormePiece(index,from,nPath,nPiece));
 				} else if ( nType == descr_bezierto ) {
 					if ( from->descr_data[nPiece].d.b.nb == 0 ) {
 						bord=ReFormeLineTo(bord,curBord,dest,from);
 					} else {
-						bord=ReFormeBezierTo(bord,curBord,dest,from);
+						bord=ReFormeBezierTo(bord,curBord,dest,from,FormePiece(index,from,nPath,nPiece));
 					}
 				} else if ( nType == descr_interm_bezier ) {
-					bord=ReFormeBezierTo(bord,curBord,dest,from);
+					bord=ReFormeBezierTo(bord,curBord,dest,from,FormePiece(index,from,nPath,nPiece));
 				} else {
 					// devrait pas arriver non plus
 					dest->LineTo(pts[aretes[bord].en].x,pts[aretes[bord].en].y);
@@ -396,7 +733,7 @@ int          Shape::ReFormeLineTo(int bord,int curBord,Path *dest,Path *orig)
 	dest->LineTo(nx,ny);
 	return bord;
 }
-int          Shape::ReFormeArcTo(int bord,int curBord,Path *dest,Path* from)
+int          Shape::ReFormeArcTo(int bord,int curBord,Path *dest,Path* from,forme_piece* piece)
 {
 	int		 nPiece=ebData[bord].pieceID;
 	int		 nPath=ebData[bord].pathID;
@@ -420,19 +757,9 @@ int          Shape::ReFormeArcTo(int bord,int curBord,Path *dest,Path* from)
 		}
 		bord=swdData[bord].suivParc;
 	}
-	float  sang,eang;
-	bool  nLarge=from->descr_data[nPiece].d.a.large;
+	bool  nLarge;
 	bool  nClockwise=from->descr_data[nPiece].d.a.clockwise;
-	float prevx,prevy;
-	from->PrevPoint(nPiece-1,prevx,prevy);
-Path::ArcAngles(prevx,prevy,from->descr_data[nPiece].d.a.x,from->descr_data[nPiece].d.a.y,from->descr_data[nPiece].d.a.rx,from->descr_data[nPiece].d.a.ry,
-						from->descr_data[nPiece].d.a.angle,nLarge,nClockwise,sang,eang);
-	if ( nClockwise ) {
-		if ( sang < eang ) sang+=2*M_PI;
-	} else {
-		if ( sang > eang ) sang-=2*M_PI;
-	}
-	float delta=eang-sang;
+	float delta=piece->eang-piece->sang;
 	float ndelta=delta*(te-ts);
 	if ( ts > te ) nClockwise=!nClockwise;
 	if ( ndelta < 0 ) ndelta=-ndelta;
@@ -455,7 +782,7 @@ Path::ArcAngles(prevx,prevy,from->descr_data[nPiece].d.a.x,from->descr_data[nPie
 	dest->ArcTo(nx,ny,from->descr_data[nPiece].d.a.rx,from->descr_data[nPiece].d.a.ry,from->descr_data[nPiece].d.a.angle,nLarge,nClockwise);
 	return bord;
 }
-int          Shape::ReFormeCubicTo(int bord,int curBord,Path *dest,Path *from)
+int          Shape::ReFormeCubicTo(int bord,int curBord,Path *dest,Path *from,forme_piece* piece)
 {
 	int		 nPiece=ebData[bord].pieceID;
 	int		 nPath=ebData[bord].pathID;
@@ -478,8 +805,7 @@ int          Shape::ReFormeCubicTo(int bord,int curBord,Path *dest,Path *from)
 		}
 		bord=swdData[bord].suivParc;
 	}
-	float prevx,prevy;
-	from->PrevPoint(nPiece-1,prevx,prevy);
+	float prevx=piece->stx,prevy=piece->sty;
 	
 	float sDx,sDy,eDx,eDy;
 Path::CubicTangent(ts,sDx,sDy,prevx,prevy,from->descr_data[nPiece].d.c.stDx,from->descr_data[nPiece].d.c.stDy
@@ -493,7 +819,7 @@ Path::CubicTangent(te,eDx,eDy,prevx,prevy,from->descr_data[nPiece].d.c.stDx,from
 	dest->CubicTo(nx,ny,sDx,sDy,eDx,eDy);
 	return bord;
 }
-int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from)
+int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from,forme_piece* piece)
 {
 	int		 nPiece=ebData[bord].pieceID;
 	int		 nPath=ebData[bord].pathID;
@@ -501,28 +827,11 @@ int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from)
 	int    ps=nPiece,pe=nPiece;
 	float  px=pts[aretes[bord].st].x,py=pts[aretes[bord].st].y;
 	float  nx=pts[aretes[bord].en].x,ny=pts[aretes[bord].en].y;
-	int    inBezier=-1,nbInterm=-1;
-	int    typ;
-	typ=from->descr_data[nPiece].flags&descr_type_mask;
-	if ( typ == descr_bezierto ) {
-		inBezier=nPiece;
-		nbInterm=from->descr_data[nPiece].d.b.nb;
-	} else {
-		int n=nPiece-1;
-		while ( n > 0 ) {
-			typ=from->descr_data[n].flags&descr_type_mask;
-			if ( typ == descr_bezierto ) {
-				inBezier=n;
-				nbInterm=from->descr_data[n].d.b.nb;
-				break;
-			}
-			n--;
-		}
-		if ( inBezier < 0 ) {
-			bord=swdData[bord].suivParc;
-			dest->LineTo(nx,ny);
-			return bord;
-		}
+	int    inBezier=piece->inBezier,nbInterm=piece->nbInterm;
+	if ( inBezier < 0 ) {
+		bord=swdData[bord].suivParc;
+		dest->LineTo(nx,ny);
+		return bord;
 	}
 	bord=swdData[bord].suivParc;
 	while ( bord >= 0 ) {
@@ -544,14 +853,8 @@ int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from)
 		bord=swdData[bord].suivParc;
 	}
 	
-	float bstx,bsty;
-	float benx,beny;
-	from->PrevPoint(inBezier-1,bstx,bsty);
-	benx=from->descr_data[inBezier].d.b.x;
-	beny=from->descr_data[inBezier].d.b.y;
-		
 	if ( pe == ps ) {
-		ReFormeBezierChunk(px,py,nx,ny,dest,inBezier,nbInterm,from,ps,ts,te);
+		ReFormeBezierChunk(px,py,nx,ny,dest,piece,from,ps,ts,te);
 	} else if ( ps < pe ) {
 		if ( ts < 0.0001 ) {
 			if ( te > 0.9999 ) {
@@ -569,14 +872,14 @@ int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from)
 					dest->IntermBezierTo(from->descr_data[i+1].d.i.x,from->descr_data[i+1].d.i.y);
 				}
 				dest->EndBezierTo();
-				ReFormeBezierChunk(tx,ty,nx,ny,dest,inBezier,nbInterm,from,pe,0.0,te);
+				ReFormeBezierChunk(tx,ty,nx,ny,dest,piece,from,pe,0.0,te);
 			}
 		} else {
 			if ( te > 0.9999 ) {
 				float  tx,ty;
 				tx=(from->descr_data[ps+1].d.i.x+from->descr_data[ps+2].d.i.x)/2;
 				ty=(from->descr_data[ps+1].d.i.y+from->descr_data[ps+2].d.i.y)/2;
-				ReFormeBezierChunk(px,py,tx,ty,dest,inBezier,nbInterm,from,ps,ts,1.0);
+				ReFormeBezierChunk(px,py,tx,ty,dest,piece,from,ps,ts,1.0);
 				dest->BezierTo(nx,ny);
 				for (int i=ps+1;i<=pe;i++) {
 					dest->IntermBezierTo(from->descr_data[i+1].d.i.x,from->descr_data[i+1].d.i.y);
@@ -586,7 +889,7 @@ int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from)
 				float  tx,ty;
 				tx=(from->descr_data[ps+1].d.i.x+from->descr_data[ps+2].d.i.x)/2;
 				ty=(from->descr_data[ps+1].d.i.y+from->descr_data[ps+2].d.i.y)/2;
-				ReFormeBezierChunk(px,py,tx,ty,dest,inBezier,nbInterm,from,ps,ts,1.0);
+				ReFormeBezierChunk(px,py,tx,ty,dest,piece,from,ps,ts,1.0);
 				tx=(from->descr_data[pe+1].d.i.x+from->descr_data[pe].d.i.x)/2;
 				ty=(from->descr_data[pe+1].d.i.y+from->descr_data[pe].d.i.y)/2;
 				dest->BezierTo(tx,ty);
@@ -594,7 +897,7 @@ int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from)
 					dest->IntermBezierTo(from->descr_data[i+1].d.i.x,from->descr_data[i+1].d.i.y);
 				}
 				dest->EndBezierTo();
-				ReFormeBezierChunk(tx,ty,nx,ny,dest,inBezier,nbInterm,from,pe,0.0,te);
+				ReFormeBezierChunk(tx,ty,nx,ny,dest,piece,from,pe,0.0,te);
 			}
 		}
 	} else {
@@ -614,14 +917,14 @@ int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from)
 					dest->IntermBezierTo(from->descr_data[i+1].d.i.x,from->descr_data[i+1].d.i.y);
 				}
 				dest->EndBezierTo();
-				ReFormeBezierChunk(tx,ty,nx,ny,dest,inBezier,nbInterm,from,pe,1.0,te);
+				ReFormeBezierChunk(tx,ty,nx,ny,dest,piece,from,pe,1.0,te);
 			}
 		} else {
 			if ( te < 0.0001 ) {
 				float  tx,ty;
 				tx=(from->descr_data[ps+1].d.i.x+from->descr_data[ps].d.i.x)/2;
 				ty=(from->descr_data[ps+1].d.i.y+from->descr_data[ps].d.i.y)/2;
-				ReFormeBezierChunk(px,py,tx,ty,dest,inBezier,nbInterm,from,ps,ts,0.0);
+				ReFormeBezierChunk(px,py,tx,ty,dest,piece,from,ps,ts,0.0);
 				dest->BezierTo(nx,ny);
 				for (int i=ps+1;i>=pe;i--) {
 					dest->IntermBezierTo(from->descr_data[i].d.i.x,from->descr_data[i].d.i.y);
@@ -631,7 +934,7 @@ int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from)
 				float  tx,ty;
 				tx=(from->descr_data[ps+1].d.i.x+from->descr_data[ps].d.i.x)/2;
 				ty=(from->descr_data[ps+1].d.i.y+from->descr_data[ps].d.i.y)/2;
-				ReFormeBezierChunk(px,py,tx,ty,dest,inBezier,nbInterm,from,ps,ts,0.0);
+				ReFormeBezierChunk(px,py,tx,ty,dest,piece,from,ps,ts,0.0);
 				tx=(from->descr_data[pe+1].d.i.x+from->descr_data[pe+2].d.i.x)/2;
 				ty=(from->descr_data[pe+1].d.i.y+from->descr_data[pe+2].d.i.y)/2;
 				dest->BezierTo(tx,ty);
@@ -639,17 +942,17 @@ int          Shape::ReFormeBezierTo(int bord,int curBord,Path *dest,Path *from)
 					dest->IntermBezierTo(from->descr_data[i].d.i.x,from->descr_data[i].d.i.y);
 				}
 				dest->EndBezierTo();
-				ReFormeBezierChunk(tx,ty,nx,ny,dest,inBezier,nbInterm,from,pe,1.0,te);
+				ReFormeBezierChunk(tx,ty,nx,ny,dest,piece,from,pe,1.0,te);
 			}
 		}
 	}
 	return bord;
 }
-void               Shape::ReFormeBezierChunk(float px,float py,float nx,float ny,Path *dest,int inBezier,int nbInterm,Path* from,int p,float ts,float te)
+void               Shape::ReFormeBezierChunk(float px,float py,float nx,float ny,Path *dest,forme_piece* piece,Path* from,int p,float ts,float te)
 {
-	float bstx,bsty;
+	int   inBezier=piece->inBezier,nbInterm=piece->nbInterm;
+	float bstx=piece->bstx,bsty=piece->bsty;
 	float benx,beny;
-	from->PrevPoint(inBezier-1,bstx,bsty);
 	benx=from->descr_data[inBezier].d.b.x;
 	beny=from->descr_data[inBezier].d.b.y;
 		
@@ -7,7 +7,9 @@
  */
 
 #include "Shape.h"
+#include "Path.h"
 #include "LivarotDefs.h"
+#include "LivarotStats.h"
 #include "MyMath.h"
 
 
@@ -29,7 +31,9 @@ void              Shape::ForceToPolygon(void)
 }
 int               Shape::Reoriente(Shape* a)
 {
+	LIVAROT_SCOPE(stat_reoriente);
 	Reset(0,0);
+	MakeBackData(false);
 	if ( a->nbPt <= 1 || a->nbAr <= 1 ) return 0;
 	if ( a->Eulerian(true) == false ) return shape_input_err;
 
@@ -51,6 +55,10 @@ int               Shape::Reoriente(Shape* a)
 		if ( HasRasterData() ) swrData=(raster_data*)realloc(swrData,maxAr*sizeof(raster_data));
 	}
 	memcpy(aretes,a->aretes,nbAr*sizeof(dg_arete));
+	if ( a->HasBackData() ) {
+		MakeBackData(true);
+		memcpy(ebData,a->ebData,nbAr*sizeof(back_data));
+	}
 
 	MakePointData(true);
 	MakeEdgeData(true);
@@ -112,11 +120,123 @@ int               Shape::Reoriente(Shape* a)
 	type=shape_polygon;
 	return 0;
 }
+bool              Shape::IntersectionFree(void)
+{
+	if ( nbPt <= 1 || nbAr <= 1 ) return true;
+
+	// edges that vanish on the rounding grid can't be placed in the sweepline, whatever the provenance says
+	for (int i=0;i<nbAr;i++) {
+		if ( Round(pts[aretes[i].st].x) == Round(pts[aretes[i].en].x) && Round(pts[aretes[i].st].y) == Round(pts[aretes[i].en].y) ) return false;
+	}
+	if ( GetFlag(known_simple) ) return true;
+
+	// shamos-hoey: sweep the edges, and only test the ones that become neighbors in the sweepline
+	// any contact other than a shared endpoint counts as an intersection
+	ResetSweep();
+	for (int i=0;i<nbPt;i++) {
+		pData[i].rx=Round(pts[i].x);
+		pData[i].ry=Round(pts[i].y);
+	}
+	SortPointsRounded();
+	for (int i=0;i<nbAr;i++) {
+		eData[i].rdx=pData[aretes[i].en].rx-pData[aretes[i].st].rx;
+		eData[i].rdy=pData[aretes[i].en].ry-pData[aretes[i].st].ry;
+		swsData[i].misc=NULL;
+	}
+
+	SweepTreeList    tree;
+	SweepEventQueue  queue;
+SweepTree::CreateList(tree,nbAr);
+SweepEvent::CreateQueue(queue,0);
+
+	bool  simple=true;
+	for (int nPt=0;nPt<nbPt && simple;nPt++) {
+		// edges ending at nPt leave the sweepline; their neighbors become adjacent
+		for (int cb=pts[nPt].firstA;cb >= 0 && simple;cb=NextAt(nPt,cb)) {
+			if ( Other(nPt,cb) > nPt ) continue;
+			SweepTree*  node=(SweepTree*)swsData[cb].misc;
+			if ( node == NULL ) continue;
+			SweepTree*  nL=static_cast <SweepTree*> (node->leftElem);
+			SweepTree*  nR=static_cast <SweepTree*> (node->rightElem);
+			int   lB=(nL)?nL->bord:-1;
+			int   rB=(nR)?nR->bord:-1;
+			swsData[cb].misc=NULL;
+			node->Remove(tree,queue,true);
+			if ( lB >= 0 && rB >= 0 && EdgesTouch(lB,rB) ) simple=false;
+		}
+		// edges starting at nPt enter the sweepline; the first one is located in the tree, the others
+		// are sorted around it
+		SweepTree*  insertionNode=NULL;
+		for (int cb=pts[nPt].firstA;cb >= 0 && simple;cb=NextAt(nPt,cb)) {
+			if ( Other(nPt,cb) < nPt ) continue;
+			SweepTree*  node=SweepTree::AddInList(this,cb,1,nPt,tree,this);
+			swsData[cb].misc=node;
+			if ( tree.racine == NULL ) {
+				tree.racine=node;
+			} else if ( insertionNode ) {
+				node->InsertAt(tree,queue,this,insertionNode,nPt,true);
+			} else {
+				SweepTree*  insertL=NULL;
+				SweepTree*  insertR=NULL;
+				int insertion=tree.racine->Find(pData[nPt].rx,pData[nPt].ry,node,insertL,insertR,true);
+				AVLTree* tempR=static_cast <AVLTree*>(tree.racine);
+				node->AVLTree::Insert(tempR,insertion,static_cast <AVLTree*> (insertL),static_cast <AVLTree*> (insertR),true);
+				tree.racine=static_cast <SweepTree*> (tempR);
+			}
+			if ( insertionNode == NULL ) insertionNode=node;
+			SweepTree*  nL=static_cast <SweepTree*> (node->leftElem);
+			SweepTree*  nR=static_cast <SweepTree*> (node->rightElem);
+			if ( nL && EdgesTouch(nL->bord,cb) ) simple=false;
+			if ( nR && EdgesTouch(cb,nR->bord) ) simple=false;
+		}
+	}
+
+SweepTree::DestroyList(tree);
+SweepEvent::DestroyQueue(queue);
+	CleanupSweep();
+
+	return simple;
+}
+bool              Shape::EdgesTouch(int ea,int eb)
+{
+	int    as=aretes[ea].st,ae=aretes[ea].en;
+	int    bs=aretes[eb].st,be=aretes[eb].en;
+	if ( ( as == bs && ae == be ) || ( as == be && ae == bs ) ) return true;
+
+	// the coordinates are on the rounding grid, so these products are exact
+	if ( as == bs || as == be || ae == bs || ae == be ) {
+		// shared endpoint: only a collinear overlap counts
+		int    c=( as == bs || as == be )?as:ae;
+		int    ao=(c == as)?ae:as;
+		int    bo=(c == bs)?be:bs;
+		double ux=pData[ao].rx-pData[c].rx,uy=pData[ao].ry-pData[c].ry;
+		double vx=pData[bo].rx-pData[c].rx,vy=pData[bo].ry-pData[c].ry;
+		return ( ux*vy-uy*vx == 0 && ux*vx+uy*vy > 0 );
+	}
+
+	double  ax=pData[as].rx,ay=pData[as].ry,bx=pData[ae].rx,by=pData[ae].ry;
+	double  cx=pData[bs].rx,cy=pData[bs].ry,dx=pData[be].rx,dy=pData[be].ry;
+	double  d1=(dx-cx)*(ay-cy)-(dy-cy)*(ax-cx);
+	double  d2=(dx-cx)*(by-cy)-(dy-cy)*(bx-cx);
+	double  d3=(bx-ax)*(cy-ay)-(by-ay)*(cx-ax);
+	double  d4=(bx-ax)*(dy-ay)-(by-ay)*(dx-ax);
+	if ( ( ( d1 > 0 && d2 < 0 ) || ( d1 < 0 && d2 > 0 ) ) && ( ( d3 > 0 && d4 < 0 ) || ( d3 < 0 && d4 > 0 ) ) ) return true;
+	// contacts: an endpoint lying on the other edge
+	if ( d1 == 0 && ax >= fmin(cx,dx) && ax <= fmax(cx,dx) && ay >= fmin(cy,dy) && ay <= fmax(cy,dy) ) return true;
+	if ( d2 == 0 && bx >= fmin(cx,dx) && bx <= fmax(cx,dx) && by >= fmin(cy,dy) && by <= fmax(cy,dy) ) return true;
+	if ( d3 == 0 && cx >= fmin(ax,bx) && cx <= fmax(ax,bx) && cy >= fmin(ay,by) && cy <= fmax(ay,by) ) return true;
+	if ( d4 == 0 && dx >= fmin(ax,bx) && dx <= fmax(ax,bx) && dy >= fmin(ay,by) && dy <= fmax(ay,by) ) return true;
+	return false;
+}
 int               Shape::ConvertToShape(Shape* a,FillRule directed,bool invert)
 {
+	LIVAROT_SCOPE(stat_convert_to_shape);
 	Reset(0,0);
 	if ( a->nbPt <= 1 || a->nbAr <= 1 ) return 0;
 	if ( a->Eulerian(true) == false ) return shape_input_err;
+	// the result has about as many points and edges as a: make room for them now, rather than
+	// growing the arrays and their side data one doubling at a time during the sweep
+	Reset(a->nbPt,a->nbAr);
 
 	a->ResetSweep();
 
@@ -184,6 +304,7 @@ SweepEvent::CreateQueue(sEvts,a->nbAr);
 	
 	int    curAPt=0;
 	
+	LIVAROT_BEGIN(stat_sweep);
 	while ( curAPt < a->nbPt || sEvts.nbEvt > 0 ) {
 /*		if ( nbPt > 0 && pts[nbPt-1].y >= 250.4 && pts[nbPt-1].y <= 250.6 ) {
 			for (int i=0;i<sEvts.nbEvt;i++) {
@@ -226,6 +347,7 @@ SweepEvent::ExtractFromQueue(intersL,intersR,ptX,ptY,ptL,ptR,sEvts);
 			isIntersection=false;
 		}
 
+		LIVAROT_COUNT((isIntersection)?stat_intersections:stat_sweep_points,1);
 		if ( isIntersection == false ) {
 			if ( ptSh->pts[nPt].dI == 0 && ptSh->pts[nPt].dO == 0 ) continue;
 		}
@@ -497,6 +619,8 @@ SweepEvent::ExtractFromQueue(intersL,intersR,ptX,ptY,ptL,ptR,sEvts);
 		shapeHead=NULL;
 	}
 	
+	LIVAROT_END(stat_sweep);
+
 	if ( chgts ) free(chgts);
 	chgts=NULL;
 	nbChgt=maxChgt=0;
@@ -636,14 +760,31 @@ SweepEvent::DestroyQueue(sEvts);
 	return 0;
 }
 
+int               Shape::ConvertToShape(Path** paths,int first,int count,FillRule directed,Shape* graph)
+{
+	if ( paths == NULL || count <= 0 ) return shape_input_err;
+	Shape*   temp=(graph)?graph:new Shape;
+	if ( temp == this ) return shape_input_err;
+	// one Reset() for all the paths: the Fill()s below only append
+	int      nbP=0;
+	for (int i=first;i<first+count;i++) nbP+=paths[i]->nbPt;
+	temp->Reset(nbP,nbP);
+	for (int i=first;i<first+count;i++) paths[i]->Fill(temp,i,true);
+	int      err=ConvertToShape(temp,directed);
+	if ( graph == NULL ) delete temp;
+	return err;
+}
+
 int               Shape::Booleen(Shape* a,Shape* b,BooleanOp mod)
 {
+	LIVAROT_SCOPE(stat_booleen);
 	if ( a == b || a == NULL || b == NULL ) return shape_input_err;
 	Reset(0,0);
 	if ( a->nbPt <= 1 || a->nbAr <= 1 ) return 0;
 	if ( b->nbPt <= 1 || b->nbAr <= 1 ) return 0;
 	if ( a->type != shape_polygon ) return shape_input_err;
 	if ( b->type != shape_polygon ) return shape_input_err;
+	Reset(a->nbPt+b->nbPt,a->nbAr+b->nbAr); // same as in ConvertToShape()
 
 	a->ResetSweep();
 	b->ResetSweep();
@@ -742,6 +883,7 @@ SweepEvent::CreateQueue(sEvts,a->nbAr+b->nbAr);
 	int    curAPt=0;
 	int    curBPt=0;
 	
+	LIVAROT_BEGIN(stat_sweep);
 	while ( curAPt < a->nbPt || curBPt < b->nbPt || sEvts.nbEvt > 0 ) {
 /*		for (int i=0;i<sEvts.nbEvt;i++) {
 			printf("%f %f %i %i\n",sEvts.events[i].posx,sEvts.events[i].posy,sEvts.events[i].leftSweep->bord,sEvts.events[i].rightSweep->bord);
@@ -837,6 +979,7 @@ SweepEvent::ExtractFromQueue(intersL,intersR,ptX,ptY,ptL,ptR,sEvts);
 			isIntersection=false;
 		}
 
+		LIVAROT_COUNT((isIntersection)?stat_intersections:stat_sweep_points,1);
 		if ( isIntersection == false ) {
 			if ( ptSh->pts[nPt].dI == 0 && ptSh->pts[nPt].dO == 0 ) continue;
 		}
@@ -1120,6 +1263,8 @@ SweepEvent::ExtractFromQueue(intersL,intersR,ptX,ptY,ptL,ptR,sEvts);
 		shapeHead=NULL;
 	}
 	
+	LIVAROT_END(stat_sweep);
+
 	if ( chgts ) free(chgts);
 	chgts=NULL;
 	nbChgt=maxChgt=0;
@@ -1638,6 +1783,7 @@ void              Shape::AssemblePoints(Shape* a)
 }
 void              Shape::AssembleAretes(void)
 {
+	LIVAROT_SCOPE(stat_assemble_aretes);
 	for (int i=0;i<nbPt;i++) {
 		if ( pts[i].dI+pts[i].dO == 2 ) {
 			int cb,cc;
@@ -1755,6 +1901,7 @@ void              Shape::AssembleAretes(void)
 }
 void         Shape::GetWindings(Shape* a,Shape* b,BooleanOp mod,bool brutal)
 {
+	LIVAROT_SCOPE(stat_get_windings);
 	// preparation du parcours
 	for (int i=0;i<nbAr;i++) {
 		swdData[i].misc=0;
@@ -2120,8 +2267,99 @@ bool              Shape::TesteAdjacency(Shape* a,int no,float atx,float aty,int
 	}*/
 	return false;
 }
+/*
+ * batched version of TesteAdjacency(..,false), for the runs of points CheckAdjacencies() walks along one edge:
+ * the edge is loaded once, a point too far from its line is rejected after one product, and the others go
+ * through the same products as TesteAdjacency() without branches
+ */
+void              Shape::PrepareAdjacency(Shape* a,int no,adjacency_edge &e)
+{
+	e.stPt=a->swsData[no].stPt;
+	e.enPt=a->swsData[no].enPt;
+	e.stx=a->pData[a->aretes[no].st].rx;
+	e.sty=a->pData[a->aretes[no].st].ry;
+	e.dx=a->eData[no].rdx;
+	e.dy=a->eData[no].rdy;
+	e.length=a->eData[no].length;
+	e.isqlength=a->eData[no].isqlength;
+}
+void              Shape::TesteAdjacencies(adjacency_edge &e,int st,int en,char* hits)
+{
+	// scaling by a power of 2 is exact, so these are HalfRound(0.505) and the IHalfRound(..) < 3 test,
+	// without the calls to ldexpf
+	double  rad=0.505f/32;
+	for (int n=st;n<en;n++) {
+		double  diffx=pts[n].x-e.stx;
+		double  diffy=pts[n].y-e.sty;
+		float   dist=(e.dx*diffy-e.dy*diffx)*e.isqlength;
+		if ( dist <= -3.0f/32 || dist >= 3.0f/32 ) {
+			hits[n-st]=0;
+			continue;
+		}
+		double  di1=e.dx*(diffy-rad)-e.dy*(diffx-rad);
+		double  di2=e.dx*(diffy+rad)-e.dy*(diffx+rad);
+		double  di3=e.dx*(diffy-rad)-e.dy*(diffx+rad);
+		double  di4=e.dx*(diffy+rad)-e.dy*(diffx-rad);
+		double  t=diffx*e.dx+diffy*e.dy;
+		bool    adjacent=( ( di1 < 0 ) & ( di2 > 0 ) ) | ( ( di1 > 0 ) & ( di2 < 0 ) )
+		                | ( ( di3 < 0 ) & ( di4 > 0 ) ) | ( ( di3 > 0 ) & ( di4 < 0 ) );
+		hits[n-st]=adjacent & ( t > 0 ) & ( t < e.length );
+	}
+	if ( e.stPt >= st && e.stPt < en ) hits[e.stPt-st]=0;
+	if ( e.enPt >= st && e.enPt < en ) hits[e.enPt-st]=0;
+}
+int               Shape::AdjacentRun(adjacency_edge &e,int from,int nb,int dir)
+{
+	// most runs stop at the first point, so the blocks start with one point and double up to adjacency_block
+	char  hits[adjacency_block];
+	int   done=0,size=1;
+	while ( done < nb ) {
+		int  bl=nb-done;
+		if ( bl > size ) bl=size;
+		if ( size < adjacency_block ) size*=2;
+		int  cur=from+dir*done;
+		if ( dir > 0 ) {
+			TesteAdjacencies(e,cur,cur+bl,hits);
+			for (int i=0;i<bl;i++) if ( hits[i] == 0 ) return done+i;
+		} else {
+			TesteAdjacencies(e,cur-bl+1,cur+1,hits);
+			for (int i=0;i<bl;i++) if ( hits[bl-1-i] == 0 ) return done+i;
+		}
+		done+=bl;
+	}
+	return nb;
+}
+bool              Shape::AdjacentSpan(adjacency_edge &e,int st,int en,int &first,int &last)
+{
+	char  hits[adjacency_block];
+	first=en;
+	last=st-1;
+	for (int cur=st;cur<en;cur+=adjacency_block) {
+		int  bl=en-cur;
+		if ( bl > adjacency_block ) bl=adjacency_block;
+		TesteAdjacencies(e,cur,cur+bl,hits);
+		for (int i=0;i<bl;i++) {
+			if ( hits[i] ) {
+				if ( cur+i < first ) first=cur+i;
+				last=cur+i;
+			}
+		}
+	}
+	return ( first <= last );
+}
+void              Shape::MergeRnd(sweep_src_data &d,int first,int last,int lastChgtPt)
+{
+	if ( d.leftRnd < lastChgtPt ) {
+		d.leftRnd=first;
+		d.rightRnd=last;
+	} else {
+		if ( first < d.leftRnd ) d.leftRnd=first;
+		if ( last > d.rightRnd ) d.rightRnd=last;
+	}
+}
 void              Shape::CheckAdjacencies(int lastPointNo,int lastChgtPt,Shape *shapeHead,int edgeHead)
 {
+	adjacency_edge  adj;
 	for (int cCh=0;cCh<nbChgt;cCh++) {
 		int   chLeN=chgts[cCh].ptNo;
 		int   chRiN=chgts[cCh].ptNo;
@@ -2133,14 +2371,11 @@ void              Shape::CheckAdjacencies(int lastPointNo,int lastChgtPt,Shape *
 			if ( lftN < chLeN ) chLeN=lftN;
 			if ( rgtN > chRiN ) chRiN=rgtN;
 //			for (int n=lftN;n<=rgtN;n++) CreateIncidence(lS,lB,n);
-			for (int n=lftN-1;n>=lastChgtPt;n--) {
-				if ( TesteAdjacency(lS,lB,pts[n].x,pts[n].y,n,false) == false ) break;
-				lS->swsData[lB].leftRnd=n;
-			}
-			for (int n=rgtN+1;n<lastPointNo;n++) {
-				if ( TesteAdjacency(lS,lB,pts[n].x,pts[n].y,n,false) == false ) break;
-				lS->swsData[lB].rightRnd=n;
-			}
+			PrepareAdjacency(lS,lB,adj);
+			int   nb=AdjacentRun(adj,lftN-1,lftN-lastChgtPt,-1);
+			if ( nb > 0 ) lS->swsData[lB].leftRnd=lftN-nb;
+			nb=AdjacentRun(adj,rgtN+1,lastPointNo-rgtN-1,1);
+			if ( nb > 0 ) lS->swsData[lB].rightRnd=rgtN+nb;
 		}
 		if ( chgts[cCh].osrc ) {
 			Shape* rS=chgts[cCh].osrc;
@@ -2150,14 +2385,11 @@ void              Shape::CheckAdjacencies(int lastPointNo,int lastChgtPt,Shape *
 			if ( lftN < chLeN ) chLeN=lftN;
 			if ( rgtN > chRiN ) chRiN=rgtN;
 //			for (int n=lftN;n<=rgtN;n++) CreateIncidence(rS,rB,n);
-			for (int n=lftN-1;n>=lastChgtPt;n--) {
-				if ( TesteAdjacency(rS,rB,pts[n].x,pts[n].y,n,false) == false ) break;
-				rS->swsData[rB].leftRnd=n;
-			}
-			for (int n=rgtN+1;n<lastPointNo;n++) {
-				if ( TesteAdjacency(rS,rB,pts[n].x,pts[n].y,n,false) == false ) break;
-				rS->swsData[rB].rightRnd=n;
-			}
+			PrepareAdjacency(rS,rB,adj);
+			int   nb=AdjacentRun(adj,lftN-1,lftN-lastChgtPt,-1);
+			if ( nb > 0 ) rS->swsData[rB].leftRnd=lftN-nb;
+			nb=AdjacentRun(adj,rgtN+1,lastPointNo-rgtN-1,1);
+			if ( nb > 0 ) rS->swsData[rB].rightRnd=rgtN+nb;
 		}
 		if ( chgts[cCh].lSrc ) {
 			if ( chgts[cCh].lSrc->swsData[chgts[cCh].lBrd].leftRnd < lastChgtPt ) {
@@ -2167,27 +2399,15 @@ void              Shape::CheckAdjacencies(int lastPointNo,int lastChgtPt,Shape *
 				
 				do {
 					hit=false;
-					for (int n=chRiN;n>=chLeN;n--) {
-						if ( TesteAdjacency(nSrc,nBrd,pts[n].x,pts[n].y,n,false) ) {
-							if ( nSrc->swsData[nBrd].leftRnd < lastChgtPt ) {
-								nSrc->swsData[nBrd].leftRnd=n;
-								nSrc->swsData[nBrd].rightRnd=n;
-							} else {
-								if ( n < nSrc->swsData[nBrd].leftRnd ) nSrc->swsData[nBrd].leftRnd=n;
-								if ( n > nSrc->swsData[nBrd].rightRnd ) nSrc->swsData[nBrd].rightRnd=n;
-							}
-							hit=true;
-						}
+					PrepareAdjacency(nSrc,nBrd,adj);
+					int   first,last;
+					if ( AdjacentSpan(adj,chLeN,chRiN+1,first,last) ) {
+						MergeRnd(nSrc->swsData[nBrd],first,last,lastChgtPt);
+						hit=true;
 					}
-					for (int n=chLeN-1;n>=lastChgtPt;n--) {
-						if ( TesteAdjacency(nSrc,nBrd,pts[n].x,pts[n].y,n,false) == false ) break;
-						if ( nSrc->swsData[nBrd].leftRnd < lastChgtPt ) {
-							nSrc->swsData[nBrd].leftRnd=n;
-							nSrc->swsData[nBrd].rightRnd=n;
-						} else { 
-							if ( n < nSrc->swsData[nBrd].leftRnd ) nSrc->swsData[nBrd].leftRnd=n;
-							if ( n > nSrc->swsData[nBrd].rightRnd ) nSrc->swsData[nBrd].rightRnd=n;
-						}
+					int   nb=AdjacentRun(adj,chLeN-1,chLeN-lastChgtPt,-1);
+					if ( nb > 0 ) {
+						MergeRnd(nSrc->swsData[nBrd],chLeN-nb,chLeN-1,lastChgtPt);
 						hit=true;
 					}
 					if ( hit ) {
@@ -2210,27 +2430,15 @@ void              Shape::CheckAdjacencies(int lastPointNo,int lastChgtPt,Shape *
 				bool hit;
 				do {
 					hit=false;
-					for (int n=chLeN;n<=chRiN;n++) {
-						if ( TesteAdjacency(nSrc,nBrd,pts[n].x,pts[n].y,n,false) ) {
-							if ( nSrc->swsData[nBrd].leftRnd < lastChgtPt ) {
-								nSrc->swsData[nBrd].leftRnd=n;
-								nSrc->swsData[nBrd].rightRnd=n;
-							} else {
-								if ( n < nSrc->swsData[nBrd].leftRnd ) nSrc->swsData[nBrd].leftRnd=n;
-								if ( n > nSrc->swsData[nBrd].rightRnd ) nSrc->swsData[nBrd].rightRnd=n;
-							}
-							hit=true;
-						}
+					PrepareAdjacency(nSrc,nBrd,adj);
+					int   first,last;
+					if ( AdjacentSpan(adj,chLeN,chRiN+1,first,last) ) {
+						MergeRnd(nSrc->swsData[nBrd],first,last,lastChgtPt);
+						hit=true;
 					}
-					for (int n=chRiN+1;n<lastPointNo;n++) {
-						if ( TesteAdjacency(nSrc,nBrd,pts[n].x,pts[n].y,n,false) == false ) break;
-						if ( nSrc->swsData[nBrd].leftRnd < lastChgtPt ) {
-							nSrc->swsData[nBrd].leftRnd=n;
-							nSrc->swsData[nBrd].rightRnd=n;
-						} else {
-							if ( n < nSrc->swsData[nBrd].leftRnd ) nSrc->swsData[nBrd].leftRnd=n;
-							if ( n > nSrc->swsData[nBrd].rightRnd ) nSrc->swsData[nBrd].rightRnd=n;
-						}
+					int   nb=AdjacentRun(adj,chRiN+1,lastPointNo-chRiN-1,1);
+					if ( nb > 0 ) {
+						MergeRnd(nSrc->swsData[nBrd],chRiN+1,chRiN+nb,lastChgtPt);
 						hit=true;
 					}
 					if ( hit ) {
@@ -8,6 +8,7 @@
 
 #include "Shape.h"
 #include "LivarotDefs.h"
+#include "LivarotStats.h"
 #include "MyMath.h"
 
 SweepEvent::SweepEvent()
@@ -75,6 +76,7 @@ SweepEvent*     SweepEvent::AddInQueue(SweepTree* iLeft,SweepTree* iRight,float
 	if ( queue.nbEvt >= queue.maxEvt ) return NULL;
 	int  n=queue.nbEvt++;
 	queue.events[n].MakeNew(iLeft,iRight,px,py,itl,itr);
+	LIVAROT_COUNT(stat_sweep_events,1);
 
 	if ( iLeft->src->aretes[iLeft->bord].st < iLeft->src->aretes[iLeft->bord].en ) {
 		iLeft->src->pData[iLeft->src->aretes[iLeft->bord].en].pending++;
@@ -0,0 +1,286 @@
+/*
+ *  InkpadSample.cpp
+ *  nlivarot benchmark
+ *
+ *  just enough of the bplist00 format to walk an NSKeyedArchiver archive:
+ *  the trailer gives the offset table, objects are decoded lazily by index,
+ *  and archive references (UIDs) are indices into the "$objects" array
+ *
+ */
+
+#include "InkpadSample.h"
+#include "Path.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+class BPList {
+public:
+	unsigned char*  data;
+	long            size;
+	int             offSize,refSize;
+	uint64_t        nbObj,topObj,offTable;
+
+	int64_t*        archive; // $objects, as bplist object indices
+	int             nbArchive;
+
+	BPList(void) {data=NULL;size=0;archive=NULL;nbArchive=0;};
+	~BPList(void) {if ( data ) free(data);if ( archive ) free(archive);};
+
+	bool            Load(const char* fileName);
+
+	// all of these return false / -1 on anything malformed
+	int             Marker(int64_t obj,uint64_t &len,const unsigned char* &payload);
+	int64_t         DictValue(int64_t obj,const char* key);
+	int             ArrayItems(int64_t obj,int64_t* &items); // malloc'ed, caller frees
+	int64_t         UID(int64_t obj);
+	bool            Integer(int64_t obj,int64_t &val);
+	bool            Bool(int64_t obj,bool &val);
+
+	int64_t         Resolve(int64_t uidObj) {int64_t u=UID(uidObj);return ( u >= 0 && u < nbArchive )?archive[u]:-1;};
+	int64_t         ArchiveValue(int64_t obj,const char* key) {int64_t v=DictValue(obj,key);return ( v >= 0 )?Resolve(v):-1;};
+
+private:
+	uint64_t        ReadBE(const unsigned char* p,int n) {uint64_t r=0;for (int i=0;i<n;i++) r=(r<<8)|p[i];return r;};
+	int64_t         Ref(const unsigned char* p) {return (int64_t)ReadBE(p,refSize);};
+	bool            KeyIs(int64_t obj,const char* key);
+};
+
+bool            BPList::Load(const char* fileName)
+{
+	FILE*  f=fopen(fileName,"rb");
+	if ( f == NULL ) return false;
+	fseek(f,0,SEEK_END);
+	size=ftell(f);
+	fseek(f,0,SEEK_SET);
+	if ( size < 40 ) {
+		fclose(f);
+		return false;
+	}
+	data=(unsigned char*)malloc(size);
+	long  got=fread(data,1,size,f);
+	fclose(f);
+	if ( got != size || memcmp(data,"bplist00",8) != 0 ) return false;
+
+	const unsigned char*  trailer=data+size-32;
+	offSize=trailer[6];
+	refSize=trailer[7];
+	nbObj=ReadBE(trailer+8,8);
+	topObj=ReadBE(trailer+16,8);
+	offTable=ReadBE(trailer+24,8);
+	if ( offSize < 1 || offSize > 8 || refSize < 1 || refSize > 8 ) return false;
+	if ( offTable+nbObj*offSize > (uint64_t)size ) return false;
+
+	int64_t  objects=DictValue(topObj,"$objects");
+	if ( objects < 0 ) return false;
+	nbArchive=ArrayItems(objects,archive);
+	return ( nbArchive > 0 );
+}
+int             BPList::Marker(int64_t obj,uint64_t &len,const unsigned char* &payload)
+{
+	if ( obj < 0 || (uint64_t)obj >= nbObj ) return -1;
+	uint64_t  off=ReadBE(data+offTable+obj*offSize,offSize);
+	if ( off >= (uint64_t)size ) return -1;
+	const unsigned char*  p=data+off;
+	int   marker=p[0];
+	len=marker&0x0F;
+	payload=p+1;
+	int   type=marker>>4;
+	if ( type == 0x1 || type == 0x2 ) {
+		len=1<<len;
+	} else if ( type == 0x8 ) {
+		len=len+1;
+	} else if ( type >= 0x4 && len == 0x0F ) {
+		// the real length follows as an int object
+		int  lenBytes=1<<(p[1]&0x0F);
+		if ( (p[1]>>4) != 0x1 || lenBytes > 8 ) return -1;
+		len=ReadBE(p+2,lenBytes);
+		payload=p+2+lenBytes;
+	}
+	if ( payload+len*((type == 0xA)?refSize:(type == 0xD)?2*refSize:(type == 0x6)?2:1) > data+size ) return -1;
+	return marker;
+}
+bool            BPList::KeyIs(int64_t obj,const char* key)
+{
+	uint64_t              len;
+	const unsigned char*  p;
+	int  m=Marker(obj,len,p);
+	if ( (m>>4) != 0x5 ) return false;
+	return ( strlen(key) == len && memcmp(p,key,len) == 0 );
+}
+int64_t         BPList::DictValue(int64_t obj,const char* key)
+{
+	uint64_t              len;
+	const unsigned char*  p;
+	int  m=Marker(obj,len,p);
+	if ( m < 0 || (m>>4) != 0xD ) return -1;
+	for (uint64_t i=0;i<len;i++) {
+		if ( KeyIs(Ref(p+i*refSize),key) ) return Ref(p+(len+i)*refSize);
+	}
+	return -1;
+}
+int             BPList::ArrayItems(int64_t obj,int64_t* &items)
+{
+	items=NULL;
+	uint64_t              len;
+	const unsigned char*  p;
+	int  m=Marker(obj,len,p);
+	if ( m < 0 || (m>>4) != 0xA ) return -1;
+	items=(int64_t*)malloc((len+1)*sizeof(int64_t));
+	for (uint64_t i=0;i<len;i++) items[i]=Ref(p+i*refSize);
+	return (int)len;
+}
+int64_t         BPList::UID(int64_t obj)
+{
+	uint64_t              len;
+	const unsigned char*  p;
+	int  m=Marker(obj,len,p);
+	if ( m < 0 || (m>>4) != 0x8 ) return -1;
+	return (int64_t)ReadBE(p,len);
+}
+bool            BPList::Integer(int64_t obj,int64_t &val)
+{
+	uint64_t              len;
+	const unsigned char*  p;
+	int  m=Marker(obj,len,p);
+	if ( m < 0 || (m>>4) != 0x1 ) return false;
+	val=(int64_t)ReadBE(p,len);
+	return true;
+}
+bool            BPList::Bool(int64_t obj,bool &val)
+{
+	uint64_t              len;
+	const unsigned char*  p;
+	int  m=Marker(obj,len,p);
+	if ( m != 0x08 && m != 0x09 ) return false;
+	val=( m == 0x09 );
+	return true;
+}
+
+/*
+ * WDBezierNode stores in/anchor/out as 6 big-endian floats; the conversion mirrors
+ * WDPath::convertToLivarotPath
+ */
+static float    SwappedFloat(const unsigned char* p)
+{
+	uint32_t  v=((uint32_t)p[0]<<24)|((uint32_t)p[1]<<16)|((uint32_t)p[2]<<8)|(uint32_t)p[3];
+	float     r;
+	memcpy(&r,&v,sizeof(float));
+	return r;
+}
+static int      AddSubpath(BPList &pl,int64_t pathObj,Path* dest)
+{
+	int64_t  nodesObj=pl.ArchiveValue(pathObj,"WDNodesKey");
+	if ( nodesObj < 0 ) return 0;
+	int64_t  itemsObj=pl.DictValue(nodesObj,"NS.objects");
+	int64_t* items=NULL;
+	int      nbNode=pl.ArrayItems(itemsObj,items);
+	if ( nbNode <= 0 ) {
+		if ( items ) free(items);
+		return 0;
+	}
+	bool     closed=false;
+	pl.Bool(pl.DictValue(pathObj,"WDClosedKey"),closed);
+
+	float*   pts=(float*)malloc(6*nbNode*sizeof(float));
+	int      nbOk=0;
+	for (int i=0;i<nbNode;i++) {
+		int64_t               nodeObj=pl.Resolve(items[i]);
+		int64_t               bytesObj=pl.DictValue(nodeObj,"WDPointArrayKey");
+		uint64_t              len;
+		const unsigned char*  p;
+		int  m=pl.Marker(bytesObj,len,p);
+		if ( (m>>4) != 0x4 || len < 24 ) continue;
+		for (int j=0;j<6;j++) pts[6*nbOk+j]=SwappedFloat(p+4*j);
+		nbOk++;
+	}
+	free(items);
+	if ( nbOk <= 0 ) {
+		free(pts);
+		return 0;
+	}
+
+	int   nbStep=(closed)?nbOk+1:nbOk;
+	for (int i=0;i<nbStep;i++) {
+		float*  cur=pts+6*(i%nbOk);
+		if ( i == 0 ) {
+			dest->MoveTo(cur[2],cur[3]);
+		} else {
+			float*  prev=pts+6*((i-1)%nbOk);
+			if ( prev[2] == prev[4] && prev[3] == prev[5] && cur[0] == cur[2] && cur[1] == cur[3] ) {
+				dest->LineTo(cur[2],cur[3]);
+			} else {
+				dest->CubicTo(cur[2],cur[3],3*(prev[4]-prev[2]),3*(prev[5]-prev[3]),3*(cur[2]-cur[0]),3*(cur[3]-cur[1]));
+			}
+		}
+	}
+	if ( closed ) dest->Close();
+	free(pts);
+	return nbOk;
+}
+
+int             LoadInkpadPaths(const char* fileName,sample_path* &paths)
+{
+	paths=NULL;
+	BPList  pl;
+	if ( pl.Load(fileName) == false ) return -1;
+
+	// subpaths of a compound path are archived as WDPath too; skip them at top level
+	bool*   isSubpath=(bool*)calloc(pl.nbArchive,sizeof(bool));
+	for (int i=0;i<pl.nbArchive;i++) {
+		int64_t  subs=pl.ArchiveValue(pl.archive[i],"WDSubpathsKey");
+		if ( subs < 0 ) continue;
+		int64_t* items=NULL;
+		int      nb=pl.ArrayItems(pl.DictValue(subs,"NS.objects"),items);
+		for (int j=0;j<nb;j++) {
+			int64_t  u=pl.UID(items[j]);
+			if ( u >= 0 && u < pl.nbArchive ) isSubpath[u]=true;
+		}
+		if ( items ) free(items);
+	}
+
+	int     nbPath=0,maxPath=0;
+	for (int i=0;i<pl.nbArchive;i++) {
+		if ( isSubpath[i] ) continue;
+		int64_t  obj=pl.archive[i];
+		int64_t  subs=pl.ArchiveValue(obj,"WDSubpathsKey");
+		bool     isPath=( pl.DictValue(obj,"WDNodesKey") >= 0 );
+		if ( isPath == false && subs < 0 ) continue;
+
+		Path*    dest=new Path;
+		int      nbNode=0;
+		if ( isPath ) {
+			nbNode=AddSubpath(pl,obj,dest);
+		} else {
+			int64_t* items=NULL;
+			int      nb=pl.ArrayItems(pl.DictValue(subs,"NS.objects"),items);
+			for (int j=0;j<nb;j++) nbNode+=AddSubpath(pl,pl.Resolve(items[j]),dest);
+			if ( items ) free(items);
+		}
+		if ( nbNode <= 0 ) {
+			delete dest;
+			continue;
+		}
+		dest->ConvertWithBackData(1);
+
+		int64_t  rule=0;
+		pl.Integer(pl.DictValue(obj,"WDFillRuleKey"),rule);
+		if ( nbPath >= maxPath ) {
+			maxPath=2*nbPath+1;
+			paths=(sample_path*)realloc(paths,maxPath*sizeof(sample_path));
+		}
+		paths[nbPath].path=dest;
+		paths[nbPath].rule=( rule == 1 )?fill_oddEven:fill_nonZero;
+		paths[nbPath].nbNode=nbNode;
+		nbPath++;
+	}
+	free(isSubpath);
+	return nbPath;
+}
+void            FreeInkpadPaths(sample_path* paths,int nb)
+{
+	for (int i=0;i<nb;i++) delete paths[i].path;
+	if ( paths ) free(paths);
+}
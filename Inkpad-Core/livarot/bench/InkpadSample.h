@@ -0,0 +1,30 @@
+/*
+ *  InkpadSample.h
+ *  nlivarot benchmark
+ *
+ *  pulls the path geometry out of an .inkpad document (a keyed archive stored as a binary
+ *  plist) without Foundation, so the benchmark can run on the real documents on Linux
+ *
+ */
+
+#ifndef my_inkpad_sample
+#define my_inkpad_sample
+
+#include <stdint.h>
+#include "LivarotDefs.h"
+
+class Path;
+
+typedef struct sample_path {
+	Path*      path;      // already converted with ConvertWithBackData(1), like WDPathfinder does
+	FillRule   rule;
+	int        nbNode;
+} sample_path;
+
+// returns the number of paths found (>= 0), or -1 if the file isn't a readable document
+// compound paths are returned as one Path holding all their subpaths
+// free the result with FreeInkpadPaths()
+int     LoadInkpadPaths(const char* fileName,sample_path* &paths);
+void    FreeInkpadPaths(sample_path* paths,int nb);
+
+#endif
@@ -0,0 +1,362 @@
+/*
+ *  LivarotBench.cpp
+ *  nlivarot benchmark
+ *
+ *  times the pipeline WDPathfinder drives (Convert, Fill, ConvertToShape, Booleen, ConvertToForme)
+ *  plus MakeOffset, on generated workloads and on the paths of the .inkpad documents in Samples
+ *
+ *  usage: livarot_bench [-n iterations] [-w workload] [-s samplesDir] [-t trace.json]
+ *  every call is one latency sample; the report gives p50/p99 per operation, the throughput
+ *  in calls/s and in input edges/s, and the peak RSS of the process at the end
+ *  -t only works in a LIVAROT_STATS=1 build
+ *
+ */
+
+#include "Path.h"
+#include "Shape.h"
+#include "LivarotStats.h"
+#include "InkpadSample.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/resource.h>
+
+enum {
+	op_convert        =0,
+	op_fill           =1,
+	op_convert_shape  =2,
+	op_booleen        =3,
+	op_convert_forme  =4,
+	op_make_offset    =5,
+	op_nb             =6
+};
+static const char* opNames[op_nb]={"Convert","Fill","ConvertToShape","Booleen","ConvertToForme","MakeOffset"};
+
+typedef struct op_samples {
+	int        nb,max;
+	double*    us;
+	double     edges;   // input size summed over all the calls
+} op_samples;
+
+typedef struct workload {
+	char       name[64];
+	int        nbPath;
+	Path**     a;       // operand paths, description only (Convert is part of the timing)
+	Path**     b;       // second operand for Booleen, same count as a
+	FillRule*  rule;
+} workload;
+
+static double   NowUS(void)
+{
+	struct timespec  ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ((double)ts.tv_sec)*1e6+((double)ts.tv_nsec)*1e-3;
+}
+static void     AddSample(op_samples &s,double us,int edges)
+{
+	if ( s.nb >= s.max ) {
+		s.max=2*s.nb+16;
+		s.us=(double*)realloc(s.us,s.max*sizeof(double));
+	}
+	s.us[s.nb++]=us;
+	s.edges+=edges;
+}
+static int      CmpDouble(const void* a,const void* b)
+{
+	double  da=*(const double*)a,db=*(const double*)b;
+	if ( da < db ) return -1;
+	if ( da > db ) return 1;
+	return 0;
+}
+static double   Percentile(op_samples &s,double p)
+{
+	if ( s.nb <= 0 ) return 0;
+	int  i=(int)ceil(p*s.nb)-1;
+	if ( i < 0 ) i=0;
+	if ( i >= s.nb ) i=s.nb-1;
+	return s.us[i];
+}
+
+/*
+ * generated workloads
+ * all coordinates stay within a few thousand units, like a document
+ */
+static float    Rnd(float l,float h)
+{
+	return l+(h-l)*((float)rand()/(float)RAND_MAX);
+}
+static void     AddCircle(Path* p,float cx,float cy,float r)
+{
+	float  k=0.5522847f*r;
+	p->MoveTo(cx-r,cy);
+	p->CubicTo(cx,cy-r,0,-3*k,3*k,0);
+	p->CubicTo(cx+r,cy,3*k,0,0,3*k);
+	p->CubicTo(cx,cy+r,0,3*k,-3*k,0);
+	p->CubicTo(cx-r,cy,-3*k,0,0,-3*k);
+	p->Close();
+}
+static void     MakePolygons(Path* p,int nbPoly,int nbVert)
+{
+	for (int i=0;i<nbPoly;i++) {
+		float  cx=Rnd(0,1000),cy=Rnd(0,1000),r=Rnd(50,300);
+		p->MoveTo(cx+Rnd(-r,r),cy+Rnd(-r,r));
+		for (int j=1;j<nbVert;j++) p->LineTo(cx+Rnd(-r,r),cy+Rnd(-r,r));
+		p->Close();
+	}
+}
+static void     MakeStars(Path* p,int nbStar,int nbSpike)
+{
+	for (int i=0;i<nbStar;i++) {
+		float  cx=Rnd(0,1000),cy=Rnd(0,1000),r=Rnd(100,400);
+		float  phase=Rnd(0,6.28f);
+		// a star burst drawn in one stroke: each spike goes out and back across the middle
+		for (int j=0;j<nbSpike;j++) {
+			float  a=phase+6.2831853f*j/nbSpike+Rnd(-0.01f,0.01f);
+			float  rr=r*Rnd(0.8f,1.0f);
+			float  x=cx+rr*cos(a),y=cy+rr*sin(a);
+			if ( j == 0 ) p->MoveTo(x,y); else p->LineTo(x,y);
+			a+=3.1415926f*(1.0f-1.0f/nbSpike);
+			p->LineTo(cx+0.3f*rr*cos(a),cy+0.3f*rr*sin(a));
+		}
+		p->Close();
+	}
+}
+static void     MakeCircles(Path* p,int nbCircle)
+{
+	for (int i=0;i<nbCircle;i++) AddCircle(p,Rnd(0,2000),Rnd(0,2000),Rnd(10,120));
+}
+static void     MakeText(Path* p,int nbGlyph)
+{
+	// glyph-like outlines on text lines: bowls with counters, stems, arches
+	float  x=0,y=0;
+	for (int i=0;i<nbGlyph;i++) {
+		float  h=12,w=Rnd(5,8);
+		int    kind=rand()%3;
+		if ( kind == 0 ) {
+			// 'o': outer and inner loop
+			AddCircle(p,x+w/2,y+h/2,w/2);
+			float  k=0.5522847f*(w/2-1.5f),r=w/2-1.5f,cx=x+w/2,cy=y+h/2;
+			p->MoveTo(cx-r,cy);
+			p->CubicTo(cx,cy+r,0,3*k,3*k,0);
+			p->CubicTo(cx+r,cy,3*k,0,0,-3*k);
+			p->CubicTo(cx,cy-r,0,-3*k,-3*k,0);
+			p->CubicTo(cx-r,cy,-3*k,0,0,3*k);
+			p->Close();
+		} else if ( kind == 1 ) {
+			// 'l'
+			p->MoveTo(x+w/2-1,y-4);
+			p->LineTo(x+w/2+1,y-4);
+			p->LineTo(x+w/2+1,y+h);
+			p->LineTo(x+w/2-1,y+h);
+			p->Close();
+		} else {
+			// 'n'
+			p->MoveTo(x,y+h);
+			p->LineTo(x,y);
+			p->LineTo(x+1.5f,y);
+			p->CubicTo(x+w,y+2,6*w,0,0,6);
+			p->LineTo(x+w,y+h);
+			p->LineTo(x+w-1.5f,y+h);
+			p->LineTo(x+w-1.5f,y+3);
+			p->CubicTo(x+1.5f,y+2.5f,0,-3*w,-3*w,0);
+			p->LineTo(x+1.5f,y+h);
+			p->Close();
+		}
+		x+=w+1.5f;
+		if ( x > 1500 ) {
+			x=0;
+			y+=16;
+		}
+	}
+}
+static workload MakeWorkload(const char* name,void (*gen)(Path*,int,int),int n1,int n2,FillRule rule)
+{
+	workload  w;
+	strncpy(w.name,name,sizeof(w.name)-1);
+	w.name[sizeof(w.name)-1]=0;
+	w.nbPath=1;
+	w.a=(Path**)malloc(sizeof(Path*));
+	w.b=(Path**)malloc(sizeof(Path*));
+	w.rule=(FillRule*)malloc(sizeof(FillRule));
+	w.a[0]=new Path;
+	w.b[0]=new Path;
+	w.rule[0]=rule;
+	gen(w.a[0],n1,n2);
+	gen(w.b[0],n1,n2);
+	return w;
+}
+static void     GenPolygons(Path* p,int n1,int n2) {MakePolygons(p,n1,n2);}
+static void     GenStars(Path* p,int n1,int n2) {MakeStars(p,n1,n2);}
+static void     GenCircles(Path* p,int n1,int) {MakeCircles(p,n1);}
+static void     GenText(Path* p,int n1,int) {MakeText(p,n1);}
+
+// each path of the document is one operand; Booleen pairs it with the next one, as a multi-selection would
+static bool     MakeSampleWorkload(const char* fileName,const char* name,workload &w)
+{
+	sample_path*  paths=NULL;
+	int  nb=LoadInkpadPaths(fileName,paths);
+	if ( nb <= 1 ) {
+		FreeInkpadPaths(paths,(nb > 0)?nb:0);
+		return false;
+	}
+	snprintf(w.name,sizeof(w.name),"%s",name);
+	w.nbPath=nb;
+	w.a=(Path**)malloc(nb*sizeof(Path*));
+	w.b=(Path**)malloc(nb*sizeof(Path*));
+	w.rule=(FillRule*)malloc(nb*sizeof(FillRule));
+	for (int i=0;i<nb;i++) {
+		w.a[i]=new Path;
+		w.a[i]->Copy(paths[i].path);
+		w.b[i]=new Path;
+		w.b[i]->Copy(paths[(i+1)%nb].path);
+		w.rule[i]=paths[i].rule;
+	}
+	FreeInkpadPaths(paths,nb);
+	return true;
+}
+static void     FreeWorkload(workload &w)
+{
+	for (int i=0;i<w.nbPath;i++) {
+		delete w.a[i];
+		delete w.b[i];
+	}
+	free(w.a);
+	free(w.b);
+	free(w.rule);
+}
+
+static void     RunWorkload(workload &w,int iterations,op_samples* ops)
+{
+	for (int it=0;it<iterations;it++) {
+		for (int i=0;i<w.nbPath;i++) {
+			Path*   pa=w.a[i];
+			Path*   pb=w.b[i];
+			Shape   ga,gb,sa,sb,res,off;
+			Path    dest;
+			double  st;
+
+			st=NowUS();
+			pa->ConvertWithBackData(1);
+			AddSample(ops[op_convert],NowUS()-st,pa->nbPt);
+			pb->ConvertWithBackData(1);
+
+			st=NowUS();
+			pa->Fill(&ga,0);
+			AddSample(ops[op_fill],NowUS()-st,pa->nbPt);
+			pb->Fill(&gb,1);
+
+			st=NowUS();
+			int  err=sa.ConvertToShape(&ga,w.rule[i]);
+			AddSample(ops[op_convert_shape],NowUS()-st,ga.nbAr);
+			if ( err != 0 ) continue;
+			if ( sb.ConvertToShape(&gb,w.rule[i]) != 0 ) continue;
+
+			st=NowUS();
+			err=res.Booleen(&sa,&sb,bool_op_union);
+			AddSample(ops[op_booleen],NowUS()-st,sa.nbAr+sb.nbAr);
+			if ( err != 0 ) continue;
+
+			Path*   orig[2]={pa,pb};
+			st=NowUS();
+			res.ConvertToForme(&dest,2,orig);
+			AddSample(ops[op_convert_forme],NowUS()-st,res.nbAr);
+
+			st=NowUS();
+			off.MakeOffset(&sa,2.0,join_round,4.0);
+			AddSample(ops[op_make_offset],NowUS()-st,sa.nbAr);
+		}
+	}
+}
+static void     Report(const char* name,op_samples* ops)
+{
+	for (int o=0;o<op_nb;o++) {
+		op_samples  &s=ops[o];
+		if ( s.nb <= 0 ) continue;
+		double  total=0;
+		for (int i=0;i<s.nb;i++) total+=s.us[i];
+		qsort(s.us,s.nb,sizeof(double),CmpDouble);
+		double  perSec=(total > 0)?1e6*s.nb/total:0;
+		double  edgesPerSec=(total > 0)?s.edges/total:0; // edges per us == Medges/s
+		printf("%-28s %-16s %8i %12.1f %12.1f %12.1f %10.2f\n",name,opNames[o],s.nb,Percentile(s,0.5),Percentile(s,0.99),perSec,edgesPerSec);
+	}
+}
+
+int main(int argc,char** argv)
+{
+	int          iterations=10;
+	const char*  only=NULL;
+	const char*  samplesDir="../../../Samples";
+	const char*  traceFile=NULL;
+	for (int i=1;i<argc;i++) {
+		if ( strcmp(argv[i],"-n") == 0 && i+1 < argc ) {
+			iterations=atoi(argv[++i]);
+		} else if ( strcmp(argv[i],"-w") == 0 && i+1 < argc ) {
+			only=argv[++i];
+		} else if ( strcmp(argv[i],"-s") == 0 && i+1 < argc ) {
+			samplesDir=argv[++i];
+		} else if ( strcmp(argv[i],"-t") == 0 && i+1 < argc ) {
+			traceFile=argv[++i];
+		} else {
+			fprintf(stderr,"usage: %s [-n iterations] [-w workload] [-s samplesDir] [-t trace.json]\n",argv[0]);
+			return 1;
+		}
+	}
+	if ( iterations < 1 ) iterations=1;
+#if LIVAROT_STATS
+	LivarotStats::Reset();
+	LivarotStats::SetTracing(traceFile != NULL);
+#else
+	if ( traceFile ) fprintf(stderr,"-t ignored: rebuild with LIVAROT_STATS=1\n");
+#endif
+
+	int       nbWork=0;
+	workload  works[64];
+	srand(1234);
+	works[nbWork++]=MakeWorkload("polygons",GenPolygons,20,60,fill_nonZero);
+	works[nbWork++]=MakeWorkload("stars",GenStars,30,24,fill_oddEven);
+	works[nbWork++]=MakeWorkload("circles",GenCircles,2000,0,fill_nonZero);
+	works[nbWork++]=MakeWorkload("text",GenText,3000,0,fill_nonZero);
+
+	DIR*  dir=opendir(samplesDir);
+	if ( dir ) {
+		struct dirent*  ent;
+		while ( (ent=readdir(dir)) != NULL && nbWork < 64 ) {
+			int  l=strlen(ent->d_name);
+			if ( l <= 7 || strcmp(ent->d_name+l-7,".inkpad") != 0 ) continue;
+			char  path[1024];
+			snprintf(path,sizeof(path),"%s/%s",samplesDir,ent->d_name);
+			if ( MakeSampleWorkload(path,ent->d_name,works[nbWork]) ) nbWork++;
+		}
+		closedir(dir);
+	} else {
+		fprintf(stderr,"no samples in %s\n",samplesDir);
+	}
+
+	printf("%-28s %-16s %8s %12s %12s %12s %10s\n","workload","op","calls","p50 (us)","p99 (us)","calls/s","Medges/s");
+	for (int w=0;w<nbWork;w++) {
+		if ( only && strstr(works[w].name,only) == NULL ) continue;
+		op_samples  ops[op_nb];
+		memset(ops,0,sizeof(ops));
+		RunWorkload(works[w],iterations,ops);
+		Report(works[w].name,ops);
+		for (int o=0;o<op_nb;o++) if ( ops[o].us ) free(ops[o].us);
+	}
+	for (int w=0;w<nbWork;w++) FreeWorkload(works[w]);
+
+	struct rusage  usage;
+	getrusage(RUSAGE_SELF,&usage);
+	printf("peak RSS: %.1f MB\n",usage.ru_maxrss/1024.0);
+
+#if LIVAROT_STATS
+	LivarotStats::Print(stdout);
+	if ( traceFile && LivarotStats::WriteTrace(traceFile) != 0 ) {
+		fprintf(stderr,"couldn't write %s\n",traceFile);
+		return 1;
+	}
+#endif
+	return 0;
+}
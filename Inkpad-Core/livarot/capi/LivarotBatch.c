@@ -0,0 +1,286 @@
+/*
+ *  LivarotBatch.c
+ *  nlivarot C API
+ *
+ *  batch driver over the C API: reads one job per line from a file or stdin, writes one line
+ *  per job to stdout, so a worker process can chew through thousands of jobs in one run
+ *
+ *  usage: livarot_batch [-t tolerance] [jobFile]
+ *
+ *  jobs (blank lines and lines starting with # are skipped and get no output line):
+ *    fill nonzero|evenodd|positive A     the contours of A, for that fill rule
+ *    union|inters|diff|symdiff A ; B     A op B, both operands taken with the nonzero rule
+ *    offset distance round|straight|pointy [miter] A
+ *  A and B are path data with absolute commands only: M x y, L x y, C x1 y1 x2 y2 x y, Z
+ *  the output line is the path data of the result (empty if the result is empty), or
+ *  "error code" with the lv_ error code of LivarotC.h
+ *
+ *  example:
+ *    diff M 0 0 L 100 0 L 100 100 L 0 100 Z ; M 50 50 C 80 50 80 150 50 150 Z
+ *
+ */
+
+#include "LivarotC.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+typedef struct path_data {
+	int             nbCmd,maxCmd;
+	unsigned char*  cmds;
+	int             nbCoord,maxCoord;
+	float*          coords;
+} path_data;
+
+static void     AddCommand(path_data* d,int cmd,const float* c,int nb)
+{
+	if ( d->nbCmd >= d->maxCmd ) {
+		d->maxCmd=2*d->nbCmd+16;
+		d->cmds=(unsigned char*)realloc(d->cmds,d->maxCmd*sizeof(unsigned char));
+	}
+	if ( d->nbCoord+nb > d->maxCoord ) {
+		d->maxCoord=2*d->nbCoord+nb+32;
+		d->coords=(float*)realloc(d->coords,d->maxCoord*sizeof(float));
+	}
+	d->cmds[d->nbCmd++]=(unsigned char)cmd;
+	memcpy(d->coords+d->nbCoord,c,nb*sizeof(float));
+	d->nbCoord+=nb;
+}
+
+static char*    SkipSpaces(char* s)
+{
+	while ( *s && isspace((unsigned char)*s) ) s++;
+	return s;
+}
+
+// parses the path data in s up to the end of the string or the next ';', and returns a pointer
+// past it, or NULL on a syntax error
+static char*    ParsePath(char* s,path_data* d)
+{
+	d->nbCmd=d->nbCoord=0;
+	for (;;) {
+		s=SkipSpaces(s);
+		if ( *s == 0 ) return s;
+		if ( *s == ';' ) return s+1;
+		int    cmd,nb;
+		switch ( *s ) {
+			case 'M': cmd=lv_moveto; break;
+			case 'L': cmd=lv_lineto; break;
+			case 'C': cmd=lv_cubicto; break;
+			case 'Z': case 'z': cmd=lv_close; break;
+			default: return NULL;
+		}
+		s++;
+		nb=(cmd == lv_cubicto)?6:((cmd == lv_close)?0:2);
+		float  c[6];
+		for (int i=0;i<nb;i++) {
+			char*  end;
+			c[i]=strtof(s,&end);
+			if ( end == s ) return NULL;
+			s=end;
+		}
+		AddCommand(d,cmd,c,nb);
+	}
+}
+
+static void     PrintPath(lv_path* p,path_data* d)
+{
+	int    nbCmd,nbCoord;
+	lv_path_size(p,&nbCmd,&nbCoord);
+	d->nbCmd=d->nbCoord=0;
+	if ( nbCmd > d->maxCmd ) {
+		d->maxCmd=nbCmd;
+		d->cmds=(unsigned char*)realloc(d->cmds,d->maxCmd*sizeof(unsigned char));
+	}
+	if ( nbCoord > d->maxCoord ) {
+		d->maxCoord=nbCoord;
+		d->coords=(float*)realloc(d->coords,d->maxCoord*sizeof(float));
+	}
+	lv_path_get(p,d->cmds,d->coords);
+	const float*  c=d->coords;
+	for (int i=0;i<nbCmd;i++) {
+		if ( i > 0 ) putchar(' ');
+		if ( d->cmds[i] == lv_moveto ) {
+			printf("M %g %g",c[0],c[1]);
+			c+=2;
+		} else if ( d->cmds[i] == lv_lineto ) {
+			printf("L %g %g",c[0],c[1]);
+			c+=2;
+		} else if ( d->cmds[i] == lv_cubicto ) {
+			printf("C %g %g %g %g %g %g",c[0],c[1],c[2],c[3],c[4],c[5]);
+			c+=6;
+		} else {
+			putchar('Z');
+		}
+	}
+	putchar('\n');
+}
+
+typedef struct batch {
+	float       tolerance;
+	path_data   data;
+	lv_path*    paths[2];
+	lv_path*    result;
+	lv_shape*   a;
+	lv_shape*   b;
+	lv_shape*   dest;
+} batch;
+
+static int      Operand(batch* w,char** s,int i)
+{
+	*s=ParsePath(*s,&w->data);
+	if ( *s == NULL || w->data.nbCmd <= 0 ) return lv_arg_err;
+	return lv_path_set(w->paths[i],w->data.nbCmd,w->data.cmds,w->data.coords,w->tolerance);
+}
+
+// runs the job in line, and returns the error code; the result is in w->result
+static int      RunJob(batch* w,char* line)
+{
+	char    op[16];
+	int     len=0;
+	char*   s=SkipSpaces(line);
+	while ( *s && !isspace((unsigned char)*s) && len < 15 ) op[len++]=*(s++);
+	op[len]=0;
+
+	int     err;
+	if ( strcmp(op,"fill") == 0 ) {
+		int    rule;
+		s=SkipSpaces(s);
+		if ( strncmp(s,"nonzero",7) == 0 ) {
+			rule=lv_fill_nonzero;
+			s+=7;
+		} else if ( strncmp(s,"evenodd",7) == 0 ) {
+			rule=lv_fill_oddeven;
+			s+=7;
+		} else if ( strncmp(s,"positive",8) == 0 ) {
+			rule=lv_fill_positive;
+			s+=8;
+		} else {
+			return lv_arg_err;
+		}
+		if ( (err=Operand(w,&s,0)) != lv_ok ) return err;
+		if ( (err=lv_shape_fill(w->dest,w->paths,0,1,rule)) != lv_ok ) return err;
+		return lv_shape_to_path(w->dest,w->paths,1,w->result);
+	}
+
+	if ( strcmp(op,"offset") == 0 ) {
+		char*  end;
+		float  dist=strtof(s,&end);
+		if ( end == s ) return lv_arg_err;
+		s=SkipSpaces(end);
+		int    join;
+		if ( strncmp(s,"round",5) == 0 ) {
+			join=lv_join_round;
+			s+=5;
+		} else if ( strncmp(s,"straight",8) == 0 ) {
+			join=lv_join_straight;
+			s+=8;
+		} else if ( strncmp(s,"pointy",6) == 0 ) {
+			join=lv_join_pointy;
+			s+=6;
+		} else {
+			return lv_arg_err;
+		}
+		float  miter=strtof(s,&end);
+		if ( end == s ) {
+			miter=4;
+		} else {
+			s=end;
+		}
+		if ( (err=Operand(w,&s,0)) != lv_ok ) return err;
+		if ( (err=lv_shape_fill(w->a,w->paths,0,1,lv_fill_nonzero)) != lv_ok ) return err;
+		if ( (err=lv_shape_offset(w->dest,w->a,dist,join,miter)) != lv_ok ) return err;
+		return lv_shape_to_path(w->dest,NULL,0,w->result);
+	}
+
+	int     bop;
+	if ( strcmp(op,"union") == 0 ) {
+		bop=lv_union;
+	} else if ( strcmp(op,"inters") == 0 ) {
+		bop=lv_inters;
+	} else if ( strcmp(op,"diff") == 0 ) {
+		bop=lv_diff;
+	} else if ( strcmp(op,"symdiff") == 0 ) {
+		bop=lv_symdiff;
+	} else {
+		return lv_arg_err;
+	}
+	if ( (err=Operand(w,&s,0)) != lv_ok ) return err;
+	if ( (err=Operand(w,&s,1)) != lv_ok ) return err;
+	if ( (err=lv_shape_fill(w->a,w->paths,0,1,lv_fill_nonzero)) != lv_ok ) return err;
+	if ( (err=lv_shape_fill(w->b,w->paths,1,1,lv_fill_nonzero)) != lv_ok ) return err;
+	if ( (err=lv_shape_boolean(w->dest,w->a,w->b,bop)) != lv_ok ) return err;
+	return lv_shape_to_path(w->dest,w->paths,2,w->result);
+}
+
+int             main(int argc,char** argv)
+{
+	batch     w;
+	memset(&w,0,sizeof(w));
+	w.tolerance=1;
+	const char* fileName=NULL;
+	for (int i=1;i<argc;i++) {
+		if ( strcmp(argv[i],"-t") == 0 && i+1 < argc ) {
+			w.tolerance=(float)atof(argv[++i]);
+		} else if ( argv[i][0] != '-' ) {
+			fileName=argv[i];
+		} else {
+			fprintf(stderr,"usage: livarot_batch [-t tolerance] [jobFile]\n");
+			return 1;
+		}
+	}
+	if ( w.tolerance <= 0 ) {
+		fprintf(stderr,"livarot_batch: the tolerance must be > 0\n");
+		return 1;
+	}
+	if ( lv_api_version() != LV_API_VERSION ) {
+		fprintf(stderr,"livarot_batch: built for version %d of the C API, the library is %d\n",LV_API_VERSION,lv_api_version());
+		return 1;
+	}
+	FILE*     in=(fileName)?fopen(fileName,"r"):stdin;
+	if ( in == NULL ) {
+		fprintf(stderr,"livarot_batch: can't open %s\n",fileName);
+		return 1;
+	}
+
+	// the same objects serve every job, so their arrays only grow to the biggest job
+	w.paths[0]=lv_path_new();
+	w.paths[1]=lv_path_new();
+	w.result=lv_path_new();
+	w.a=lv_shape_new();
+	w.b=lv_shape_new();
+	w.dest=lv_shape_new();
+	if ( !w.paths[0] || !w.paths[1] || !w.result || !w.a || !w.b || !w.dest ) {
+		fprintf(stderr,"livarot_batch: out of memory\n");
+		return 1;
+	}
+
+	char*     line=NULL;
+	size_t    size=0;
+	int       nbErr=0;
+	while ( getline(&line,&size,in) >= 0 ) {
+		char*  s=SkipSpaces(line);
+		if ( *s == 0 || *s == '#' ) continue;
+		int    err=RunJob(&w,s);
+		if ( err == lv_ok ) {
+			PrintPath(w.result,&w.data);
+		} else {
+			printf("error %d\n",err);
+			nbErr++;
+		}
+	}
+	free(line);
+	if ( in != stdin ) fclose(in);
+
+	lv_path_free(w.paths[0]);
+	lv_path_free(w.paths[1]);
+	lv_path_free(w.result);
+	lv_shape_free(w.a);
+	lv_shape_free(w.b);
+	lv_shape_free(w.dest);
+	free(w.data.cmds);
+	free(w.data.coords);
+	return (nbErr > 0)?2:0;
+}
@@ -0,0 +1,197 @@
+/*
+ *  LivarotC.cpp
+ *  nlivarot C API
+ *
+ *  the handles are the livarot objects themselves: an lv_path* is a Path*, an lv_shape* a Shape*,
+ *  so arrays of handles can be passed to livarot as they are
+ *
+ */
+
+#include "LivarotC.h"
+#include "Path.h"
+#include "Shape.h"
+
+#include <new>
+
+static inline Path*   AsPath(lv_path* p) {return reinterpret_cast<Path*>(p);}
+static inline Path**  AsPaths(lv_path* const* p) {return reinterpret_cast<Path**>(const_cast<lv_path**>(p));}
+static inline Shape*  AsShape(lv_shape* s) {return reinterpret_cast<Shape*>(s);}
+
+// number of coordinates read or written for each command, -1 for the unknown ones
+static int            CommandSize(int cmd)
+{
+	if ( cmd == lv_moveto || cmd == lv_lineto ) return 2;
+	if ( cmd == lv_cubicto ) return 6;
+	if ( cmd == lv_close ) return 0;
+	return -1;
+}
+
+int               lv_api_version(void)
+{
+	return LV_API_VERSION;
+}
+
+lv_path*          lv_path_new(void)
+{
+	return reinterpret_cast<lv_path*>(new (std::nothrow) Path);
+}
+void              lv_path_free(lv_path* p)
+{
+	delete AsPath(p);
+}
+int               lv_path_set(lv_path* p,int nbCmd,const unsigned char* cmds,const float* coords,float tolerance)
+{
+	if ( p == NULL || nbCmd < 0 || ( nbCmd > 0 && cmds == NULL ) || tolerance <= 0 ) return lv_arg_err;
+	int      nbCoord=0;
+	for (int i=0;i<nbCmd;i++) {
+		int  size=CommandSize(cmds[i]);
+		if ( size < 0 ) return lv_arg_err;
+		nbCoord+=size;
+	}
+	if ( nbCoord > 0 && coords == NULL ) return lv_arg_err;
+
+	Path*    path=AsPath(p);
+	path->Reset();
+	path->SetWeighted(false);
+	// livarot's cubics are given by their end tangents, 3 times the control point offsets
+	float    curX=0,curY=0,stX=0,stY=0;
+	for (int i=0;i<nbCmd;i++) {
+		const float*  c=coords;
+		if ( cmds[i] == lv_moveto ) {
+			path->MoveTo(c[0],c[1]);
+			curX=stX=c[0];
+			curY=stY=c[1];
+		} else if ( cmds[i] == lv_lineto ) {
+			path->LineTo(c[0],c[1]);
+			curX=c[0];
+			curY=c[1];
+		} else if ( cmds[i] == lv_cubicto ) {
+			path->CubicTo(c[4],c[5],3*(c[0]-curX),3*(c[1]-curY),3*(c[4]-c[2]),3*(c[5]-c[3]));
+			curX=c[4];
+			curY=c[5];
+		} else {
+			path->Close();
+			curX=stX;
+			curY=stY;
+		}
+		coords+=CommandSize(cmds[i]);
+	}
+	path->ConvertWithBackData(tolerance);
+	return lv_ok;
+}
+void              lv_path_size(lv_path* p,int* nbCmd,int* nbCoord)
+{
+	int      nCmd=0,nCoord=0;
+	if ( p ) {
+		Path*  path=AsPath(p);
+		for (int i=0;i<path->descr_nb;i++) {
+			int ty=(path->descr_data+i)->flags&descr_type_mask;
+			if ( ty == descr_interm_bezier || ty == descr_forced ) continue;
+			if ( ty == descr_cubicto ) {
+				nCoord+=6;
+			} else if ( ty != descr_close ) {
+				nCoord+=2;
+			}
+			nCmd++;
+		}
+	}
+	if ( nbCmd ) *nbCmd=nCmd;
+	if ( nbCoord ) *nbCoord=nCoord;
+}
+void              lv_path_get(lv_path* p,unsigned char* cmds,float* coords)
+{
+	if ( p == NULL || cmds == NULL ) return;
+	Path*    path=AsPath(p);
+	float    curX=0,curY=0,stX=0,stY=0;
+	for (int i=0;i<path->descr_nb;i++) {
+		Path::path_descr*  d=path->descr_data+i;
+		int ty=d->flags&descr_type_mask;
+		if ( ty == descr_moveto ) {
+			*(cmds++)=lv_moveto;
+			curX=stX=*(coords++)=d->d.m.x;
+			curY=stY=*(coords++)=d->d.m.y;
+		} else if ( ty == descr_cubicto ) {
+			*(cmds++)=lv_cubicto;
+			*(coords++)=curX+d->d.c.stDx/3;
+			*(coords++)=curY+d->d.c.stDy/3;
+			*(coords++)=d->d.c.x-d->d.c.enDx/3;
+			*(coords++)=d->d.c.y-d->d.c.enDy/3;
+			curX=*(coords++)=d->d.c.x;
+			curY=*(coords++)=d->d.c.y;
+		} else if ( ty == descr_close ) {
+			*(cmds++)=lv_close;
+			curX=stX;
+			curY=stY;
+		} else if ( ty == descr_lineto || ty == descr_bezierto || ty == descr_arcto ) {
+			// the last 2 never come out of lv_shape_to_path(), since lv_path_set() doesn't make them
+			*(cmds++)=lv_lineto;
+			if ( ty == descr_lineto ) {
+				curX=d->d.l.x;
+				curY=d->d.l.y;
+			} else if ( ty == descr_bezierto ) {
+				curX=d->d.b.x;
+				curY=d->d.b.y;
+			} else {
+				curX=d->d.a.x;
+				curY=d->d.a.y;
+			}
+			*(coords++)=curX;
+			*(coords++)=curY;
+		}
+	}
+}
+
+lv_shape*         lv_shape_new(void)
+{
+	return reinterpret_cast<lv_shape*>(new (std::nothrow) Shape);
+}
+void              lv_shape_free(lv_shape* s)
+{
+	delete AsShape(s);
+}
+int               lv_shape_fill(lv_shape* s,lv_path* const* paths,int first,int count,int fillRule)
+{
+	if ( s == NULL || paths == NULL || first < 0 || count <= 0 ) return lv_arg_err;
+	if ( fillRule < lv_fill_oddeven || fillRule > lv_fill_positive ) return lv_arg_err;
+	for (int i=first;i<first+count;i++) {
+		if ( paths[i] == NULL ) return lv_arg_err;
+	}
+	return AsShape(s)->ConvertToShape(AsPaths(paths),first,count,(FillRule)fillRule);
+}
+int               lv_shape_boolean(lv_shape* dest,lv_shape* a,lv_shape* b,int op)
+{
+	if ( dest == NULL || a == NULL || b == NULL || dest == a || dest == b ) return lv_arg_err;
+	if ( op < lv_union || op > lv_symdiff ) return lv_arg_err;
+	return AsShape(dest)->Booleen(AsShape(a),AsShape(b),(BooleanOp)op);
+}
+int               lv_shape_offset(lv_shape* dest,lv_shape* a,float offset,int join,float miter)
+{
+	if ( dest == NULL || a == NULL || dest == a ) return lv_arg_err;
+	if ( join < lv_join_straight || join > lv_join_pointy ) return lv_arg_err;
+	Shape    work;
+	Shape*   of=AsShape(a);
+	return AsShape(dest)->ConvertToOffset(1,&of,offset,(JoinType)join,miter,&work);
+}
+void              lv_shape_size(lv_shape* s,int* nbPt,int* nbEdge)
+{
+	if ( nbPt ) *nbPt=(s)?AsShape(s)->nbPt:0;
+	if ( nbEdge ) *nbEdge=(s)?AsShape(s)->nbAr:0;
+}
+int               lv_shape_to_path(lv_shape* s,lv_path* const* paths,int nbPath,lv_path* dest)
+{
+	if ( s == NULL || dest == NULL || ( paths && nbPath <= 0 ) ) return lv_arg_err;
+	Shape*   shape=AsShape(s);
+	Path*    path=AsPath(dest);
+	path->Reset();
+	if ( paths && (shape->flags&has_back_data) ) {
+		// the IDs must index into paths, or ConvertToForme() would read past it
+		for (int i=0;i<shape->nbAr;i++) {
+			int  id=shape->ebData[i].pathID;
+			if ( id < 0 || id >= nbPath || paths[id] == NULL ) return lv_arg_err;
+		}
+		shape->ConvertToForme(path,nbPath,AsPaths(paths));
+	} else {
+		shape->ConvertToForme(path);
+	}
+	return lv_ok;
+}
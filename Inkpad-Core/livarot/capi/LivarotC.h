@@ -0,0 +1,106 @@
+/*
+ *  LivarotC.h
+ *  nlivarot C API
+ *
+ *  a plain C interface over the Path and Shape operations the pathfinder uses (fill, boolean,
+ *  offset, back to curves), with the geometry passed in and out as flat arrays, so the library
+ *  can be built on its own and driven from processes that don't link Objective-C or C++
+ *
+ *  the typical job:
+ *    lv_path_set() each operand, lv_shape_fill() each one into a shape, lv_shape_boolean() or
+ *    lv_shape_offset() the shapes, lv_shape_to_path() the result, lv_path_size() + lv_path_get()
+ *  the functions returning int return lv_ok (0) or one of the error codes below
+ *  objects are not thread-safe, but different objects can be used from different threads
+ *
+ */
+
+#ifndef my_livarot_c
+#define my_livarot_c
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define LV_API __attribute__((visibility("default")))
+#else
+#define LV_API
+#endif
+
+// bumped when a signature or the meaning of an argument changes
+#define LV_API_VERSION 1
+
+// error codes; lv_euler_err and lv_input_err are livarot's shape_euler_err and shape_input_err
+enum {
+	lv_ok          =0,
+	lv_euler_err   =4, // the sweep couldn't produce a proper polygon
+	lv_input_err   =5, // the input isn't a polygon, or isn't eulerian
+	lv_arg_err     =-1, // NULL object, unknown command or enum value, inconsistent counts
+	lv_mem_err     =-2
+};
+
+// path commands; the number of coordinates each one reads from (or writes to) the coords array is in
+// parentheses; lv_cubicto takes the 2 control points, then the end point
+enum {
+	lv_moveto  =0, // (2) x y
+	lv_lineto  =1, // (2) x y
+	lv_cubicto =2, // (6) x1 y1 x2 y2 x y
+	lv_close   =3  // (0)
+};
+
+// same values as livarot's FillRule, BooleanOp and JoinType
+enum {
+	lv_fill_oddeven  =0,
+	lv_fill_nonzero  =1,
+	lv_fill_positive =2
+};
+enum {
+	lv_union   =0, // A OR B
+	lv_inters  =1, // A AND B
+	lv_diff    =2, // A \ B
+	lv_symdiff =3  // A XOR B
+};
+enum {
+	lv_join_straight =0,
+	lv_join_round    =1,
+	lv_join_pointy   =2
+};
+
+typedef struct lv_path  lv_path;
+typedef struct lv_shape lv_shape;
+
+LV_API int       lv_api_version(void); // LV_API_VERSION of the library
+
+LV_API lv_path*  lv_path_new(void);
+LV_API void      lv_path_free(lv_path* p);
+// replaces the description of p with nbCmd commands; coords holds their coordinates one after the other
+// the path is then flattened with the given tolerance, keeping the back data that lets lv_shape_to_path()
+// rebuild the curves (the pathfinder uses 1)
+LV_API int       lv_path_set(lv_path* p,int nbCmd,const unsigned char* cmds,const float* coords,float tolerance);
+// size of the description of p, to allocate the arrays for lv_path_get()
+LV_API void      lv_path_size(lv_path* p,int* nbCmd,int* nbCoord);
+// copies the description of p into cmds and coords
+// only the 4 commands above are written: the descriptions built by this API don't hold anything else
+LV_API void      lv_path_get(lv_path* p,unsigned char* cmds,float* coords);
+
+LV_API lv_shape* lv_shape_new(void);
+LV_API void      lv_shape_free(lv_shape* s);
+// fills paths[first]..paths[first+count-1] into s, each with its index in paths as ID, and sweeps
+// them into a polygon with the fill rule; several paths make one compound shape
+LV_API int       lv_shape_fill(lv_shape* s,lv_path* const* paths,int first,int count,int fillRule);
+// dest = a op b; dest can't be a or b
+LV_API int       lv_shape_boolean(lv_shape* dest,lv_shape* a,lv_shape* b,int op);
+// dest = a grown by offset (shrunk if offset < 0); miter is the limit for lv_join_pointy
+LV_API int       lv_shape_offset(lv_shape* dest,lv_shape* a,float offset,int join,float miter);
+// number of points and edges in s
+LV_API void      lv_shape_size(lv_shape* s,int* nbPt,int* nbEdge);
+// the contours of s, as a path: with the nbPath paths s was filled from (the same array, so the IDs
+// match), the edges that come from the same curve are merged back into that curve; with paths NULL,
+// or for an offset, the result is made of straight lines
+LV_API int       lv_shape_to_path(lv_shape* s,lv_path* const* paths,int nbPath,lv_path* dest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ *  LivarotCTest.c
+ *  nlivarot C API
+ *
+ *  checks of the C API, run by "make check": argument errors, the path round trip, and fill,
+ *  boolean, offset and back to path on shapes whose area is known
+ *
+ */
+
+#include "LivarotC.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+static int      nbCheck=0,nbFail=0;
+
+#define CHECK(c) do { nbCheck++; if ( !(c) ) { nbFail++; fprintf(stderr,"%s:%d: CHECK(%s) failed\n",__FILE__,__LINE__,#c); } } while (0)
+#define CHECK_NEAR(a,b,eps) do { double a_=(a),b_=(b); nbCheck++; if ( fabs(a_-b_) > (eps) ) { nbFail++; fprintf(stderr,"%s:%d: %s = %g, expected %g\n",__FILE__,__LINE__,#a,a_,b_); } } while (0)
+
+static int      SetRect(lv_path* p,float l,float t,float r,float b)
+{
+	unsigned char  cmds[5]={lv_moveto,lv_lineto,lv_lineto,lv_lineto,lv_close};
+	float          coords[8]={l,t,r,t,r,b,l,b};
+	return lv_path_set(p,5,cmds,coords,1);
+}
+
+// signed area of the contours of p, which must be made of lines only; the curves count as lines
+static double   PathArea(lv_path* p,int* nbSubpath)
+{
+	int      nbCmd,nbCoord;
+	lv_path_size(p,&nbCmd,&nbCoord);
+	unsigned char*  cmds=(unsigned char*)malloc((nbCmd+1)*sizeof(unsigned char));
+	float*          coords=(float*)malloc((nbCoord+1)*sizeof(float));
+	lv_path_get(p,cmds,coords);
+	double   area=0;
+	float    sx=0,sy=0,lx=0,ly=0;
+	int      nbSub=0;
+	const float*  c=coords;
+	for (int i=0;i<nbCmd;i++) {
+		if ( cmds[i] == lv_moveto ) {
+			area+=lx*sy-sx*ly;
+			sx=lx=c[0];
+			sy=ly=c[1];
+			c+=2;
+			nbSub++;
+		} else if ( cmds[i] == lv_lineto ) {
+			area+=lx*c[1]-c[0]*ly;
+			lx=c[0];
+			ly=c[1];
+			c+=2;
+		} else if ( cmds[i] == lv_cubicto ) {
+			area+=lx*c[5]-c[4]*ly;
+			lx=c[4];
+			ly=c[5];
+			c+=6;
+		} else {
+			area+=lx*sy-sx*ly;
+			lx=sx;
+			ly=sy;
+		}
+	}
+	area+=lx*sy-sx*ly;
+	free(cmds);
+	free(coords);
+	if ( nbSubpath ) *nbSubpath=nbSub;
+	return 0.5*area;
+}
+
+static void     TestArguments(void)
+{
+	lv_path*       p=lv_path_new();
+	lv_shape*      s=lv_shape_new();
+	unsigned char  bad[2]={lv_moveto,7};
+	float          coords[4]={0,0,10,10};
+	CHECK(lv_api_version() == LV_API_VERSION);
+	CHECK(lv_path_set(NULL,0,NULL,NULL,1) == lv_arg_err);
+	CHECK(lv_path_set(p,2,bad,coords,1) == lv_arg_err);
+	CHECK(lv_path_set(p,-1,bad,coords,1) == lv_arg_err);
+	CHECK(lv_shape_fill(NULL,&p,0,1,lv_fill_nonzero) == lv_arg_err);
+	CHECK(lv_shape_fill(s,&p,0,1,17) == lv_arg_err);
+	CHECK(lv_shape_boolean(s,s,s,lv_union) == lv_arg_err);
+	CHECK(lv_shape_offset(s,s,1,lv_join_round,4) == lv_arg_err);
+	CHECK(lv_shape_to_path(s,NULL,0,NULL) == lv_arg_err);
+	lv_path_free(p);
+	lv_shape_free(s);
+	// freeing NULL is a no-op, like free()
+	lv_path_free(NULL);
+	lv_shape_free(NULL);
+}
+
+static void     TestPathRoundTrip(void)
+{
+	unsigned char  cmds[4]={lv_moveto,lv_cubicto,lv_lineto,lv_close};
+	float          coords[10]={0,0, 10,0,20,10,20,20, 0,20};
+	lv_path*       p=lv_path_new();
+	CHECK(lv_path_set(p,4,cmds,coords,1) == lv_ok);
+	int            nbCmd=0,nbCoord=0;
+	lv_path_size(p,&nbCmd,&nbCoord);
+	CHECK(nbCmd == 4);
+	CHECK(nbCoord == 10);
+	unsigned char  outCmds[4];
+	float          outCoords[10];
+	lv_path_get(p,outCmds,outCoords);
+	for (int i=0;i<4;i++) CHECK(outCmds[i] == cmds[i]);
+	for (int i=0;i<10;i++) CHECK_NEAR(outCoords[i],coords[i],1e-6);
+	lv_path_free(p);
+}
+
+static void     TestBoolean(void)
+{
+	lv_path*   paths[2]={lv_path_new(),lv_path_new()};
+	lv_path*   result=lv_path_new();
+	lv_shape*  a=lv_shape_new();
+	lv_shape*  b=lv_shape_new();
+	lv_shape*  dest=lv_shape_new();
+	CHECK(SetRect(paths[0],0,0,100,100) == lv_ok);
+	CHECK(SetRect(paths[1],50,50,150,150) == lv_ok);
+	CHECK(lv_shape_fill(a,paths,0,1,lv_fill_nonzero) == lv_ok);
+	CHECK(lv_shape_fill(b,paths,1,1,lv_fill_nonzero) == lv_ok);
+
+	// the 2 squares overlap on a 50x50 square
+	const double  areas[4]={17500,2500,7500,15000};
+	const int     subs[4]={1,1,1,2};
+	for (int op=lv_union;op<=lv_symdiff;op++) {
+		int     nbSub=0;
+		CHECK(lv_shape_boolean(dest,a,b,op) == lv_ok);
+		CHECK(lv_shape_to_path(dest,paths,2,result) == lv_ok);
+		CHECK_NEAR(fabs(PathArea(result,&nbSub)),areas[op],0.5);
+		CHECK(nbSub == subs[op]);
+	}
+
+	// both squares in one compound shape, unioned by the nonzero rule
+	int     nbPt=0,nbEdge=0;
+	CHECK(lv_shape_fill(dest,paths,0,2,lv_fill_nonzero) == lv_ok);
+	lv_shape_size(dest,&nbPt,&nbEdge);
+	CHECK(nbEdge == 8);
+	CHECK(lv_shape_to_path(dest,paths,2,result) == lv_ok);
+	CHECK_NEAR(fabs(PathArea(result,NULL)),17500,0.5);
+
+	// disjoint operands: their intersection is empty, and so is the path
+	CHECK(SetRect(paths[1],200,0,300,100) == lv_ok);
+	CHECK(lv_shape_fill(b,paths,1,1,lv_fill_nonzero) == lv_ok);
+	CHECK(lv_shape_boolean(dest,a,b,lv_inters) == lv_ok);
+	CHECK(lv_shape_to_path(dest,paths,2,result) == lv_ok);
+	lv_path_size(result,&nbPt,&nbEdge);
+	CHECK(nbPt == 0);
+
+	lv_path_free(paths[0]);
+	lv_path_free(paths[1]);
+	lv_path_free(result);
+	lv_shape_free(a);
+	lv_shape_free(b);
+	lv_shape_free(dest);
+}
+
+static void     TestOffset(void)
+{
+	lv_path*   p=lv_path_new();
+	lv_path*   result=lv_path_new();
+	lv_shape*  a=lv_shape_new();
+	lv_shape*  dest=lv_shape_new();
+	CHECK(SetRect(p,0,0,100,100) == lv_ok);
+	CHECK(lv_shape_fill(a,&p,0,1,lv_fill_nonzero) == lv_ok);
+
+	// with mitered corners the square just grows, or shrinks; the miter limit is a length, and the
+	// miters of a square offset by 10 are 10*sqrt(2) long
+	CHECK(lv_shape_offset(dest,a,10,lv_join_pointy,20) == lv_ok);
+	CHECK(lv_shape_to_path(dest,NULL,0,result) == lv_ok);
+	CHECK_NEAR(fabs(PathArea(result,NULL)),120.0*120.0,1);
+	CHECK(lv_shape_offset(dest,a,-10,lv_join_pointy,20) == lv_ok);
+	CHECK(lv_shape_to_path(dest,NULL,0,result) == lv_ok);
+	CHECK_NEAR(fabs(PathArea(result,NULL)),80.0*80.0,1);
+
+	// round corners fall between the bevels and the miters
+	CHECK(lv_shape_offset(dest,a,10,lv_join_round,4) == lv_ok);
+	CHECK(lv_shape_to_path(dest,NULL,0,result) == lv_ok);
+	double  area=fabs(PathArea(result,NULL));
+	CHECK(area > 100.0*100.0+4*100.0*10.0+2*10.0*10.0);
+	CHECK(area < 120.0*120.0);
+
+	// an empty shape isn't a polygon, so there is nothing to offset
+	lv_shape*  empty=lv_shape_new();
+	CHECK(lv_shape_offset(dest,empty,10,lv_join_round,4) == lv_input_err);
+	lv_shape_free(empty);
+
+	lv_path_free(p);
+	lv_path_free(result);
+	lv_shape_free(a);
+	lv_shape_free(dest);
+}
+
+int             main(void)
+{
+	TestArguments();
+	TestPathRoundTrip();
+	TestBoolean();
+	TestOffset();
+	printf("%d checks, %d failed\n",nbCheck,nbFail);
+	return (nbFail > 0)?1:0;
+}
@@ -0,0 +1,96 @@
+/*
+ *  LivarotTest.cpp
+ *  nlivarot tests
+ *
+ *  usage: livarot_test [name filter]
+ *
+ */
+
+#include "LivarotTest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+LivarotTest*      LivarotTest::first=NULL;
+int               LivarotTest::nbCheck=0;
+int               LivarotTest::nbFail=0;
+
+LivarotTest::LivarotTest(const char* iName,livarot_test_func iFunc)
+{
+	name=iName;
+	func=iFunc;
+	next=first;
+	first=this;
+}
+int               LivarotTest::RunAll(const char* filter)
+{
+	int      nbTest=0;
+	// the list is in reverse order of registration
+	LivarotTest*  tests[1024];
+	for (LivarotTest* t=first;t && nbTest < 1024;t=t->next) tests[nbTest++]=t;
+	for (int i=nbTest-1;i>=0;i--) {
+		LivarotTest*  t=tests[i];
+		if ( filter && strstr(t->name,filter) == NULL ) continue;
+		int      oldFail=nbFail;
+		t->func();
+		printf("%-40s %s\n",t->name,(nbFail == oldFail)?"ok":"FAILED");
+	}
+	printf("%i checks, %i failed\n",nbCheck,nbFail);
+	return nbFail;
+}
+void              LivarotTest::Check(bool ok,const char* file,int line,const char* expr)
+{
+	nbCheck++;
+	if ( ok ) return;
+	nbFail++;
+	printf("%s:%i: check failed: %s\n",file,line,expr);
+}
+
+void              RectPath(Path* p,float l,float t,float r,float b)
+{
+	p->MoveTo(l,t);
+	p->LineTo(r,t);
+	p->LineTo(r,b);
+	p->LineTo(l,b);
+	p->Close();
+}
+void              CirclePath(Path* p,float cx,float cy,float r)
+{
+	float  k=0.5522847f*r;
+	p->MoveTo(cx-r,cy);
+	p->CubicTo(cx,cy-r,0,-3*k,3*k,0);
+	p->CubicTo(cx+r,cy,3*k,0,0,3*k);
+	p->CubicTo(cx,cy+r,0,3*k,-3*k,0);
+	p->CubicTo(cx-r,cy,-3*k,0,0,-3*k);
+	p->Close();
+}
+int               FillShape(Shape* dest,Path* p,int pathID,FillRule rule)
+{
+	Shape    temp;
+	p->ConvertWithBackData(1);
+	p->Fill(&temp,pathID);
+	return dest->ConvertToShape(&temp,rule);
+}
+double            ShapeArea(Shape* s)
+{
+	double   area=0;
+	for (int i=0;i<s->nbAr;i++) {
+		Shape::dg_point&  a=s->pts[s->aretes[i].st];
+		Shape::dg_point&  b=s->pts[s->aretes[i].en];
+		area+=(double)a.x*(double)b.y-(double)b.x*(double)a.y;
+	}
+	return fabs(area)/2;
+}
+int               SubpathCount(Path* p)
+{
+	int      nb=0;
+	for (int i=0;i<p->descr_nb;i++) {
+		if ( ((p->descr_data+i)->flags&descr_type_mask) == descr_moveto ) nb++;
+	}
+	return nb;
+}
+
+int main(int argc,char** argv)
+{
+	return (LivarotTest::RunAll((argc > 1)?argv[1]:NULL) > 0)?1:0;
+}
@@ -0,0 +1,53 @@
+/*
+ *  LivarotTest.h
+ *  nlivarot tests
+ *
+ *  each Test*.cpp file declares its checks with LIVAROT_TEST, and livarot_test runs all of them (or the ones
+ *  whose name contains its argument)
+ *  a failed CHECK reports its file, line and expression, and the test goes on
+ *
+ */
+
+#ifndef my_livarot_test
+#define my_livarot_test
+
+#include "Path.h"
+#include "Shape.h"
+
+#include <math.h>
+
+typedef void (*livarot_test_func)(void);
+
+class LivarotTest {
+public:
+	LivarotTest(const char* iName,livarot_test_func iFunc);
+
+	static int        RunAll(const char* filter); // returns the number of failed checks
+	static void       Check(bool ok,const char* file,int line,const char* expr);
+
+private:
+	const char*        name;
+	livarot_test_func  func;
+	LivarotTest*       next;
+
+	static LivarotTest* first;
+	static int         nbCheck,nbFail;
+};
+
+#define LIVAROT_TEST(fname) \
+	static void fname(void); \
+	static LivarotTest fname##_test(#fname,fname); \
+	static void fname(void)
+
+#define CHECK(expr) LivarotTest::Check((expr),__FILE__,__LINE__,#expr)
+#define CHECK_NEAR(a,b,tol) LivarotTest::Check(fabs((double)(a)-(double)(b)) <= (tol),__FILE__,__LINE__,#a " ~ " #b)
+
+// geometry helpers
+void              RectPath(Path* p,float l,float t,float r,float b); // a closed rectangle, as one subpath
+void              CirclePath(Path* p,float cx,float cy,float r);     // a closed circle, as 4 cubics
+// flattens p with back data, fills it with pathID and sweeps it into dest with the fill rule (as the pathfinder does)
+int               FillShape(Shape* dest,Path* p,int pathID,FillRule rule=fill_nonZero);
+double            ShapeArea(Shape* s);  // area enclosed by the edges of s (a polygon)
+int               SubpathCount(Path* p); // number of MoveTos in the description of p
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ *  TestClipToRect.cpp
+ *  nlivarot tests
+ *
+ *  Shape::ClipToRect against Booleen with the same rectangle
+ *
+ */
+
+#include "LivarotTest.h"
+
+// clips a with ClipToRect and with Booleen, and checks that both give the same area
+static void       CheckClip(Shape* a,float l,float t,float r,float b,bool expectBooleen)
+{
+	Shape    clipped,rect,inters;
+	Path     rectPath;
+	bool     usedBooleen=true;
+
+	CHECK(clipped.ClipToRect(a,l,t,r,b,usedBooleen) == 0);
+	CHECK(usedBooleen == expectBooleen);
+
+	RectPath(&rectPath,l,t,r,b);
+	CHECK(FillShape(&rect,&rectPath,1) == 0);
+	CHECK(inters.Booleen(a,&rect,bool_op_inters) == 0);
+
+	CHECK_NEAR(ShapeArea(&clipped),ShapeArea(&inters),1.0);
+	if ( clipped.nbAr > 0 ) CHECK(clipped.Eulerian(true));
+}
+
+LIVAROT_TEST(ClipToRectCrossing)
+{
+	Path     circle;
+	Shape    a;
+	CirclePath(&circle,100,100,80);
+	CHECK(FillShape(&a,&circle,0) == 0);
+
+	CheckClip(&a,50,50,300,300,false);   // one corner inside the circle
+	CheckClip(&a,60,-50,140,250,false);  // a band across it
+	CheckClip(&a,90,90,110,110,false);   // entirely inside the circle
+	CheckClip(&a,0,0,200,200,false);     // around the circle
+}
+
+LIVAROT_TEST(ClipToRectOutside)
+{
+	Path     circle;
+	Shape    a,clipped;
+	bool     usedBooleen=true;
+	CirclePath(&circle,100,100,80);
+	CHECK(FillShape(&a,&circle,0) == 0);
+
+	CHECK(clipped.ClipToRect(&a,300,300,400,400,usedBooleen) == 0);
+	CHECK(usedBooleen == false);
+	CHECK(clipped.nbAr == 0);
+}
+
+LIVAROT_TEST(ClipToRectHole)
+{
+	// a ring: the rectangle is inside the outer contour and crosses the hole
+	Path     ring;
+	Shape    a;
+	CirclePath(&ring,100,100,80);
+	RectPath(&ring,80,80,120,120);
+	CHECK(FillShape(&a,&ring,0,fill_oddEven) == 0);
+
+	CheckClip(&a,40,70,160,100,false);
+}
+
+LIVAROT_TEST(ClipToRectDegenerate)
+{
+	// a point of the polygon on the border of the rectangle goes through Booleen
+	Path     square;
+	Shape    a;
+	RectPath(&square,0,0,100,100);
+	CHECK(FillShape(&a,&square,0) == 0);
+
+	CheckClip(&a,50,-50,150,100,true);
+}
+
+LIVAROT_TEST(ClipToRectBackData)
+{
+	Path     circle;
+	Shape    a,clipped;
+	bool     usedBooleen;
+	CirclePath(&circle,100,100,80);
+	CHECK(FillShape(&a,&circle,3) == 0);
+
+	CHECK(clipped.ClipToRect(&a,50,50,300,300,usedBooleen) == 0);
+	CHECK(clipped.flags&has_back_data);
+	int      nbBorder=0;
+	bool     ok=true;
+	for (int i=0;i<clipped.nbAr;i++) {
+		int    pathID=clipped.ebData[i].pathID;
+		float  tSt=clipped.ebData[i].tSt,tEn=clipped.ebData[i].tEn;
+		if ( pathID == -1 ) {
+			nbBorder++;
+		} else if ( pathID != 3 || tSt < 0 || tSt > 1 || tEn < 0 || tEn > 1 ) {
+			ok=false;
+		}
+	}
+	CHECK(ok);
+	CHECK(nbBorder > 0);
+
+	// the curves come back out of the clipped shape
+	Path     dest;
+	Path*    orig[4]={NULL,NULL,NULL,&circle};
+	clipped.ConvertToForme(&dest,4,orig);
+	CHECK(SubpathCount(&dest) == 1);
+}
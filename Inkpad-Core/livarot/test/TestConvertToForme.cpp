@@ -0,0 +1,75 @@
+/*
+ *  TestConvertToForme.cpp
+ *  nlivarot tests
+ *
+ *  Shape::ConvertToForme rebuilding the original curves from the back data
+ *
+ */
+
+#include "LivarotTest.h"
+
+static int        CountCommands(Path* p,int type)
+{
+	int      nb=0;
+	for (int i=0;i<p->descr_nb;i++) {
+		if ( ((p->descr_data+i)->flags&descr_type_mask) == type ) nb++;
+	}
+	return nb;
+}
+
+LIVAROT_TEST(ConvertToFormeRecomposesCurves)
+{
+	Path     circle,rect;
+	Shape    a,b,result;
+	CirclePath(&circle,100,100,80);
+	RectPath(&rect,100,0,300,200);
+	CHECK(FillShape(&a,&circle,0) == 0);
+	CHECK(FillShape(&b,&rect,1) == 0);
+	CHECK(result.Booleen(&a,&b,bool_op_union) == 0);
+
+	Path     dest;
+	Path*    orig[2]={&circle,&rect};
+	result.ConvertToForme(&dest,2,orig);
+	CHECK(SubpathCount(&dest) == 1);
+	// the half of the circle outside the rectangle comes back as its 2 quarter cubics
+	CHECK(CountCommands(&dest,descr_cubicto) == 2);
+	CHECK(CountCommands(&dest,descr_lineto) >= 4);
+
+	// and it encloses the same area
+	Shape    refilled;
+	CHECK(FillShape(&refilled,&dest,0) == 0);
+	CHECK_NEAR(ShapeArea(&refilled),ShapeArea(&result),ShapeArea(&result)*0.002);
+}
+
+LIVAROT_TEST(ConvertToFormeManyPaths)
+{
+	// enough paths and pieces that the index has to grow
+	const int  nbPath=64;
+	Path*    orig[nbPath];
+	Shape    a,b;
+	Shape*   acc=&a;
+	Shape*   next=&b;
+	for (int i=0;i<nbPath;i++) {
+		orig[i]=new Path;
+		CirclePath(orig[i],(i%8)*60,(i/8)*60,25+(i%3));
+		if ( i == 0 ) {
+			CHECK(FillShape(acc,orig[i],i) == 0);
+		} else {
+			// the union goes to the other shape, which then holds the result so far
+			Shape  s;
+			CHECK(FillShape(&s,orig[i],i) == 0);
+			CHECK(next->Booleen(acc,&s,bool_op_union) == 0);
+			Shape*  swap=acc;
+			acc=next;
+			next=swap;
+		}
+	}
+
+	Path     dest;
+	acc->ConvertToForme(&dest,nbPath,orig);
+	Shape    refilled;
+	CHECK(FillShape(&refilled,&dest,0) == 0);
+	CHECK_NEAR(ShapeArea(&refilled),ShapeArea(acc),ShapeArea(acc)*0.002);
+	CHECK(CountCommands(&dest,descr_cubicto) >= nbPath*2);
+	for (int i=0;i<nbPath;i++) delete orig[i];
+}
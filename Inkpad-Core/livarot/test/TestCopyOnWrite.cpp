@@ -0,0 +1,113 @@
+/*
+ *  TestCopyOnWrite.cpp
+ *  nlivarot tests
+ *
+ *  Shape::Copy and Path::Copy share their arrays until one side changes them
+ *
+ */
+
+#include "LivarotTest.h"
+
+#include <pthread.h>
+
+LIVAROT_TEST(ShapeCopySharesUntilWritten)
+{
+	Path     circle;
+	Shape    a;
+	CirclePath(&circle,100,100,80);
+	CHECK(FillShape(&a,&circle,0) == 0);
+	int      nbPt=a.nbPt,nbAr=a.nbAr;
+	double   area=ShapeArea(&a);
+
+	Shape    b;
+	b.Copy(&a);
+	CHECK(b.pts == a.pts);
+	CHECK(b.aretes == a.aretes);
+
+	// writing in the copy leaves the source alone
+	int      p=b.AddPoint(500,500);
+	b.AddEdge(p,0);
+	CHECK(b.pts != a.pts);
+	CHECK(a.nbPt == nbPt && a.nbAr == nbAr);
+	CHECK(b.nbPt == nbPt+1 && b.nbAr == nbAr+1);
+	CHECK_NEAR(ShapeArea(&a),area,1e-6);
+
+	// and the other way around
+	Shape    c;
+	c.Copy(&a);
+	a.Reset();
+	CHECK(c.nbPt == nbPt);
+	CHECK_NEAR(ShapeArea(&c),area,1e-6);
+
+	// the copy outlives its source
+	Shape*   d=new Shape;
+	Shape    e;
+	d->Copy(&c);
+	e.Copy(d);
+	delete d;
+	CHECK_NEAR(ShapeArea(&e),area,1e-6);
+
+	// and works as an operand
+	Path     rect;
+	Shape    r,result;
+	RectPath(&rect,100,0,300,200);
+	CHECK(FillShape(&r,&rect,1) == 0);
+	CHECK(result.Booleen(&e,&r,bool_op_diff) == 0);
+	CHECK_NEAR(ShapeArea(&result),area/2,area*0.01);
+	CHECK_NEAR(ShapeArea(&c),area,1e-6);
+}
+
+LIVAROT_TEST(PathCopySharesUntilWritten)
+{
+	Path     a;
+	RectPath(&a,0,0,100,100);
+	int      nbDescr=a.descr_nb;
+
+	Path     b;
+	b.Copy(&a);
+	CHECK(b.descr_data == a.descr_data);
+	b.MoveTo(200,200);
+	b.LineTo(300,200);
+	b.LineTo(300,300);
+	b.Close();
+	CHECK(b.descr_data != a.descr_data);
+	CHECK(a.descr_nb == nbDescr);
+	CHECK(SubpathCount(&a) == 1);
+	CHECK(SubpathCount(&b) == 2);
+
+	// converting the copy doesn't touch the source's description
+	Shape    s;
+	Path     c;
+	c.Copy(&a);
+	CHECK(FillShape(&s,&c,0) == 0);
+	CHECK_NEAR(ShapeArea(&s),10000,0.01);
+	CHECK(a.descr_nb == nbDescr);
+}
+
+static Shape      sharedSource;
+
+static void*      CopyAndSweep(void* res)
+{
+	for (int i=0;i<50;i++) {
+		Shape  copy,swept;
+		copy.Copy(&sharedSource);
+		swept.ConvertToShape(&copy,fill_nonZero);
+		if ( fabs(ShapeArea(&swept)-ShapeArea(&sharedSource)) > 1 ) *(int*)res=1;
+	}
+	return NULL;
+}
+
+LIVAROT_TEST(ShapeCopyFromSeveralThreads)
+{
+	// the eraser copies one converted shape from several threads at once
+	Path     circle;
+	CirclePath(&circle,100,100,80);
+	CHECK(FillShape(&sharedSource,&circle,0) == 0);
+
+	pthread_t  threads[4];
+	int        bad[4]={0,0,0,0};
+	for (int i=0;i<4;i++) pthread_create(threads+i,NULL,CopyAndSweep,bad+i);
+	for (int i=0;i<4;i++) pthread_join(threads[i],NULL);
+	for (int i=0;i<4;i++) CHECK(bad[i] == 0);
+	sharedSource.Reset();
+}
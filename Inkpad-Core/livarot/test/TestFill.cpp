@@ -0,0 +1,48 @@
+/*
+ *  TestFill.cpp
+ *  nlivarot tests
+ *
+ *  back data written by Path::Fill
+ *
+ */
+
+#include "LivarotTest.h"
+
+// every edge of the graph comes from a piece of the path, with its whole [0,1] range
+static bool       BackDataComplete(Shape* graph,Path* p,int pathID)
+{
+	if ( (graph->flags&has_back_data) == 0 ) return false;
+	for (int i=0;i<graph->nbAr;i++) {
+		if ( graph->ebData[i].pathID != pathID ) return false;
+		if ( graph->ebData[i].pieceID < 0 || graph->ebData[i].pieceID >= p->descr_nb ) return false;
+		if ( graph->ebData[i].tSt != 0.0 || graph->ebData[i].tEn != 1.0 ) return false;
+	}
+	return true;
+}
+
+LIVAROT_TEST(FillClosesSubpathsWithBackData)
+{
+	// open subpaths are closed by Fill() when the next one starts, and at the end
+	Path     p;
+	p.MoveTo(0,0);
+	p.LineTo(100,0);
+	p.LineTo(100,100);
+	p.MoveTo(200,0);
+	p.LineTo(300,0);
+	p.LineTo(300,100);
+	p.ConvertWithBackData(1);
+
+	Shape    graph;
+	p.Fill(&graph,5);
+	CHECK(graph.nbAr == 6);
+	CHECK(BackDataComplete(&graph,&p,5));
+
+	Path     closed;
+	RectPath(&closed,0,0,100,100);
+	RectPath(&closed,200,0,300,100);
+	closed.ConvertWithBackData(1);
+	graph.Reset();
+	closed.Fill(&graph,2);
+	CHECK(graph.nbAr == 8);
+	CHECK(BackDataComplete(&graph,&closed,2));
+}
@@ -0,0 +1,47 @@
+/*
+ *  TestFillShape.cpp
+ *  nlivarot tests
+ *
+ *  Shape::ConvertToShape over paths, against Fill() followed by ConvertToShape()
+ *
+ */
+
+#include "LivarotTest.h"
+
+LIVAROT_TEST(ConvertPathsMatchesFillThenConvert)
+{
+	// a compound path: a ring and a square across it
+	Path     paths[3];
+	Path*    ptrs[3]={paths,paths+1,paths+2};
+	CirclePath(paths,100,100,80);
+	CirclePath(paths+1,100,100,40);
+	RectPath(paths+2,90,-20,110,220);
+	for (int i=0;i<3;i++) paths[i].ConvertWithBackData(1);
+
+	Shape    graph,twoSteps;
+	for (int i=0;i<3;i++) paths[i].Fill(&graph,i,true);
+	CHECK(twoSteps.ConvertToShape(&graph,fill_oddEven) == 0);
+
+	Shape    oneCall,scratch;
+	CHECK(oneCall.ConvertToShape(ptrs,0,3,fill_oddEven,&scratch) == 0);
+	CHECK(oneCall.nbPt == twoSteps.nbPt);
+	CHECK(oneCall.nbAr == twoSteps.nbAr);
+	CHECK_NEAR(ShapeArea(&oneCall),ShapeArea(&twoSteps),1e-6);
+
+	// the path IDs are the indices in paths
+	bool     idsOk=true;
+	for (int i=0;i<oneCall.nbAr;i++) {
+		if ( oneCall.ebData[i].pathID < 0 || oneCall.ebData[i].pathID > 2 ) idsOk=false;
+	}
+	CHECK(idsOk);
+
+	// the scratch graph can be used again, and a NULL one works too
+	Shape    again,temporary;
+	CHECK(again.ConvertToShape(ptrs,1,2,fill_nonZero,&scratch) == 0);
+	CHECK(temporary.ConvertToShape(ptrs,1,2,fill_nonZero,NULL) == 0);
+	CHECK_NEAR(ShapeArea(&again),ShapeArea(&temporary),1e-6);
+
+	// and bad arguments are refused
+	CHECK(again.ConvertToShape(ptrs,0,0,fill_nonZero,NULL) == shape_input_err);
+	CHECK(again.ConvertToShape(ptrs,0,3,fill_nonZero,&again) == shape_input_err);
+}
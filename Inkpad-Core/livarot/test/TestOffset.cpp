@@ -0,0 +1,66 @@
+/*
+ *  TestOffset.cpp
+ *  nlivarot tests
+ *
+ *  Shape::MakeOffset and the batched ConvertToOffset
+ *
+ */
+
+#include "LivarotTest.h"
+
+LIVAROT_TEST(OffsetCircle)
+{
+	Path     circle;
+	Shape    a,raw,grown,shrunk,work;
+	CirclePath(&circle,100,100,80);
+	CHECK(FillShape(&a,&circle,0) == 0);
+
+	CHECK(raw.MakeOffset(&a,10,join_round,4.0) == 0);
+	CHECK(grown.ConvertToShape(&raw,fill_positive) == 0);
+	CHECK_NEAR(ShapeArea(&grown),M_PI*90*90,M_PI*90*90*0.01);
+
+	Shape*   of=&a;
+	CHECK(shrunk.ConvertToOffset(1,&of,-10,join_round,4.0,&work) == 0);
+	CHECK_NEAR(ShapeArea(&shrunk),M_PI*70*70,M_PI*70*70*0.01);
+}
+
+LIVAROT_TEST(OffsetBatchMatchesSingle)
+{
+	// disjoint once grown, so the batch has the area of the single offsets put together
+	Path     circles[3];
+	Shape    shapes[3];
+	Shape*   of[3];
+	double   single=0;
+	for (int i=0;i<3;i++) {
+		CirclePath(circles+i,100+300*i,100,40+20*i);
+		CHECK(FillShape(shapes+i,circles+i,i) == 0);
+		of[i]=shapes+i;
+
+		Shape  raw,grown;
+		CHECK(raw.MakeOffset(of[i],5,join_straight,4.0) == 0);
+		CHECK(grown.ConvertToShape(&raw,fill_positive) == 0);
+		single+=ShapeArea(&grown);
+	}
+
+	Shape    batch,work;
+	CHECK(batch.ConvertToOffset(3,of,5,join_straight,4.0,&work) == 0);
+	CHECK_NEAR(ShapeArea(&batch),single,single*0.001);
+}
+
+LIVAROT_TEST(OffsetEmptyInput)
+{
+	Shape    empty,raw,work;
+	Path     circle;
+	Shape    a;
+	CirclePath(&circle,100,100,80);
+	CHECK(FillShape(&a,&circle,0) == 0);
+
+	CHECK(raw.MakeOffset(&empty,10,join_round,4.0) == shape_input_err);
+	// an offset of 0 is a plain copy, of whatever it's given
+	CHECK(raw.MakeOffset(&empty,0,join_round,4.0) == 0);
+
+	Shape*   of[2]={&a,&empty};
+	Shape    batch;
+	CHECK(batch.ConvertToOffset(2,of,10,join_round,4.0,&work) == shape_input_err);
+	CHECK(batch.nbAr == 0);
+}
@@ -0,0 +1,118 @@
+/*
+ *  TestReoriente.cpp
+ *  nlivarot tests
+ *
+ *  Shape::IntersectionFree and Shape::Reoriente, against ConvertToShape
+ *
+ */
+
+#include "LivarotTest.h"
+
+// the graph of p, as Fill() makes it, before any sweep
+static void       FillGraph(Shape* dest,Path* p,int pathID)
+{
+	p->ConvertWithBackData(1);
+	p->Fill(dest,pathID);
+}
+
+// reorients the graph of p and checks it against the sweep
+static void       CheckReoriente(Path* p)
+{
+	Shape    graph,oriented,swept;
+	FillGraph(&graph,p,0);
+	CHECK(graph.IntersectionFree());
+
+	FillGraph(&graph,p,0);
+	CHECK(oriented.Reoriente(&graph) == 0);
+	CHECK(oriented.type == shape_polygon);
+	CHECK(oriented.flags&has_back_data);
+
+	FillGraph(&graph,p,0);
+	CHECK(swept.ConvertToShape(&graph,fill_nonZero) == 0);
+	CHECK_NEAR(ShapeArea(&oriented),ShapeArea(&swept),1.0);
+
+	// both orientations of the edges give the same polygon
+	Shape    reversed,orientedBack;
+	FillGraph(&reversed,p,0);
+	for (int i=0;i<reversed.nbAr;i++) reversed.Inverse(i);
+	CHECK(orientedBack.Reoriente(&reversed) == 0);
+	CHECK_NEAR(ShapeArea(&orientedBack),ShapeArea(&oriented),1.0);
+}
+
+LIVAROT_TEST(ReorienteSimpleContours)
+{
+	Path     rect,circle;
+	RectPath(&rect,10,10,200,120);
+	CirclePath(&circle,100,100,80);
+	CheckReoriente(&rect);
+	CheckReoriente(&circle);
+}
+
+LIVAROT_TEST(IntersectionFreeRejectsCrossings)
+{
+	Shape    graph;
+
+	// a bow tie
+	Path     bowTie;
+	bowTie.MoveTo(0,0);
+	bowTie.LineTo(100,100);
+	bowTie.LineTo(100,0);
+	bowTie.LineTo(0,100);
+	bowTie.Close();
+	FillGraph(&graph,&bowTie,0);
+	CHECK(graph.IntersectionFree() == false);
+
+	// two overlapping contours
+	Path     twoRects;
+	RectPath(&twoRects,0,0,100,100);
+	RectPath(&twoRects,50,50,150,150);
+	FillGraph(&graph,&twoRects,0);
+	CHECK(graph.IntersectionFree() == false);
+
+	// a vertex touching the middle of an edge
+	Path     touching;
+	touching.MoveTo(0,0);
+	touching.LineTo(100,0);
+	touching.LineTo(100,100);
+	touching.LineTo(50,0);
+	touching.LineTo(0,100);
+	touching.Close();
+	FillGraph(&graph,&touching,0);
+	CHECK(graph.IntersectionFree() == false);
+
+	// two disjoint contours are fine
+	Path     apart;
+	RectPath(&apart,0,0,100,100);
+	RectPath(&apart,200,0,300,100);
+	FillGraph(&graph,&apart,0);
+	CHECK(graph.IntersectionFree());
+}
+
+LIVAROT_TEST(IntersectionFreeKnownSimple)
+{
+	Path     bowTie;
+	Shape    graph;
+	bowTie.MoveTo(0,0);
+	bowTie.LineTo(100,100);
+	bowTie.LineTo(100,0);
+	bowTie.LineTo(0,100);
+	bowTie.Close();
+
+	// the provenance flag is trusted, and Reset() clears it
+	FillGraph(&graph,&bowTie,0);
+	graph.SetKnownSimple(true);
+	CHECK(graph.IntersectionFree());
+	graph.Reset();
+	CHECK(graph.IsKnownSimple() == false);
+
+	// but an edge collapsing on the rounding grid is always caught
+	Path     tiny;
+	tiny.MoveTo(0,0);
+	tiny.LineTo(100,0);
+	tiny.LineTo(100,0.001f);
+	tiny.LineTo(0,100);
+	tiny.Close();
+	FillGraph(&graph,&tiny,0);
+	graph.SetKnownSimple(true);
+	CHECK(graph.IntersectionFree() == false);
+}
@@ -0,0 +1,88 @@
+/*
+ *  TestSortEdges.cpp
+ *  nlivarot tests
+ *
+ *  Shape::SortEdges, against the angles of the edges
+ *
+ */
+
+#include "LivarotTest.h"
+
+#include <stdlib.h>
+
+// the angle of the direction (x,y) in the order the edges go around a point: from (0,-1) towards (1,0)
+static double     TurnAngle(double x,double y)
+{
+	double   a=atan2(x,-y);
+	return ( a < 0 )?a+2*M_PI:a;
+}
+
+// makes a hub of nb edges around a point, half of them going in, and checks the order SortEdges gives them
+static void       CheckHub(int nb,bool withTies)
+{
+	Shape    s;
+	int      hub=s.AddPoint(0,0);
+	for (int i=0;i<nb;i++) {
+		float  x,y;
+		if ( withTies && i%3 == 2 ) {
+			// same direction as an earlier edge, further away
+			int  j=i-1-(rand()%2);
+			x=2*(s.pts[s.aretes[j].st == hub ? s.aretes[j].en : s.aretes[j].st].x);
+			y=2*(s.pts[s.aretes[j].st == hub ? s.aretes[j].en : s.aretes[j].st].y);
+		} else {
+			x=(float)(rand()%2001-1000);
+			y=(float)(rand()%2001-1000);
+			if ( x == 0 && y == 0 ) x=1;
+		}
+		int  p=s.AddPoint(x,y);
+		if ( i%2 == 0 ) s.AddEdge(hub,p); else s.AddEdge(p,hub);
+	}
+	s.SortEdges();
+
+	int      seen=0;
+	bool     sorted=true;
+	double   last=-1;
+	for (int b=s.pts[hub].firstA;b >= 0;b=s.NextAt(hub,b)) {
+		int     other=(s.aretes[b].st == hub)?s.aretes[b].en:s.aretes[b].st;
+		double  a=TurnAngle(s.pts[other].x,s.pts[other].y);
+		if ( a < last-1e-12 ) sorted=false;
+		last=a;
+		seen++;
+	}
+	CHECK(seen == nb);
+	CHECK(sorted);
+}
+
+LIVAROT_TEST(SortEdgesFollowsAngles)
+{
+	srand(38);
+	// 2 edges, the insertion sort and the radix sort
+	for (int n=0;n<20;n++) CheckHub(2,false);
+	for (int n=0;n<20;n++) CheckHub(3+n%14,false);
+	for (int n=0;n<10;n++) CheckHub(17+n*200,false);
+}
+
+LIVAROT_TEST(SortEdgesTies)
+{
+	srand(380);
+	for (int n=0;n<20;n++) CheckHub(3+n%14,true);
+	for (int n=0;n<10;n++) CheckHub(17+n*200,true);
+}
+
+LIVAROT_TEST(SortEdgesAxes)
+{
+	// the 4 axis directions and the diagonals, where the key changes quadrant
+	Shape    s;
+	int      hub=s.AddPoint(0,0);
+	float    dirs[8][2]={{-1,-1},{0,1},{1,0},{-1,0},{1,1},{0,-1},{1,-1},{-1,1}};
+	for (int i=0;i<8;i++) s.AddEdge(hub,s.AddPoint(dirs[i][0],dirs[i][1]));
+	s.SortEdges();
+	double   last=-1;
+	bool     sorted=true;
+	for (int b=s.pts[hub].firstA;b >= 0;b=s.NextAt(hub,b)) {
+		double  a=TurnAngle(s.aretes[b].dx,s.aretes[b].dy);
+		if ( a <= last ) sorted=false;
+		last=a;
+	}
+	CHECK(sorted);
+}
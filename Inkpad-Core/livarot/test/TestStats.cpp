@@ -0,0 +1,58 @@
+/*
+ *  TestStats.cpp
+ *  nlivarot tests
+ *
+ *  LivarotStats, with livarot driven from several threads at once (only in a LIVAROT_STATS=1 build)
+ *
+ */
+
+#include "LivarotTest.h"
+#include "LivarotStats.h"
+
+#if LIVAROT_STATS
+
+#include <pthread.h>
+
+#define kStatsThreads    4
+#define kStatsRuns       50
+
+static void*      SweepCircles(void*)
+{
+	Path     circle;
+	CirclePath(&circle,100,100,80);
+	for (int i=0;i<kStatsRuns;i++) {
+		Shape  a;
+		FillShape(&a,&circle,0);
+	}
+	return NULL;
+}
+
+LIVAROT_TEST(StatsCountsOneThread)
+{
+	LivarotStats::Reset();
+	SweepCircles(NULL);
+	CHECK(LivarotStats::PhaseCalls(stat_convert_to_shape) == kStatsRuns);
+	CHECK(LivarotStats::PhaseCalls(stat_sweep) == kStatsRuns);
+	CHECK(LivarotStats::Counter(stat_sweep_points) > 0);
+	CHECK(LivarotStats::Counter(stat_sweep_points)%kStatsRuns == 0);
+}
+
+LIVAROT_TEST(StatsCountsSeveralThreads)
+{
+	// the same work on each thread: every phase and every point is counted once
+	LivarotStats::Reset();
+	SweepCircles(NULL);
+	long long  points=LivarotStats::Counter(stat_sweep_points);
+
+	LivarotStats::Reset();
+	LivarotStats::SetTracing(true);
+	pthread_t  threads[kStatsThreads];
+	for (int i=0;i<kStatsThreads;i++) pthread_create(threads+i,NULL,SweepCircles,NULL);
+	for (int i=0;i<kStatsThreads;i++) pthread_join(threads[i],NULL);
+	CHECK(LivarotStats::PhaseCalls(stat_convert_to_shape) == kStatsThreads*kStatsRuns);
+	CHECK(LivarotStats::Counter(stat_sweep_points) == kStatsThreads*points);
+	CHECK(LivarotStats::WriteTrace("/dev/null") == 0);
+	LivarotStats::SetTracing(false);
+}
+
+#endif
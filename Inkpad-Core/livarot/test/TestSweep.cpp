@@ -0,0 +1,63 @@
+/*
+ *  TestSweep.cpp
+ *  nlivarot tests
+ *
+ *  the polygons coming out of the sweep, on inputs where points land on other edges
+ *
+ */
+
+#include "LivarotTest.h"
+
+#include <stdlib.h>
+
+static bool       HasPoint(Shape* s,float x,float y)
+{
+	for (int i=0;i<s->nbPt;i++) {
+		if ( s->pts[i].x == x && s->pts[i].y == y ) return true;
+	}
+	return false;
+}
+
+LIVAROT_TEST(SweepSplitsEdgesAtPoints)
+{
+	// the corners of the small rectangle lie on the right edge of the big one
+	Path     big,small;
+	Shape    a,b,result;
+	RectPath(&big,0,0,100,100);
+	RectPath(&small,100,25,200,75);
+	CHECK(FillShape(&a,&big,0) == 0);
+	CHECK(FillShape(&b,&small,1) == 0);
+	CHECK(result.Booleen(&a,&b,bool_op_union) == 0);
+	CHECK_NEAR(ShapeArea(&result),15000,0.01);
+	CHECK(HasPoint(&result,100,25));
+	CHECK(HasPoint(&result,100,75));
+	CHECK(result.Eulerian(true));
+}
+
+LIVAROT_TEST(SweepResultIsSimple)
+{
+	// star bursts drawn in one stroke cross themselves everywhere; what comes out must not
+	srand(34);
+	for (int n=0;n<20;n++) {
+		Path     star;
+		float    cx=500,cy=500,r=400;
+		int      nbSpike=5+n;
+		for (int j=0;j<nbSpike;j++) {
+			float  a=6.2831853f*j/nbSpike+0.01f*((float)rand()/RAND_MAX);
+			float  x=cx+r*cos(a),y=cy+r*sin(a);
+			if ( j == 0 ) star.MoveTo(x,y); else star.LineTo(x,y);
+			a+=3.1415926f*(1.0f-1.0f/nbSpike);
+			star.LineTo(cx+0.3f*r*cos(a),cy+0.3f*r*sin(a));
+		}
+		star.Close();
+
+		Shape    nonZero,oddEven;
+		CHECK(FillShape(&nonZero,&star,0,fill_nonZero) == 0);
+		CHECK(FillShape(&oddEven,&star,0,fill_oddEven) == 0);
+		CHECK(nonZero.Eulerian(true));
+		CHECK(nonZero.IntersectionFree());
+		CHECK(oddEven.IntersectionFree());
+		// odd-even leaves out the parts covered twice, if any
+		CHECK(ShapeArea(&oddEven) <= ShapeArea(&nonZero)+0.01);
+	}
+}